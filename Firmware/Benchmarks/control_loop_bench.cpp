@@ -0,0 +1,618 @@
+/*
+* @brief Microbenchmarks of the functions that run in every control loop
+* iteration.
+*
+* The firmware is built for the host against the simulated board (see
+* Simulator/). Before any measurement, axis0 is calibrated and spun up in the
+* simulator. This way the benchmarked objects are fully wired and hold
+* realistic state. Each benchmark then calls a single function in a tight loop.
+*
+* Every benchmark is measured in several runs of many iterations each. The
+* median over all runs is the headline number and the spread across runs is
+* reported next to it. The results are printed as a table on stderr and can
+* be written as JSON with --json. If a baseline JSON file from an earlier run is
+* passed with --baseline, the program exits with a non-zero status when any
+* benchmark got slower than the tolerance allows.
+*
+* Note that the numbers are host nanoseconds, not Cortex-M4 cycles. They are
+* meant to catch relative regressions before they reach a board, not to
+* predict absolute timing on the target.
+*
+* Usage:
+*   control_loop_bench [--runs N] [--iterations N] [--filter SUBSTRING]
+*                      [--json FILE] [--baseline FILE] [--tolerance RATIO]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <odrive_main.h>
+#include <sincos.hpp>
+#include <svm.hpp>
+#include <utils.hpp>
+
+#include "../Simulator/simulator.hpp"
+
+struct Benchmark {
+    std::string name;
+    std::function<void()> setup; // called before every run, not timed
+    std::function<void(size_t)> run; // calls the function under test n times
+    std::function<bool()> check; // returns false if the function under test failed
+};
+
+struct Result {
+    std::string name;
+    double median; // [ns/call]
+    double mean; // [ns/call]
+    double stddev; // [ns/call] across runs
+    double min; // [ns/call]
+    double max; // [ns/call]
+    bool valid;
+};
+
+struct Options {
+    size_t runs = 15;
+    size_t iterations = 20000;
+    const char* filter = nullptr;
+    const char* json_file = nullptr;
+    const char* baseline_file = nullptr;
+    float tolerance = 0.25f; // allowed relative slowdown
+    float abs_tolerance = 2.0f; // [ns] slowdowns below this are never reported
+};
+
+static volatile float sink; // keeps results of pure functions alive
+
+static Result measure(const Benchmark& bench, const Options& options) {
+    std::vector<double> samples;
+    bool valid = true;
+
+    // Warm up caches and branch predictors
+    bench.setup();
+    bench.run(options.iterations / 10);
+
+    for (size_t i = 0; i < options.runs; ++i) {
+        bench.setup();
+        auto start = std::chrono::steady_clock::now();
+        bench.run(options.iterations);
+        auto end = std::chrono::steady_clock::now();
+        valid = valid && (!bench.check || bench.check());
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / (double)options.iterations);
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples) {
+        sum += s;
+    }
+    double mean = sum / (double)samples.size();
+    double var = 0.0;
+    for (double s : samples) {
+        var += (s - mean) * (s - mean);
+    }
+    var /= (double)std::max<size_t>(samples.size() - 1, 1);
+
+    size_t n = samples.size();
+    double median = (n % 2) ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    return {bench.name, median, mean, std::sqrt(var), samples.front(), samples.back(), valid};
+}
+
+// Benchmarks ----------------------------------------------------------------------
+
+static std::vector<Benchmark> make_controller_benchmarks() {
+    struct ModeCombination {
+        const char* name;
+        Controller::ControlMode control_mode;
+        Controller::InputMode input_mode;
+        bool anticogging = false;
+        bool filters = false;
+    };
+    static const ModeCombination combinations[] = {
+        {"TORQUE/INACTIVE", Controller::CONTROL_MODE_TORQUE_CONTROL, Controller::INPUT_MODE_INACTIVE},
+        {"TORQUE/PASSTHROUGH", Controller::CONTROL_MODE_TORQUE_CONTROL, Controller::INPUT_MODE_PASSTHROUGH},
+        {"TORQUE/TORQUE_RAMP", Controller::CONTROL_MODE_TORQUE_CONTROL, Controller::INPUT_MODE_TORQUE_RAMP},
+        {"VELOCITY/PASSTHROUGH", Controller::CONTROL_MODE_VELOCITY_CONTROL, Controller::INPUT_MODE_PASSTHROUGH},
+        {"VELOCITY/VEL_RAMP", Controller::CONTROL_MODE_VELOCITY_CONTROL, Controller::INPUT_MODE_VEL_RAMP},
+        {"VELOCITY/PASSTHROUGH+ANTICOGGING", Controller::CONTROL_MODE_VELOCITY_CONTROL, Controller::INPUT_MODE_PASSTHROUGH, true},
+        {"VELOCITY/PASSTHROUGH+FILTERS", Controller::CONTROL_MODE_VELOCITY_CONTROL, Controller::INPUT_MODE_PASSTHROUGH, false, true},
+        {"POSITION/PASSTHROUGH", Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_PASSTHROUGH},
+        {"POSITION/POS_FILTER", Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_POS_FILTER},
+        {"POSITION/TRAP_TRAJ", Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_TRAP_TRAJ},
+        {"POSITION/SCURVE_TRAJ", Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_SCURVE_TRAJ},
+        {"POSITION/PVT", Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_PVT},
+        {"POSITION/MIRROR", Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_MIRROR},
+        {"POSITION/TUNING", Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_TUNING},
+    };
+
+    Controller& controller = axes[0].controller_;
+    static Controller::Config_t saved_config = controller.config_;
+    static float saved_vel_integrator = controller.vel_integrator_torque_;
+
+    std::vector<Benchmark> benchmarks;
+    for (const ModeCombination& combination : combinations) {
+        benchmarks.push_back({
+            std::string("Controller::update/") + combination.name,
+            [&controller, combination] {
+                controller.config_ = saved_config;
+                controller.config_.control_mode = combination.control_mode;
+                controller.config_.input_mode = combination.input_mode;
+                controller.config_.axis_to_mirror = 1;
+                controller.config_.enable_overspeed_error = false;
+                controller.vel_integrator_torque_ = saved_vel_integrator;
+                controller.mechanical_power_ = 0.0f;
+                controller.electrical_power_ = 0.0f;
+                controller.autotuning_ = {10.0f, 0.1f, 1.0f, 0.01f};
+                controller.input_pos_ = *axes[0].encoder_.pos_estimate_.present() + 1000.0f;
+                controller.input_vel_ = 5.0f;
+                controller.input_torque_ = 0.01f;
+                controller.trajectory_done_ = true;
+                controller.input_pos_updated();
+                controller.anticogging_valid_ = combination.anticogging;
+                if (combination.filters) {
+                    // All torque sections and two velocity sections
+                    for (auto& section : controller.config_.torque_filters) {
+                        section.type = Controller::FILTER_TYPE_NOTCH;
+                    }
+                    controller.config_.vel_estimate_filters[0].type = Controller::FILTER_TYPE_LOW_PASS;
+                    controller.config_.vel_estimate_filters[1].type = Controller::FILTER_TYPE_LEAD_LAG;
+                }
+                controller.update_biquad_filters();
+                if (combination.input_mode == Controller::INPUT_MODE_PVT) {
+                    // A full buffer of 50 ms segments lasts longer than a run
+                    // with the default number of iterations, so every update
+                    // evaluates the spline.
+                    controller.clear_pvt_buffer();
+                    controller.update(); // applies the clear
+                    float pos = controller.pos_setpoint_.to_float();
+                    for (size_t i = 1; i <= PvtBuffer::kCapacity; ++i) {
+                        float phase = 2.0f * (float)M_PI * 0.05f * (float)i;
+                        controller.push_pvt_point(pos + std::sin(phase), 2.0f * (float)M_PI * std::cos(phase), 0.05f);
+                    }
+                }
+                controller.error_ = Controller::ERROR_NONE;
+            },
+            [&controller](size_t n) {
+                for (size_t i = 0; i < n; ++i) {
+                    controller.update();
+                }
+            },
+            [&controller] { return controller.error_ == Controller::ERROR_NONE; }
+        });
+    }
+    return benchmarks;
+}
+
+static std::vector<Benchmark> make_encoder_benchmarks() {
+    struct ModeInfo {
+        const char* name;
+        Encoder::Mode mode;
+        int32_t cpr;
+        Encoder::Estimator estimator = Encoder::ESTIMATOR_PLL;
+        bool error_map = false;
+    };
+    static const ModeInfo modes[] = {
+        {"INCREMENTAL", Encoder::MODE_INCREMENTAL, 8192},
+        {"HALL", Encoder::MODE_HALL, 6 * 7},
+        {"INCREMENTAL_KALMAN", Encoder::MODE_INCREMENTAL, 8192, Encoder::ESTIMATOR_KALMAN},
+        {"HALL_KALMAN", Encoder::MODE_HALL, 6 * 7, Encoder::ESTIMATOR_KALMAN},
+        {"HALL_EDGE_TIMING", Encoder::MODE_HALL, 6 * 7, Encoder::ESTIMATOR_EDGE_TIMING},
+        {"SINCOS", Encoder::MODE_SINCOS, 6283},
+        {"SPI_ABS_CUI", Encoder::MODE_SPI_ABS_CUI, 16384},
+        {"SPI_ABS_AMS", Encoder::MODE_SPI_ABS_AMS, 16384},
+        {"SPI_ABS_AMS_ERROR_MAP", Encoder::MODE_SPI_ABS_AMS, 16384, Encoder::ESTIMATOR_PLL, true},
+        {"SPI_ABS_AEAT", Encoder::MODE_SPI_ABS_AEAT, 16384},
+        {"SPI_ABS_RLS", Encoder::MODE_SPI_ABS_RLS, 16384},
+        {"SPI_ABS_MA732", Encoder::MODE_SPI_ABS_MA732, 16384},
+        {"SPI_ABS_SSI", Encoder::MODE_SPI_ABS_SSI, 1 << 18},
+        {"SPI_ABS_BISS_C", Encoder::MODE_SPI_ABS_BISS_C, 1 << 24},
+    };
+
+    // The encoder of the idle axis is used so that the closed loop state of
+    // axis0 is not disturbed.
+    Encoder& encoder = axes[1].encoder_;
+
+    // Hall states in the order of a forward rotation (see decode_hall())
+    static const uint8_t hall_sequence[6] = {0b001, 0b011, 0b010, 0b110, 0b100, 0b101};
+
+    std::vector<Benchmark> benchmarks;
+    for (const ModeInfo& info : modes) {
+        benchmarks.push_back({
+            std::string("Encoder::update/") + info.name,
+            [&encoder, info] {
+                encoder.config_.mode = info.mode;
+                encoder.config_.cpr = info.cpr;
+                encoder.config_.hall_polarity_calibrated = true;
+                encoder.config_.hall_polarity = 0;
+                encoder.config_.enable_phase_interpolation = true;
+                encoder.mode_ = info.mode;
+                encoder.is_ready_ = true;
+                encoder.config_.direction = 1;
+                encoder.config_.estimator = info.estimator;
+                encoder.update_pll_gains();
+                encoder.update_kalman_gains();
+                encoder.update_edge_timing();
+                encoder.config_.error_map_calibrated = info.error_map;
+                for (uint32_t i = 0; i < EncoderErrorMap::kBins; ++i) {
+                    encoder.config_.error_map.set(i, 0.002f * std::sin(2.0f * (float)M_PI * (float)i / (float)EncoderErrorMap::kBins));
+                }
+                encoder.spi_error_rate_ = 0.0f;
+                encoder.error_ = Encoder::ERROR_NONE;
+            },
+            [&encoder, info](size_t n) {
+                // Feed the encoder with a rotation of about 10 turn/s
+                for (size_t i = 0; i < n; ++i) {
+                    switch (info.mode) {
+                        case Encoder::MODE_INCREMENTAL: {
+                            encoder.tim_cnt_sample_ = (int16_t)(i * 10);
+                        } break;
+                        case Encoder::MODE_HALL: {
+                            uint8_t hall_state = hall_sequence[(i / 4) % 6];
+                            encoder.port_samples_[1] = ((hall_state & 1) ? encoder.hallA_gpio_.pin_mask_ : 0)
+                                                     | ((hall_state & 2) ? encoder.hallB_gpio_.pin_mask_ : 0);
+                            encoder.port_samples_[2] = (hall_state & 4) ? encoder.hallC_gpio_.pin_mask_ : 0;
+                        } break;
+                        case Encoder::MODE_SINCOS: {
+                            float phase = (float)(i % 100) * (2.0f * (float)M_PI / 100.0f);
+                            encoder.sincos_sample_s_ = 0.4f * our_arm_sin_f32(phase);
+                            encoder.sincos_sample_c_ = 0.4f * our_arm_cos_f32(phase);
+                        } break;
+                        default: {
+                            encoder.pos_abs_ = (int32_t)((i * 20) % info.cpr);
+                            encoder.abs_spi_pos_updated_ = true;
+                        } break;
+                    }
+                    encoder.update();
+                }
+            },
+            [&encoder] { return encoder.error_ == Encoder::ERROR_NONE; }
+        });
+    }
+    return benchmarks;
+}
+
+static std::vector<Benchmark> make_misc_benchmarks() {
+    std::vector<Benchmark> benchmarks;
+    Motor& motor = axes[0].motor_;
+
+    struct CurrentControlLawInfo {
+        const char* suffix;
+        Motor::CurrentControlLaw law;
+        bool dead_time_compensation;
+    };
+    static const CurrentControlLawInfo laws[] = {
+        {"", Motor::CURRENT_CONTROL_LAW_PI, false},
+        {"/DEADBEAT", Motor::CURRENT_CONTROL_LAW_DEADBEAT, false},
+        {"/DEADTIME", Motor::CURRENT_CONTROL_LAW_PI, true},
+    };
+
+    static FieldOrientedController saved_foc = motor.current_control_;
+    for (const CurrentControlLawInfo& info : laws) {
+        benchmarks.push_back({
+            std::string("FieldOrientedController::get_alpha_beta_output") + info.suffix,
+            [&motor, info] {
+                motor.current_control_.v_current_control_integral_d_ = saved_foc.v_current_control_integral_d_;
+                motor.current_control_.v_current_control_integral_q_ = saved_foc.v_current_control_integral_q_;
+                motor.current_control_.I_predicted_alpha_beta_ = saved_foc.Ialpha_beta_measured_;
+                motor.current_control_.current_control_law_ = info.law;
+                motor.current_control_.dead_time_compensation_ = std::nullopt;
+                if (info.dead_time_compensation) {
+                    motor.current_control_.dead_time_compensation_ = DeadTimeCompensation{0.3f, 0.3f};
+                }
+            },
+            [&motor](size_t n) {
+                FieldOrientedController& foc = motor.current_control_;
+                std::optional<float2D> mod_alpha_beta;
+                std::optional<float> ibus;
+                for (size_t i = 0; i < n; ++i) {
+                    foc.get_alpha_beta_output(foc.ctrl_timestamp_ + TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1) * 3, &mod_alpha_beta, &ibus);
+                }
+                sink = mod_alpha_beta.has_value() ? mod_alpha_beta->first : 0.0f;
+            },
+            nullptr
+        });
+    }
+
+    // Modulation vectors covering all six sectors
+    static float2D svm_inputs[256];
+    for (size_t i = 0; i < 256; ++i) {
+        float phase = (float)i * (2.0f * (float)M_PI / 256.0f);
+        svm_inputs[i] = {0.5f * std::cos(phase), 0.5f * std::sin(phase)};
+    }
+
+    benchmarks.push_back({
+        "SVM",
+        [] {},
+        [](size_t n) {
+            float acc = 0.0f;
+            for (size_t i = 0; i < n; ++i) {
+                auto [tA, tB, tC, success] = SVM(svm_inputs[i & 0xff].first, svm_inputs[i & 0xff].second);
+                acc += tA + tB + tC;
+            }
+            sink = acc;
+        },
+        nullptr
+    });
+
+    benchmarks.push_back({
+        "SVM/DPWM2",
+        [] {},
+        [](size_t n) {
+            float acc = 0.0f;
+            for (size_t i = 0; i < n; ++i) {
+                auto [tA, tB, tC, success] = SVM(svm_inputs[i & 0xff].first, svm_inputs[i & 0xff].second, SVM_MODE_DPWM2, 0b110);
+                acc += tA + tB + tC;
+            }
+            sink = acc;
+        },
+        nullptr
+    });
+
+    // Angles covering a few electrical revolutions
+    static float angles[256];
+    for (size_t i = 0; i < 256; ++i) {
+        angles[i] = (float)i * 0.1f - 12.8f;
+    }
+
+    benchmarks.push_back({
+        "our_arm_sin_f32+our_arm_cos_f32",
+        [] {},
+        [](size_t n) {
+            float acc = 0.0f;
+            for (size_t i = 0; i < n; ++i) {
+                acc += our_arm_sin_f32(angles[i & 0xff]) + our_arm_cos_f32(angles[i & 0xff]);
+            }
+            sink = acc;
+        },
+        nullptr
+    });
+
+    benchmarks.push_back({
+        "fast_sincos",
+        [] {},
+        [](size_t n) {
+            float acc = 0.0f;
+            for (size_t i = 0; i < n; ++i) {
+                auto [s, c] = fast_sincos(angles[i & 0xff]);
+                acc += s + c;
+            }
+            sink = acc;
+        },
+        nullptr
+    });
+
+    benchmarks.push_back({
+        "sincos_rotate",
+        [] {},
+        [](size_t n) {
+            std::pair<float, float> sincos_x = fast_sincos(0.3f);
+            float acc = 0.0f;
+            for (size_t i = 0; i < n; ++i) {
+                auto [s, c] = sincos_rotate(sincos_x, 0.3f, angles[i & 0xff] * 0.03f);
+                acc += s + c;
+            }
+            sink = acc;
+        },
+        nullptr
+    });
+
+    SensorlessEstimator& sensorless = axes[0].sensorless_estimator_;
+    static SensorlessEstimator saved_sensorless = sensorless;
+    benchmarks.push_back({
+        "SensorlessEstimator::update",
+        [&sensorless] {
+            sensorless.pll_pos_ = saved_sensorless.pll_pos_;
+            sensorless.vel_estimate_ = saved_sensorless.vel_estimate_;
+            sensorless.error_ = SensorlessEstimator::ERROR_NONE;
+        },
+        [&sensorless](size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                sensorless.update();
+            }
+        },
+        [&sensorless] { return sensorless.error_ == SensorlessEstimator::ERROR_NONE; }
+    });
+
+    AcimEstimator& acim = axes[0].acim_estimator_;
+    benchmarks.push_back({
+        "AcimEstimator::update",
+        [&acim] { acim.active_ = false; },
+        [&acim](size_t n) {
+            uint32_t timestamp = acim.last_timestamp_;
+            for (size_t i = 0; i < n; ++i) {
+                timestamp += 2 * TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1);
+                acim.update(timestamp);
+            }
+        },
+        nullptr
+    });
+
+    ThermistorCurrentLimiter& thermistor = motor.fet_thermistor_;
+    benchmarks.push_back({
+        "ThermistorCurrentLimiter::update",
+        [] {},
+        [&thermistor](size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                thermistor.update(current_meas_period);
+            }
+        },
+        nullptr
+    });
+
+    return benchmarks;
+}
+
+// Simulation setup ------------------------------------------------------------------
+
+// Calibrates axis0 and lets it spin in closed loop velocity control such that
+// all objects hold realistic state.
+static bool prepare_axis(Simulator& sim) {
+    Axis& axis = axes[0];
+    axis.motor_.config_.pole_pairs = sim.plants_[0].config_.pole_pairs;
+    axis.motor_.config_.torque_constant = sim.plants_[0].config_.torque_constant;
+    axis.encoder_.config_.cpr = sim.plants_[0].config_.encoder_cpr;
+    axis.controller_.config_.vel_limit = 20.0f;
+    odrv.config_.dc_max_negative_current = -INFINITY;
+
+    if (!sim.boot()) {
+        return false;
+    }
+
+    axis.requested_state_ = Axis::AXIS_STATE_FULL_CALIBRATION_SEQUENCE;
+    sim.run_for(0.1f);
+    sim.run_until([&] { return axis.current_state_ == Axis::AXIS_STATE_IDLE; }, 30.0f);
+    if (axis.error_ != Axis::ERROR_NONE) {
+        return false;
+    }
+
+    axis.controller_.config_.control_mode = Controller::CONTROL_MODE_VELOCITY_CONTROL;
+    axis.controller_.config_.input_mode = Controller::INPUT_MODE_PASSTHROUGH;
+    axis.controller_.input_vel_ = 5.0f;
+    axis.requested_state_ = Axis::AXIS_STATE_CLOSED_LOOP_CONTROL;
+    sim.run_for(0.5f);
+    return axis.current_state_ == Axis::AXIS_STATE_CLOSED_LOOP_CONTROL && axis.error_ == Axis::ERROR_NONE;
+}
+
+// Output --------------------------------------------------------------------------
+
+static bool write_json(const char* file_name, const std::vector<Result>& results, const Options& options) {
+    FILE* fp = fopen(file_name, "w");
+    if (!fp) {
+        perror("fopen");
+        return false;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"unit\": \"ns/call\",\n");
+    fprintf(fp, "  \"runs\": %zu,\n", options.runs);
+    fprintf(fp, "  \"iterations\": %zu,\n", options.iterations);
+    fprintf(fp, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        // One benchmark per line so that the file can be parsed line by line
+        // (see load_baseline())
+        fprintf(fp, "    {\"name\": \"%s\", \"median\": %.3f, \"mean\": %.3f, \"stddev\": %.3f, \"min\": %.3f, \"max\": %.3f, \"valid\": %s}%s\n",
+                r.name.c_str(), r.median, r.mean, r.stddev, r.min, r.max,
+                r.valid ? "true" : "false", (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(fp, "  ]\n");
+    fprintf(fp, "}\n");
+    fclose(fp);
+    return true;
+}
+
+// Reads the median of each benchmark from a file written by write_json().
+static bool load_baseline(const char* file_name, std::map<std::string, double>* baseline) {
+    FILE* fp = fopen(file_name, "r");
+    if (!fp) {
+        perror("fopen");
+        return false;
+    }
+    char line[512];
+    char name[256];
+    double median;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, " {\"name\": \"%255[^\"]\", \"median\": %lf", name, &median) == 2) {
+            (*baseline)[name] = median;
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+static void print_usage(const char* name) {
+    fprintf(stderr, "usage: %s [--runs N] [--iterations N] [--filter SUBSTRING] "
+                    "[--json FILE] [--baseline FILE] [--tolerance RATIO]\n", name);
+}
+
+static bool parse_args(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!val) {
+            return false;
+        } else if (!strcmp(arg, "--runs")) {
+            options->runs = std::max(1L, strtol(val, nullptr, 10));
+        } else if (!strcmp(arg, "--iterations")) {
+            options->iterations = std::max(10L, strtol(val, nullptr, 10));
+        } else if (!strcmp(arg, "--filter")) {
+            options->filter = val;
+        } else if (!strcmp(arg, "--json")) {
+            options->json_file = val;
+        } else if (!strcmp(arg, "--baseline")) {
+            options->baseline_file = val;
+        } else if (!strcmp(arg, "--tolerance")) {
+            options->tolerance = strtof(val, nullptr);
+        } else {
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_args(argc, argv, &options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::map<std::string, double> baseline;
+    if (options.baseline_file && !load_baseline(options.baseline_file, &baseline)) {
+        return 1;
+    }
+
+    Simulator sim{Simulator::Config_t{}};
+    if (!prepare_axis(sim)) {
+        fprintf(stderr, "failed to bring up the simulated axis\n");
+        return 1;
+    }
+
+    std::vector<Benchmark> benchmarks;
+    for (auto& list : {make_controller_benchmarks(), make_encoder_benchmarks(), make_misc_benchmarks()}) {
+        benchmarks.insert(benchmarks.end(), list.begin(), list.end());
+    }
+
+    std::vector<Result> results;
+    bool regression = false;
+
+    fprintf(stderr, "%-56s %10s %10s %8s %10s\n", "benchmark", "median", "min", "cv", "baseline");
+    for (const Benchmark& bench : benchmarks) {
+        if (options.filter && !strstr(bench.name.c_str(), options.filter)) {
+            continue;
+        }
+
+        Result result = measure(bench, options);
+        results.push_back(result);
+
+        char baseline_str[32] = "-";
+        auto it = baseline.find(result.name);
+        if (it != baseline.end()) {
+            bool slower = (result.median > it->second * (1.0 + options.tolerance))
+                       && (result.median > it->second + options.abs_tolerance);
+            regression = regression || slower;
+            snprintf(baseline_str, sizeof(baseline_str), "%.1f%s", it->second, slower ? " SLOWER" : "");
+        }
+
+        fprintf(stderr, "%-56s %7.1f ns %7.1f ns %7.1f%% %10s%s\n",
+                result.name.c_str(), result.median, result.min,
+                100.0 * result.stddev / result.mean, baseline_str,
+                result.valid ? "" : " (function reported an error)");
+    }
+
+    if (options.json_file && !write_json(options.json_file, results, options)) {
+        return 1;
+    }
+
+    if (regression) {
+        fprintf(stderr, "performance regression detected (tolerance %.0f%%)\n", 100.0f * options.tolerance);
+        return 2;
+    }
+    return 0;
+}
@@ -109,13 +109,18 @@ extern UART_HandleTypeDef* uart_c;
 extern PwmInput pwm0_input;
 #endif
 
-// Period in [s]
-#define CURRENT_MEAS_PERIOD ( (float)2*TIM_1_8_PERIOD_CLOCKS*(TIM_1_8_RCR+1) / (float)TIM_1_8_CLOCK_HZ )
-static const float current_meas_period = CURRENT_MEAS_PERIOD;
-
-// Frequency in [Hz]
-#define CURRENT_MEAS_HZ ( (float)(TIM_1_8_CLOCK_HZ) / (float)(2*TIM_1_8_PERIOD_CLOCKS*(TIM_1_8_RCR+1)) )
-static const int current_meas_hz = CURRENT_MEAS_HZ;
+// PWM frequency of TIM1 and TIM8 in [Hz]. The current is measured and the
+// control loop runs once every (TIM_1_8_RCR + 1) PWM periods.
+// The upper limit leaves the control loop enough time to finish within one
+// period. The lower limit keeps the period of TIM13 within 16 bits.
+#define DEFAULT_PWM_FREQUENCY 24000.0f
+#define MIN_PWM_FREQUENCY 8000.0f
+#define MAX_PWM_FREQUENCY 48000.0f
+
+// Control loop period in [s] and frequency in [Hz]. These are derived from
+// the configured PWM frequency at boot (see board_apply_config()).
+extern float current_meas_period;
+extern int current_meas_hz;
 
 #if HW_VERSION_VOLTAGE >= 48
 #define VBUS_S_DIVIDER_RATIO 19.0f
@@ -134,7 +139,7 @@ static const int current_meas_hz = CURRENT_MEAS_HZ;
 static inline bool board_read_config() { return true; }
 static inline bool board_write_config() { return true; }
 static inline void board_clear_config() { }
-static inline bool board_apply_config() { return true; }
+bool board_apply_config();
 
 void system_init();
 bool board_init();
@@ -54,6 +54,7 @@
 /* Includes ------------------------------------------------------------------*/
 
 /* USER CODE BEGIN Includes */
+#include <stdint.h>
 #include "stm32f4xx_hal.h"
 
 #if HW_VERSION_MAJOR == 3 && HW_VERSION_MINOR == 1 \
@@ -67,7 +68,6 @@
 
 /* Private define ------------------------------------------------------------*/
 #define TIM_1_8_CLOCK_HZ 168000000
-#define TIM_1_8_PERIOD_CLOCKS 3500
 #define TIM_1_8_DEADTIME_CLOCKS 20
 #define TIM_APB1_CLOCK_HZ 84000000
 #define TIM_APB1_PERIOD_CLOCKS 4096
@@ -172,6 +172,12 @@
 void _Error_Handler(char *, int);
 
 #define Error_Handler() _Error_Handler(__FILE__, __LINE__)
+
+// The PWM frequency is configurable, so the TIM1/TIM8 period is set at boot
+// before the timers are initialized (see board_apply_config()).
+extern uint16_t tim_1_8_period_clocks;
+#define TIM_1_8_PERIOD_CLOCKS tim_1_8_period_clocks
+
 #ifdef __cplusplus
 }
 #endif
@@ -263,6 +263,36 @@ PwmInput pwm0_input{&htim5, {1, 2, 3, 4}};
 extern USBD_HandleTypeDef hUsbDeviceFS;
 USBD_HandleTypeDef& usb_dev_handle = hUsbDeviceFS;
 
+// Timing for DEFAULT_PWM_FREQUENCY until board_apply_config() runs
+static constexpr uint16_t default_period_clocks = (uint16_t)((float)TIM_1_8_CLOCK_HZ / (2.0f * DEFAULT_PWM_FREQUENCY));
+uint16_t tim_1_8_period_clocks = default_period_clocks;
+float current_meas_period = (float)(2 * default_period_clocks * (TIM_1_8_RCR + 1)) / (float)TIM_1_8_CLOCK_HZ;
+int current_meas_hz = TIM_1_8_CLOCK_HZ / (2 * default_period_clocks * (TIM_1_8_RCR + 1));
+
+/**
+ * @brief Derives the timer period and the control loop timing from the
+ * configured PWM frequency.
+ *
+ * This must run before board_init() and before the components apply their
+ * configurations, since their gains depend on current_meas_period. Changing
+ * the PWM frequency therefore requires a reboot.
+ * If the configured frequency is out of range it falls back to
+ * DEFAULT_PWM_FREQUENCY and sets odrv.misconfigured_. It does not fail, so
+ * that the rest of the configuration (e.g. the calibrations) is kept.
+ */
+bool board_apply_config() {
+    float pwm_frequency = odrv.config_.pwm_frequency;
+    if (!(pwm_frequency >= MIN_PWM_FREQUENCY) || !(pwm_frequency <= MAX_PWM_FREQUENCY)) {
+        pwm_frequency = DEFAULT_PWM_FREQUENCY;
+        odrv.misconfigured_ = true;
+    }
+
+    tim_1_8_period_clocks = (uint16_t)std::round((float)TIM_1_8_CLOCK_HZ / (2.0f * pwm_frequency));
+    current_meas_period = (float)CONTROL_TIMER_PERIOD_TICKS / (float)TIM_1_8_CLOCK_HZ;
+    current_meas_hz = TIM_1_8_CLOCK_HZ / CONTROL_TIMER_PERIOD_TICKS;
+    return true;
+}
+
 bool check_board_version(const uint8_t* otp_ptr) {
     return (otp_ptr[3] == HW_VERSION_MAJOR) &&
            (otp_ptr[4] == HW_VERSION_MINOR) &&
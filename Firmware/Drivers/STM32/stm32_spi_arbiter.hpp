@@ -12,7 +12,7 @@ public:
         Stm32Gpio ncs_gpio;
         const uint8_t* tx_buf;
         uint8_t* rx_buf;
-        size_t length;
+        size_t length; // number of data frames of config.DataSize
         void (*on_complete)(void*, bool);
         void* on_complete_ctx;
         bool is_in_use = false;
@@ -28,6 +28,7 @@ extern uint32_t irq_counters[];
 #define GET_IRQ_COUNTER(irqn) 0
 #endif
 
+#ifdef __arm__
 static inline uint32_t cpu_enter_critical() {
     uint32_t primask = __get_PRIMASK();
     __disable_irq();
@@ -37,6 +38,17 @@ static inline uint32_t cpu_enter_critical() {
 static inline void cpu_exit_critical(uint32_t priority_mask) {
     __set_PRIMASK(priority_mask);
 }
+#else
+// Host builds (simulator) never preempt a running context, so there is
+// nothing to mask.
+static inline uint32_t cpu_enter_critical() {
+    return 0;
+}
+
+static inline void cpu_exit_critical(uint32_t priority_mask) {
+    (void)priority_mask;
+}
+#endif
 
 #ifdef __cplusplus
 }
@@ -1,11 +1,12 @@
 
 #include "acim_estimator.hpp"
-#include <board.h>
+#include "odrive_main.h"
 
 void AcimEstimator::update(uint32_t timestamp)  {
-    std::optional<float> rotor_phase = rotor_phase_src_.present();
-    std::optional<float> rotor_phase_vel = rotor_phase_vel_src_.present();
-    std::optional<float2D> idq = idq_src_.present();
+    const SignalWiring& wiring = *axis_->wiring_;
+    std::optional<float> rotor_phase = wiring.rotor_phase_src.present();
+    std::optional<float> rotor_phase_vel = wiring.rotor_phase_vel_src.present();
+    std::optional<float2D> idq = wiring.idq_src.present();
 
     if (!rotor_phase.has_value() || !rotor_phase_vel.has_value() || !idq.has_value()) {
         active_ = false;
@@ -1,6 +1,8 @@
 #ifndef __ACIM_ESTIMATOR_HPP
 #define __ACIM_ESTIMATOR_HPP
 
+class Axis; // declared in axis.hpp
+
 #include <component.hpp>
 #include <cmath>
 #include <autogen/interfaces.hpp>
@@ -16,10 +18,7 @@ public:
     // Config
     Config_t config_;
 
-    // Inputs
-    InputPort<float> rotor_phase_src_;
-    InputPort<float> rotor_phase_vel_src_;
-    InputPort<float2D> idq_src_;
+    Axis* axis_ = nullptr; // set by Axis constructor
 
     // State variables
     bool active_ = false;
@@ -28,9 +27,9 @@ public:
     float phase_offset_ = 0.0f; // [A]
 
     // Outputs
-    OutputPort<float> slip_vel_ = 0.0f; // [rad/s electrical]
-    OutputPort<float> stator_phase_vel_ = 0.0f; // [rad/s] rotor flux angular velocity estimate
-    OutputPort<float> stator_phase_ = 0.0f; // [rad] rotor flux phase angle estimate
+    SignalOutput<float> slip_vel_{SignalFrame::ACIM_SLIP_VEL}; // [rad/s electrical]
+    SignalOutput<float> stator_phase_vel_{SignalFrame::ACIM_STATOR_PHASE_VEL}; // [rad/s] rotor flux angular velocity estimate
+    SignalOutput<float> stator_phase_{SignalFrame::ACIM_STATOR_PHASE}; // [rad] rotor flux phase angle estimate
 };
 
 #endif // __ACIM_ESTIMATOR_HPP
\ No newline at end of file
@@ -40,6 +40,56 @@ Axis::Axis(int axis_num,
     min_endstop_.axis_ = this;
     max_endstop_.axis_ = this;
     mechanical_brake_.axis_ = this;
+    acim_estimator_.axis_ = this;
+    motor_.current_control_.axis_ = this;
+
+    encoder_.phase_.bind(&signals_);
+    encoder_.phase_vel_.bind(&signals_);
+    encoder_.pos_estimate_.bind(&signals_);
+    encoder_.vel_estimate_.bind(&signals_);
+    encoder_.pos_circular_.bind(&signals_);
+    sensorless_estimator_.phase_.bind(&signals_);
+    sensorless_estimator_.phase_vel_.bind(&signals_);
+    sensorless_estimator_.vel_estimate_.bind(&signals_);
+    open_loop_controller_.Idq_setpoint_.bind(&signals_);
+    open_loop_controller_.Vdq_setpoint_.bind(&signals_);
+    open_loop_controller_.phase_.bind(&signals_);
+    open_loop_controller_.phase_vel_.bind(&signals_);
+    open_loop_controller_.total_distance_.bind(&signals_);
+    motor_.Idq_setpoint_.bind(&signals_);
+    motor_.Vdq_setpoint_.bind(&signals_);
+    acim_estimator_.slip_vel_.bind(&signals_);
+    acim_estimator_.stator_phase_.bind(&signals_);
+    acim_estimator_.stator_phase_vel_.bind(&signals_);
+    controller_.torque_output_.bind(&signals_);
+    controller_.circular_setpoint_range_.bind(&signals_);
+
+    // Until the first calibration all inputs read zero, except for the ACIM
+    // estimator which always follows the motor's current setpoint.
+    const SignalInput<float> zero = {&signals_, SignalFrame::ZERO};
+    const SignalInput<float2D> zero2D = {&signals_, SignalFrame::ZERO};
+    idle_wiring_.Idq_setpoint_src = zero2D;
+    idle_wiring_.Vdq_setpoint_src = zero2D;
+    idle_wiring_.phase_src = zero;
+    idle_wiring_.phase_vel_src = zero;
+    idle_wiring_.torque_setpoint_src = zero;
+    idle_wiring_.rotor_phase_src = zero;
+    idle_wiring_.rotor_phase_vel_src = zero;
+    idle_wiring_.idq_src = {&signals_, SignalFrame::MOTOR_IDQ_SETPOINT};
+    idle_wiring_.pos_estimate_linear_src = {&signals_, SignalFrame::ZERO};
+    idle_wiring_.pos_estimate_circular_src = zero;
+    idle_wiring_.vel_estimate_src = zero;
+    idle_wiring_.pos_wrap_src = zero;
+
+    open_loop_wiring_ = idle_wiring_;
+    open_loop_wiring_.Idq_setpoint_src = {&signals_, SignalFrame::OPEN_LOOP_IDQ_SETPOINT};
+    open_loop_wiring_.Vdq_setpoint_src = {&signals_, SignalFrame::OPEN_LOOP_VDQ_SETPOINT};
+    open_loop_wiring_.phase_src = {&signals_, SignalFrame::OPEN_LOOP_PHASE};
+    open_loop_wiring_.phase_vel_src = {&signals_, SignalFrame::OPEN_LOOP_PHASE_VEL};
+    open_loop_wiring_.rotor_phase_src = {&signals_, SignalFrame::OPEN_LOOP_PHASE};
+    open_loop_wiring_.rotor_phase_vel_src = {&signals_, SignalFrame::OPEN_LOOP_PHASE_VEL};
+
+    closed_loop_wiring_ = idle_wiring_;
 }
 
 Axis::LockinConfig_t Axis::default_calibration() {
@@ -199,15 +249,7 @@ bool Axis::run_lockin_spin(const LockinConfig_t &lockin_config, bool remain_arme
         open_loop_controller_.total_distance_ = 0.0f;
 
         motor_.current_control_.enable_current_control_src_ = motor_.config_.motor_type != Motor::MOTOR_TYPE_GIMBAL;
-        motor_.current_control_.Idq_setpoint_src_.connect_to(&open_loop_controller_.Idq_setpoint_);
-        motor_.current_control_.Vdq_setpoint_src_.connect_to(&open_loop_controller_.Vdq_setpoint_);
-
-        motor_.current_control_.phase_src_.connect_to(&open_loop_controller_.phase_);
-        acim_estimator_.rotor_phase_src_.connect_to(&open_loop_controller_.phase_);
-        
-        motor_.phase_vel_src_.connect_to(&open_loop_controller_.phase_vel_);
-        motor_.current_control_.phase_vel_src_.connect_to(&open_loop_controller_.phase_vel_);
-        acim_estimator_.rotor_phase_vel_src_.connect_to(&open_loop_controller_.phase_vel_);
+        wiring_ = &open_loop_wiring_;
     }
     wait_for_control_iteration();
 
@@ -265,26 +307,42 @@ bool Axis::start_closed_loop_control() {
     }
 
     // Hook up the data paths between the components
+    SignalWiring wiring;
+    if (sensorless_mode) {
+        const SignalInput<float> none = {&signals_, SignalFrame::NONE};
+        wiring.pos_estimate_linear_src = {&signals_, SignalFrame::NONE};
+        wiring.pos_estimate_circular_src = none;
+        wiring.pos_wrap_src = none;
+        wiring.vel_estimate_src = {&signals_, SignalFrame::SENSORLESS_VEL_ESTIMATE};
+    } else if (controller_.config_.load_encoder_axis < AXIS_COUNT) {
+        const SignalFrame* load_signals = &axes[controller_.config_.load_encoder_axis].signals_;
+        wiring.pos_estimate_circular_src = {load_signals, SignalFrame::ENCODER_POS_CIRCULAR};
+        wiring.pos_wrap_src = {&signals_, SignalFrame::CONTROLLER_CIRCULAR_SETPOINT_RANGE};
+        wiring.pos_estimate_linear_src = {load_signals, SignalFrame::ENCODER_POS_ESTIMATE};
+        wiring.vel_estimate_src = {load_signals, SignalFrame::ENCODER_VEL_ESTIMATE};
+    } else {
+        controller_.set_error(Controller::ERROR_INVALID_LOAD_ENCODER);
+        return false;
+    }
+
+    wiring.torque_setpoint_src = {&signals_, SignalFrame::CONTROLLER_TORQUE_OUTPUT};
+    wiring.Idq_setpoint_src = {&signals_, SignalFrame::MOTOR_IDQ_SETPOINT};
+    wiring.Vdq_setpoint_src = {&signals_, SignalFrame::MOTOR_VDQ_SETPOINT};
+    wiring.idq_src = {&signals_, SignalFrame::MOTOR_IDQ_SETPOINT};
+
+    bool is_acim = motor_.config_.motor_type == Motor::MOTOR_TYPE_ACIM;
+    // phase
+    SignalFrame::Slot phase_src = sensorless_mode ? SignalFrame::SENSORLESS_PHASE : SignalFrame::ENCODER_PHASE;
+    wiring.rotor_phase_src = {&signals_, phase_src};
+    wiring.phase_src = {&signals_, is_acim ? SignalFrame::ACIM_STATOR_PHASE : phase_src};
+    // phase vel
+    SignalFrame::Slot phase_vel_src = sensorless_mode ? SignalFrame::SENSORLESS_PHASE_VEL : SignalFrame::ENCODER_PHASE_VEL;
+    wiring.rotor_phase_vel_src = {&signals_, phase_vel_src};
+    wiring.phase_vel_src = {&signals_, is_acim ? SignalFrame::ACIM_STATOR_PHASE_VEL : phase_vel_src};
+
     CRITICAL_SECTION() {
-        if (sensorless_mode) {
-            controller_.pos_estimate_linear_src_.disconnect();
-            controller_.pos_estimate_circular_src_.disconnect();
-            controller_.pos_wrap_src_.disconnect();
-            controller_.vel_estimate_src_.connect_to(&sensorless_estimator_.vel_estimate_);
-        } else if (controller_.config_.load_encoder_axis < AXIS_COUNT) {
-            Axis* ax = &axes[controller_.config_.load_encoder_axis];
-            controller_.pos_estimate_circular_src_.connect_to(&ax->encoder_.pos_circular_);
-            controller_.pos_wrap_src_.connect_to(&controller_.config_.circular_setpoint_range);
-            controller_.pos_estimate_linear_src_.connect_to(&ax->encoder_.pos_estimate_);
-            controller_.vel_estimate_src_.connect_to(&ax->encoder_.vel_estimate_);
-        } else {
-            controller_.pos_estimate_circular_src_.disconnect();
-            controller_.pos_estimate_linear_src_.disconnect();
-            controller_.pos_wrap_src_.disconnect();
-            controller_.vel_estimate_src_.disconnect();
-            controller_.set_error(Controller::ERROR_INVALID_LOAD_ENCODER);
-            return false;
-        }
+        closed_loop_wiring_ = wiring;
+        wiring_ = &closed_loop_wiring_;
 
         // To avoid any transient on startup, we intialize the setpoint to be the current position
         controller_.control_mode_updated();
@@ -293,26 +351,10 @@ bool Axis::start_closed_loop_control() {
         // Avoid integrator windup issues
         controller_.vel_integrator_torque_ = 0.0f;
 
-        motor_.torque_setpoint_src_.connect_to(&controller_.torque_output_);
         motor_.direction_ = sensorless_mode ? 1.0f : encoder_.config_.direction;
 
         motor_.current_control_.enable_current_control_src_ = motor_.config_.motor_type != Motor::MOTOR_TYPE_GIMBAL;
-        motor_.current_control_.Idq_setpoint_src_.connect_to(&motor_.Idq_setpoint_);
-        motor_.current_control_.Vdq_setpoint_src_.connect_to(&motor_.Vdq_setpoint_);
-
-        bool is_acim = motor_.config_.motor_type == Motor::MOTOR_TYPE_ACIM;
-        // phase
-        OutputPort<float>* phase_src = sensorless_mode ? &sensorless_estimator_.phase_ : &encoder_.phase_;
-        acim_estimator_.rotor_phase_src_.connect_to(phase_src);
-        OutputPort<float>* stator_phase_src = is_acim ? &acim_estimator_.stator_phase_ : phase_src;
-        motor_.current_control_.phase_src_.connect_to(stator_phase_src);
-        // phase vel
-        OutputPort<float>* phase_vel_src = sensorless_mode ? &sensorless_estimator_.phase_vel_ : &encoder_.phase_vel_;
-        acim_estimator_.rotor_phase_vel_src_.connect_to(phase_vel_src);
-        OutputPort<float>* stator_phase_vel_src = is_acim ? &acim_estimator_.stator_phase_vel_ : phase_vel_src;
-        motor_.phase_vel_src_.connect_to(stator_phase_vel_src);
-        motor_.current_control_.phase_vel_src_.connect_to(stator_phase_vel_src);
-        
+
         if (sensorless_mode) {
             // Make the final velocity of the loĉk-in spin the setpoint of the
             // closed loop controller to allow for smooth transition.
@@ -391,7 +433,7 @@ bool Axis::run_homing() {
 
     error_ &= ~ERROR_MIN_ENDSTOP_PRESSED; // clear this error since we deliberately drove into the endstop
 
-    std::optional<float> pos_estimate_local = encoder_.pos_estimate_.any();
+    std::optional<Position> pos_estimate_local = encoder_.pos_estimate_.any();
     if (pos_estimate_local == std::nullopt || !pos_estimate_local.has_value()){
         return error_ |= ERROR_UNKNOWN_POSITION, false;
     }
@@ -402,9 +444,11 @@ bool Axis::run_homing() {
     // Initialize closed loop control, and then set the desired location.
     start_closed_loop_control();
     
-    controller_.input_pos_ = pos_estimate_local.value() + min_endstop_.config_.offset;
-    controller_.pos_setpoint_ = pos_estimate_local.value();
-    controller_.vel_setpoint_ = 0.0f;
+    CRITICAL_SECTION() {
+        controller_.input_pos_ = pos_estimate_local.value() + min_endstop_.config_.offset;
+        controller_.pos_setpoint_ = pos_estimate_local.value();
+        controller_.vel_setpoint_ = 0.0f;
+    }
     controller_.input_pos_updated();
 
     // Synchronization issue.  Ensure trajectory_done is false prior to the while loop, so that
@@ -543,6 +587,13 @@ void Axis::run_state_machine_loop() {
                 status = encoder_.run_hall_phase_calibration();
             } break;
 
+            case AXIS_STATE_ENCODER_ERROR_MAP_CALIBRATION: {
+                if (!motor_.is_calibrated_)
+                    goto invalid_state_label;
+
+                status = encoder_.run_error_map_calibration();
+            } break;
+
             case AXIS_STATE_HOMING: {
                 Controller::ControlMode stored_control_mode = controller_.config_.control_mode;
                 Controller::InputMode stored_input_mode = controller_.config_.input_mode;
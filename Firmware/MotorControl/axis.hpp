@@ -9,6 +9,7 @@ class Axis;
 #include "controller.hpp"
 #include "open_loop_controller.hpp"
 #include "trapTraj.hpp"
+#include "scurveTraj.hpp"
 #include "endstop.hpp"
 #include "mechanical_brake.hpp"
 #include "low_level.h"
@@ -160,7 +161,7 @@ public:
     bool run_homing();
     bool run_idle_loop();
 
-    constexpr uint32_t get_watchdog_reset() {
+    uint32_t get_watchdog_reset() {
         return static_cast<uint32_t>(std::clamp<float>(config_.watchdog_timeout, 0, UINT32_MAX / (current_meas_hz + 1)) * current_meas_hz);
     }
 
@@ -180,11 +181,19 @@ public:
     OpenLoopController open_loop_controller_;
     Motor& motor_;
     TrapezoidalTrajectory& trap_traj_;
+    SCurveTrajectory scurve_traj_;
     Endstop& min_endstop_;
     Endstop& max_endstop_;
     MechanicalBrake& mechanical_brake_;
     TaskTimes task_times_;
 
+    // Data paths between the components
+    SignalFrame signals_;
+    SignalWiring idle_wiring_;        // before the first calibration
+    SignalWiring open_loop_wiring_;   // lock-in spin and encoder calibration
+    SignalWiring closed_loop_wiring_; // set up by start_closed_loop_control()
+    const SignalWiring* wiring_ = &idle_wiring_;
+
     osThreadId thread_id_ = 0;
     const uint32_t stack_size_ = 2048; // Bytes
     volatile bool thread_id_valid_ = false;
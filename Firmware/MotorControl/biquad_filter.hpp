@@ -0,0 +1,143 @@
+#ifndef __BIQUAD_FILTER_HPP
+#define __BIQUAD_FILTER_HPP
+
+#include <cmath>
+#include <stddef.h>
+
+/**
+ * @brief Coefficients of one second order IIR section (biquad).
+ *
+ * The layout is the one of CMSIS-DSP's arm_biquad_cascade_df2T_f32: the
+ * feedback coefficients a1, a2 are stored negated, i.e.
+ * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2]
+ */
+struct Biquad {
+    enum Type {
+        TYPE_NONE,
+        TYPE_LOW_PASS,
+        TYPE_NOTCH,
+        TYPE_LEAD_LAG,
+    };
+
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+
+    /**
+     * @brief Designs a section by discretizing the analog prototype with the
+     * bilinear transform, prewarped so that the frequency is exact.
+     *
+     *  - TYPE_LOW_PASS: second order low pass with quality factor q. depth is unused.
+     *  - TYPE_NOTCH: band stop with quality factor q (center frequency / -3dB
+     *    width of the full notch). depth is the attenuation at the center
+     *    frequency: 1 is a full notch, 0.9 is -20dB, 0 has no effect.
+     *  - TYPE_LEAD_LAG: first order lead-lag with the maximum phase shift at
+     *    frequency. depth is the high frequency gain relative to the DC gain:
+     *    > 1 is a lead, < 1 is a lag. q is unused.
+     *
+     * All types have unity DC gain.
+     * Returns false and leaves the section unchanged if the parameters are
+     * invalid. The frequency must be below the Nyquist frequency.
+     */
+    static bool design(Type type, float frequency, float q, float depth, float sample_rate, Biquad* section) {
+        if (type == TYPE_NONE) {
+            *section = Biquad{};
+            return true;
+        }
+        if (!(frequency > 0.0f) || !(frequency < 0.5f * sample_rate)) {
+            return false;
+        }
+        float w = 2.0f * (float)M_PI * frequency; // [rad/s]
+        float K = w / std::tan(w / (2.0f * sample_rate)); // prewarped bilinear transform s = K (1 - z^-1) / (1 + z^-1)
+
+        // Analog prototype H(s) = (B2 s^2 + B1 s + B0) / (A2 s^2 + A1 s + A0)
+        float B2, B1, B0, A2, A1, A0;
+        switch (type) {
+            case TYPE_LOW_PASS: {
+                if (!(q > 0.0f)) return false;
+                B2 = 0.0f; B1 = 0.0f; B0 = w * w;
+                A2 = 1.0f; A1 = w / q; A0 = w * w;
+            } break;
+            case TYPE_NOTCH: {
+                if (!(q > 0.0f) || !(depth >= 0.0f && depth <= 1.0f)) return false;
+                B2 = 1.0f; B1 = (1.0f - depth) * w / q; B0 = w * w;
+                A2 = 1.0f; A1 = w / q; A0 = w * w;
+            } break;
+            case TYPE_LEAD_LAG: {
+                if (!(depth > 0.0f) || !std::isfinite(depth)) return false;
+                // Zero at w / sqrt(depth), pole at w * sqrt(depth)
+                float r = std::sqrt(depth);
+                float b0 = (K * r / w + 1.0f);
+                float b1 = (1.0f - K * r / w);
+                float a0 = (K / (r * w) + 1.0f);
+                float a1 = (1.0f - K / (r * w));
+                *section = {b0 / a0, b1 / a0, 0.0f, -a1 / a0, 0.0f};
+                return true;
+            }
+            default: return false;
+        }
+
+        float KK = K * K;
+        float b0 = B2 * KK + B1 * K + B0;
+        float b1 = 2.0f * (B0 - B2 * KK);
+        float b2 = B2 * KK - B1 * K + B0;
+        float a0 = A2 * KK + A1 * K + A0;
+        float a1 = 2.0f * (A0 - A2 * KK);
+        float a2 = A2 * KK - A1 * K + A0;
+        *section = {b0 / a0, b1 / a0, b2 / a0, -a1 / a0, -a2 / a0};
+        return true;
+    }
+};
+
+/**
+ * @brief Cascade of up to N biquad sections in transposed direct form II.
+ *
+ * The coefficients and the state use the layout of CMSIS-DSP's
+ * arm_biquad_casd_df2T_instance_f32, so step() can be replaced by
+ * arm_biquad_cascade_df2T_f32() where the DSP library is available.
+ */
+template<size_t N>
+class BiquadCascade {
+public:
+    /** @brief Replaces the sections and keeps the output continuous. */
+    void set_sections(const Biquad* sections, size_t n) {
+        n_stages_ = 0;
+        for (size_t i = 0; i < n && i < N; ++i) {
+            coeffs_[n_stages_++] = sections[i];
+        }
+        reset(last_input_);
+    }
+
+    size_t size() const { return n_stages_; }
+
+    /** @brief Sets the state to the steady state for a constant input x. */
+    void reset(float x) {
+        last_input_ = x;
+        for (size_t i = 0; i < n_stages_; ++i) {
+            const Biquad& c = coeffs_[i];
+            float y = x * (c.b0 + c.b1 + c.b2) / (1.0f - c.a1 - c.a2);
+            state_[2 * i + 1] = c.b2 * x + c.a2 * y;
+            state_[2 * i] = c.b1 * x + c.a1 * y + state_[2 * i + 1];
+            x = y;
+        }
+    }
+
+    float step(float x) {
+        last_input_ = x;
+        for (size_t i = 0; i < n_stages_; ++i) {
+            const Biquad& c = coeffs_[i];
+            float* d = &state_[2 * i];
+            float y = c.b0 * x + d[0];
+            d[0] = c.b1 * x + c.a1 * y + d[1];
+            d[1] = c.b2 * x + c.a2 * y;
+            x = y;
+        }
+        return x;
+    }
+
+private:
+    Biquad coeffs_[N];
+    float state_[2 * N] = {};
+    size_t n_stages_ = 0;
+    float last_input_ = 0.0f;
+};
+
+#endif // __BIQUAD_FILTER_HPP
@@ -0,0 +1,94 @@
+#ifndef __COGGING_MAP_HPP
+#define __COGGING_MAP_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdint.h>
+
+/**
+ * @brief Cogging torque as a function of the mechanical angle, sampled at
+ * n_bins equally spaced positions over one turn.
+ *
+ * The samples are stored as int16 with a common scale [Nm/LSB]. The scale
+ * starts out fine and is doubled whenever a sample does not fit, so the map
+ * always uses most of the int16 range. Between samples the torque is linearly
+ * interpolated.
+ *
+ * This is part of the controller config and is stored in NVM as-is, so it
+ * must stay trivially copyable. For the same reason the storage is sized for
+ * kMaxBins at compile time: the NVM layout can't depend on the configured
+ * n_bins and the firmware doesn't allocate memory at runtime. Fewer bins
+ * shorten the calibration and smooth the map, they don't save memory.
+ */
+class CoggingMap {
+public:
+    static constexpr uint32_t kMaxBins = 3600; // the resolution of the former float map
+    static constexpr float kInitialScale = 1e-5f; // [Nm/LSB]
+
+    uint32_t size() const { return n_bins_; }
+    float scale() const { return scale_; }
+
+    /** @brief Changes the number of bins and clears the map. Invalid sizes are ignored. */
+    void resize(uint32_t n_bins) {
+        if (n_bins >= 2 && n_bins <= kMaxBins) {
+            n_bins_ = n_bins;
+        }
+        clear();
+    }
+
+    void clear() {
+        std::fill(std::begin(map_), std::end(map_), 0);
+        scale_ = kInitialScale;
+    }
+
+    float get(uint32_t index) const {
+        return (index < n_bins_) ? (float)map_[index] * scale_ : 0.0f;
+    }
+
+    void set(uint32_t index, float torque) {
+        if (index >= n_bins_ || !std::isfinite(torque)) {
+            return;
+        }
+        while (std::abs(torque) > (float)INT16_MAX * scale_) {
+            for (uint32_t i = 0; i < n_bins_; ++i) {
+                map_[i] = (int16_t)(map_[i] / 2);
+            }
+            scale_ *= 2.0f;
+        }
+        map_[index] = (int16_t)std::lround(torque / scale_);
+    }
+
+    float mean() const {
+        int32_t sum = 0;
+        for (uint32_t i = 0; i < n_bins_; ++i) {
+            sum += map_[i];
+        }
+        return (float)sum / (float)n_bins_ * scale_;
+    }
+
+    void subtract(float offset) {
+        for (uint32_t i = 0; i < n_bins_; ++i) {
+            set(i, get(i) - offset);
+        }
+    }
+
+    /**
+     * @brief Returns the interpolated cogging torque at the specified
+     * position [turn]. The position does not need to be wrapped.
+     */
+    float interpolate(float pos) const {
+        float x = (pos - std::floor(pos)) * (float)n_bins_;
+        uint32_t i0 = std::min((uint32_t)x, n_bins_ - 1);
+        uint32_t i1 = (i0 + 1 < n_bins_) ? i0 + 1 : 0;
+        float frac = x - (float)i0;
+        return ((float)map_[i0] + frac * (float)(map_[i1] - map_[i0])) * scale_;
+    }
+
+private:
+    uint32_t n_bins_ = kMaxBins;
+    float scale_ = kInitialScale;
+    int16_t map_[kMaxBins] = {};
+};
+
+#endif // __COGGING_MAP_HPP
@@ -2,8 +2,13 @@
 #define __COMPONENT_HPP
 
 #include <stdint.h>
+#include <string.h>
+#include <atomic>
 #include <optional>
-#include <variant>
+#include <type_traits>
+#include <utility>
+#include <autogen/interfaces.hpp>
+#include "position.hpp"
 
 class ComponentBase {
 public:
@@ -20,162 +25,209 @@ public:
 };
 
 
-template<typename T>
-class InputPort;
-
 /**
- * @brief An output port stores a value for consumption by a connecting input
- * port.
- * 
- * Output ports are supposed to be reset at the beginning of a control loop
- * iteration. This ensures that connecting input ports don't use an outdated
- * value and, more importantly, ensures proper handling if the producer of the
- * value is incapable of producing the value for any reason.
- * 
+ * @brief Holds all values that the components of an axis exchange within one
+ * control loop iteration.
+ *
+ * The values are stored in a flat array at fixed offsets (float2D values
+ * occupy two consecutive slots, Position values three) and their validity in
+ * a bitmask, so that invalidating all values at the beginning of a control
+ * loop iteration is a single store. This ensures that consumers don't use an
+ * outdated value and, more importantly, ensures proper handling if the
+ * producer of the value is incapable of producing the value for any reason.
+ *
  * Member functions of this class are not thread-safe unless noted otherwise.
  */
-template<typename T>
-class OutputPort {
+class SignalFrame {
 public:
+    enum Slot : uint8_t {
+        ENCODER_PHASE,
+        ENCODER_PHASE_VEL,
+        ENCODER_POS_ESTIMATE,
+        ENCODER_VEL_ESTIMATE = ENCODER_POS_ESTIMATE + 3,
+        ENCODER_POS_CIRCULAR,
+        SENSORLESS_PHASE,
+        SENSORLESS_PHASE_VEL,
+        SENSORLESS_VEL_ESTIMATE,
+        OPEN_LOOP_PHASE,
+        OPEN_LOOP_PHASE_VEL,
+        OPEN_LOOP_TOTAL_DISTANCE,
+        OPEN_LOOP_IDQ_SETPOINT,
+        OPEN_LOOP_VDQ_SETPOINT = OPEN_LOOP_IDQ_SETPOINT + 2,
+        MOTOR_IDQ_SETPOINT = OPEN_LOOP_VDQ_SETPOINT + 2,
+        MOTOR_VDQ_SETPOINT = MOTOR_IDQ_SETPOINT + 2,
+        ACIM_SLIP_VEL = MOTOR_VDQ_SETPOINT + 2,
+        ACIM_STATOR_PHASE,
+        ACIM_STATOR_PHASE_VEL,
+        CONTROLLER_TORQUE_OUTPUT,
+        CONTROLLER_CIRCULAR_SETPOINT_RANGE,
+        ZERO,               // constant 0 (float, float2D or Position), always valid
+        NONE = ZERO + 3,    // never valid, so never loaded
+        kNumSlots = NONE + 1,
+    };
+    static_assert(kNumSlots <= 32, "validity mask too small");
+
     /**
-     * @brief Initializes the output port with the specified value.
-     * 
-     * An initialization value is required for any() to work properly.
-     * present() and previous() cannot be used to fetch the
-     * initialization value.
-     */
-    OutputPort(T val) : content_(val) {}
-    
-    /**
-     * @brief Updates the underlying value of this output port.
+     * @brief Marks all values as outdated. Must be called at the beginning of
+     * each control loop iteration. The values are not actually deleted and can
+     * still be accessed through any().
      */
-    void operator=(T value) {
-        content_ = value;
-        age_ = 0;
+    void new_cycle() {
+        previous_ = valid_;
+        valid_ = kConstantMask;
     }
 
-    /**
-     * @brief Marks the contained value as outdated. The value is not actually
-     * deleted and can still be accessed through some of the member functions
-     * of this class.
-     */
-    void reset() {
-        // This will eventually overflow to 0 so present() could
-        // theoretically return a very old value however it is very likely that
-        // the motor will be long disarmed by then.
-        age_++;
+    void set(Slot slot, float value) {
+        values_[slot] = value;
+        valid_ |= 1u << slot;
+    }
+
+    void set(Slot slot, float2D value) {
+        values_[slot] = value.first;
+        values_[slot + 1] = value.second;
+        valid_ |= 1u << slot;
+    }
+
+    void set(Slot slot, const Position& value) {
+        int64_t whole = value.whole();
+        float frac = value.frac();
+        values_[slot] = frac;
+        memcpy(&values_[slot + 1], &whole, sizeof(whole));
+        valid_ |= 1u << slot;
     }
 
     /**
      * @brief Returns the value from this control loop iteration or std::nullopt
      * if the value was not yet set during this control loop iteration.
      */
-    std::optional<T> present() {
-        if (age_ == 0) {
-            return content_;
-        } else {
-            return std::nullopt;
-        }
+    template<typename T>
+    std::optional<T> present(Slot slot) const {
+        return (valid_ & (1u << slot)) ? std::make_optional(load<T>(slot)) : std::nullopt;
     }
 
     /**
      * @brief Returns the value from exactly the previous control loop iteration.
-     * 
+     *
      * If during the last iteration no value was set or the value was already
      * overwritten during this control loop iteration then this function returns
      * std::nullopt.
      */
-    std::optional<T> previous() {
-        if (age_ == 1) {
-            return content_;
-        } else {
-            return std::nullopt;
-        }
+    template<typename T>
+    std::optional<T> previous(Slot slot) const {
+        return (previous_ & ~valid_ & (1u << slot)) ? std::make_optional(load<T>(slot)) : std::nullopt;
     }
 
     /**
-     * @brief Returns the value contained in this output port with disregard of
-     * when the value was set.
-     * 
-     * This function is thread-safe if load/store operations of T are atomic.
+     * @brief Returns the value with disregard of when it was set, or
+     * std::nullopt for the NONE slot.
+     *
+     * This function is thread-safe if load/store operations of T are atomic,
+     * and for Position (see load()).
      */
-    std::optional<T> any() {
-        return content_;
+    template<typename T>
+    std::optional<T> any(Slot slot) const {
+        return (slot != NONE) ? std::make_optional(load<T>(slot)) : std::nullopt;
     }
-    
+
 private:
-    uint32_t age_ = 2; // Age in number of control loop iterations
-    T content_;
+    static constexpr uint32_t kConstantMask = 1u << ZERO;
+
+    template<typename T>
+    T load(Slot slot) const {
+        if constexpr (std::is_same_v<T, float2D>) {
+            return {values_[slot], values_[slot + 1]};
+        } else if constexpr (std::is_same_v<T, Position>) {
+            // A Position is written by the control loop interrupt in three
+            // stores. A lower priority reader that gets interrupted in between
+            // sees the whole part change and reads again, otherwise a fraction
+            // that wrapped around would be off by one turn.
+            int64_t whole;
+            int64_t whole_check;
+            float frac;
+            do {
+                memcpy(&whole, &values_[slot + 1], sizeof(whole));
+                std::atomic_signal_fence(std::memory_order_acquire);
+                frac = values_[slot];
+                std::atomic_signal_fence(std::memory_order_acquire);
+                memcpy(&whole_check, &values_[slot + 1], sizeof(whole_check));
+            } while (whole != whole_check);
+            return Position::from_parts(whole, frac);
+        } else {
+            return values_[slot];
+        }
+    }
+
+    float values_[kNumSlots] = {};
+    uint32_t valid_ = kConstantMask;
+    uint32_t previous_ = 0;
 };
 
 /**
- * @brief An input port provides a value from the source to which it's configured.
- * 
- * The source can be one of:
- *  - an internally stored value
- *  - an externally stored value (referenced by a pointer)
- *  - an external OutputPort (referenced by a pointer)
- *  - none (all queries will return std::nullopt)
- * 
- * Member functions of this class are not thread-safe unless otherwise noted.
+ * @brief Handle through which a component writes one of its outputs to the
+ * signal frame of its axis.
  */
 template<typename T>
-class InputPort {
+class SignalOutput {
 public:
-    void connect_to(OutputPort<T>* input_port) {
-        content_ = input_port;
-    }
+    constexpr SignalOutput(SignalFrame::Slot slot) : slot_(slot) {}
 
-    void connect_to(T* input_ptr) {
-        content_ = input_ptr;
-    }
+    void bind(SignalFrame* frame) { frame_ = frame; }
 
-    void disconnect() {
-        content_ = (OutputPort<T>*)nullptr;
-    }
+    /**
+     * @brief Updates the value of this output for the current control loop
+     * iteration.
+     */
+    void operator=(T value) { frame_->set(slot_, value); }
 
-    std::optional<T> present() {
-        if (content_.index() == 2) {
-            OutputPort<T>* ptr = std::get<2>(content_);
-            return ptr ? ptr->present() : std::nullopt;
-        } else if (content_.index() == 1) {
-            T* ptr = std::get<1>(content_);
-            return ptr ? std::make_optional(*ptr) : std::nullopt;
-        } else {
-            return std::get<0>(content_);
-        }
-    }
+    std::optional<T> present() const { return frame_->present<T>(slot_); }
+    std::optional<T> previous() const { return frame_->previous<T>(slot_); }
+    std::optional<T> any() const { return frame_->any<T>(slot_); }
 
-    // TODO: probably it makes sense to let the application define that it's
-    // ok for this input port to fetch the value from the last iteration.
-    // This would provide a general way to resolve same-iteration data path cycles.
-
-    //std::optional<T> previous() {
-    //    if (content_.index() == 2) {
-    //        OutputPort<T>* ptr = std::get<2>(content_);
-    //        return ptr ? ptr->previous() : std::nullopt;
-    //    } else if (content_.index() == 1) {
-    //        T* ptr = std::get<1>(content_);
-    //        return ptr ? std::make_optional(*ptr) : std::nullopt;
-    //    } else {
-    //        return std::get<0>(content_);
-    //    }
-    //}
-
-    std::optional<T> any() {
-        if (content_.index() == 2) {
-            OutputPort<T>* ptr = std::get<2>(content_);
-            return ptr ? ptr->any() : std::nullopt;
-        } else if (content_.index() == 1) {
-            T* ptr = std::get<1>(content_);
-            return ptr ? std::make_optional(*ptr) : std::nullopt;
-        } else {
-            return std::get<0>(content_);
-        }
-    }
-    
 private:
-    std::variant<T, T*, OutputPort<T>*> content_;
+    SignalFrame* frame_ = nullptr; // set by Axis constructor
+    SignalFrame::Slot slot_;
+};
+
+/**
+ * @brief Entry of a wiring table: the slot of a signal frame from which a
+ * component input is read.
+ */
+template<typename T>
+struct SignalInput {
+    const SignalFrame* frame;
+    SignalFrame::Slot slot;
+
+    std::optional<T> present() const { return frame->present<T>(slot); }
+    std::optional<T> any() const { return frame->any<T>(slot); }
+};
+
+/**
+ * @brief Connects the inputs of the components of an axis to their sources.
+ *
+ * Each axis keeps one precomputed table per operating mode (idle, open loop,
+ * closed loop) and rewires all components at once by switching the active
+ * table.
+ */
+struct SignalWiring {
+    // FieldOrientedController
+    SignalInput<float2D> Idq_setpoint_src;
+    SignalInput<float2D> Vdq_setpoint_src;
+    SignalInput<float> phase_src;
+    SignalInput<float> phase_vel_src; // also used by the Motor for feedforward
+
+    // Motor
+    SignalInput<float> torque_setpoint_src;
+
+    // AcimEstimator
+    SignalInput<float> rotor_phase_src;
+    SignalInput<float> rotor_phase_vel_src;
+    SignalInput<float2D> idq_src;
+
+    // Controller
+    SignalInput<Position> pos_estimate_linear_src;
+    SignalInput<float> pos_estimate_circular_src;
+    SignalInput<float> vel_estimate_src;
+    SignalInput<float> pos_wrap_src;
 };
 
 
@@ -0,0 +1,329 @@
+/*
+* @brief Contains the system-level control loop, configuration sequence and error
+* handling of the ODrive.
+*
+* These functions only depend on the board abstraction and are shared between
+* the firmware and the host simulator (see Simulator/).
+*/
+
+#include "odrive_main.h"
+
+static uint16_t error_check_count = 0;
+
+/**
+ * @brief Resets the configuration of all components to the defaults.
+ * Used at boot by the firmware and the simulator.
+ */
+void config_clear_all() {
+    odrv.config_ = {};
+    odrv.can_.config_ = {};
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        encoders[i].config_ = {};
+        axes[i].sensorless_estimator_.config_ = {};
+        axes[i].controller_.config_ = {};
+        axes[i].controller_.config_.load_encoder_axis = i;
+        axes[i].trap_traj_.config_ = {};
+        axes[i].min_endstop_.config_ = {};
+        axes[i].max_endstop_.config_ = {};
+        axes[i].mechanical_brake_.config_ = {};
+        motors[i].config_ = {};
+        motors[i].fet_thermistor_.config_ = {};
+        motors[i].motor_thermistor_.config_ = {};
+        axes[i].clear_config();
+    }
+}
+
+/**
+ * @brief Applies the configuration of all components. Returns false if any of
+ * them rejected its configuration.
+ */
+bool config_apply_all() {
+    bool success = board_apply_config()
+                && odrv.can_.apply_config();
+    for (size_t i = 0; (i < AXIS_COUNT) && success; ++i) {
+        success = encoders[i].apply_config(motors[i].config_.motor_type)
+               && axes[i].controller_.apply_config()
+               && axes[i].min_endstop_.apply_config()
+               && axes[i].max_endstop_.apply_config()
+               && motors[i].apply_config()
+               && motors[i].motor_thermistor_.apply_config()
+               && axes[i].apply_config();
+    }
+    return success;
+}
+
+bool ODrive::any_error() {
+    return error_ != ODrive::ERROR_NONE
+        || std::any_of(axes.begin(), axes.end(), [](Axis& axis){
+            return axis.error_ != Axis::ERROR_NONE
+                || axis.motor_.error_ != Motor::ERROR_NONE        //to bypass motor error
+                || axis.sensorless_estimator_.error_ != SensorlessEstimator::ERROR_NONE
+                || axis.encoder_.error_ != Encoder::ERROR_NONE
+                || axis.controller_.error_ != Controller::ERROR_NONE;
+        });
+}
+
+void ODrive::clear_errors() {
+    for (auto& axis: axes) {
+        axis.motor_.error_ = Motor::ERROR_NONE;
+        axis.controller_.error_ = Controller::ERROR_NONE;
+        axis.sensorless_estimator_.error_ = SensorlessEstimator::ERROR_NONE;
+        axis.encoder_.error_ = Encoder::ERROR_NONE;
+        axis.encoder_.spi_error_rate_ = 0.0f;
+        axis.error_ = Axis::ERROR_NONE;
+    }
+    error_ = ERROR_NONE;
+    if (odrv.config_.enable_brake_resistor) {
+        safety_critical_arm_brake_resistor();
+    }
+}
+
+/**
+ * @brief Moves all axes to the specified positions such that they start and
+ * finish at the same time.
+ *
+ * The move is planned and started in the next control loop iteration. All axes
+ * must be in INPUT_MODE_TRAP_TRAJ.
+ */
+bool ODrive::move_to_pos_synchronized(float axis0_pos, float axis1_pos) {
+    const float goals[] = {axis0_pos, axis1_pos};
+    static_assert(std::size(goals) == AXIS_COUNT);
+
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        if (axes[i].controller_.config_.input_mode != Controller::INPUT_MODE_TRAP_TRAJ
+            || !std::isfinite(goals[i])) {
+            return false;
+        }
+    }
+
+    std::copy(std::begin(goals), std::end(goals), std::begin(sync_move_goals_));
+    sync_move_requested_.store(true, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Stretches all moves to the duration of the slowest one. Runs in the
+ * control loop right before the controllers so that all axes start in the
+ * same iteration.
+ */
+void ODrive::plan_synchronized_move() {
+    float move_time = 0.0f;
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        move_time = std::max(move_time, axes[i].controller_.get_move_time(sync_move_goals_[i]));
+    }
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        axes[i].controller_.move_to_pos_timed(sync_move_goals_[i], move_time);
+    }
+}
+
+/**
+ * @brief Runs system-level checks that need to be as real-time as possible.
+ * 
+ * This function is called after every current measurement of every motor.
+ * It should finish as quickly as possible.
+ */
+void ODrive::do_fast_checks() {
+    if (!(vbus_voltage >= config_.dc_bus_undervoltage_trip_level))
+        disarm_with_error(ERROR_DC_BUS_UNDER_VOLTAGE);
+    if (!(vbus_voltage <= config_.dc_bus_overvoltage_trip_level))
+        disarm_with_error(ERROR_DC_BUS_OVER_VOLTAGE);
+}
+
+/**
+ * @brief Floats all power phases on the system (all motors and brake resistors).
+ *
+ * This should be called if a system level exception ocurred that makes it
+ * unsafe to run power through the system in general.
+ */
+void ODrive::disarm_with_error(Error error) {
+    CRITICAL_SECTION() {
+        for (auto& axis: axes) {
+            axis.motor_.disarm_with_error(Motor::ERROR_SYSTEM_LEVEL);
+        }
+        safety_critical_disarm_brake_resistor();
+        error_ |= error;
+    }
+}
+
+/**
+ * @brief Runs the periodic sampling tasks
+ * 
+ * All components that need to sample real-world data should do it in this
+ * function as it runs on a high interrupt priority and provides lowest possible
+ * timing jitter.
+ * 
+ * All function called from this function should adhere to the following rules:
+ *  - Try to use the same number of CPU cycles in every iteration.
+ *    (reason: Tasks that run later in the function still want lowest possible timing jitter)
+ *  - Use as few cycles as possible.
+ *    (reason: The interrupt blocks other important interrupts (TODO: which ones?))
+ *  - Not call any FreeRTOS functions.
+ *    (reason: The interrupt priority is higher than the max allowed priority for syscalls)
+ * 
+ * Time consuming and undeterministic logic/arithmetic should live on
+ * control_loop_cb() instead.
+ */
+void ODrive::sampling_cb() {
+    n_evt_sampling_++;
+
+    MEASURE_TIME(task_times_.sampling) {
+        for (auto& axis: axes) {
+            axis.encoder_.sample_now();
+        }
+    }
+}
+
+/**
+ * @brief Housekeeping tasks that don't need to run at the full control loop
+ * rate.
+ *
+ * A task runs every `divisor` control loop iterations, namely in the
+ * iterations where (iteration % divisor) == phase. Tasks with the same divisor
+ * should use different phases so that their cost is spread over iterations
+ * instead of stacking up in one. Per-axis tasks are additionally staggered by
+ * axis. dt is the time between two runs of the task.
+ *
+ * System tasks are accounted to task_times_.control_loop_misc, per-axis tasks
+ * to the given timer of the axis.
+ */
+struct SystemTask {
+    void (*run)(float dt);
+    uint32_t divisor;
+    uint32_t phase;
+};
+
+struct AxisTask {
+    void (*run)(Axis& axis, float dt);
+    TaskTimer Axis::TaskTimes::* timer;
+    uint32_t divisor;
+    uint32_t phase;
+};
+
+static const SystemTask system_tasks[] = {
+    // At 1Mbaud at most 25 bytes arrive between two polls at 4kHz, which fits
+    // into the 64 byte DMA buffer.
+    {[](float) { uart_poll(); }, 2, 0},
+    {[](float) { odrv.oscilloscope_.update(); }, 1, 0},
+};
+
+static const AxisTask axis_tasks[] = {
+    {[](Axis& axis, float) { axis.min_endstop_.update(); axis.max_endstop_.update(); },
+        &Axis::TaskTimes::endstop_update, 2, 1},
+    {[](Axis& axis, float dt) { axis.motor_.fet_thermistor_.update(dt); axis.motor_.motor_thermistor_.update(dt); },
+        &Axis::TaskTimes::thermistor_update, 8, 3},
+};
+
+static bool is_task_due(uint32_t iteration, uint32_t divisor, uint32_t phase) {
+    return iteration % divisor == phase % divisor;
+}
+
+/**
+ * @brief Runs the periodic control loop.
+ * 
+ * This function is executed in a low priority interrupt context and is allowed
+ * to call CMSIS functions.
+ * 
+ * Yet it runs at a higher priority than communication workloads.
+ * 
+ * @param update_cnt: The true count of update events (wrapping around at 16
+ *        bits). This is used for timestamp calculation in the face of
+ *        potentially missed timer update interrupts. Therefore this counter
+ *        must not rely on any interrupts.
+ */
+void ODrive::control_loop_cb(uint32_t timestamp) {
+    last_update_timestamp_ = timestamp;
+    uint32_t iteration = n_evt_control_loop_++;
+
+    MEASURE_TIME(task_times_.control_loop_misc) {
+        // Invalidate all signals so that we are certain about the freshness of
+        // all values that we use.
+        // TODO: maybe we should add a check to outputs that prevents
+        // double-setting the value.
+        for (auto& axis: axes) {
+            axis.signals_.new_cycle();
+            axis.controller_.circular_setpoint_range_ = axis.controller_.config_.circular_setpoint_range;
+        }
+
+        for (const SystemTask& task: system_tasks) {
+            if (is_task_due(iteration, task.divisor, task.phase)) {
+                task.run(task.divisor * current_meas_period);
+            }
+        }
+    }
+
+    for (auto& axis: axes) {
+        for (const AxisTask& task: axis_tasks) {
+            uint32_t phase = task.phase + (uint32_t)axis.axis_num_ * task.divisor / AXIS_COUNT;
+            if (is_task_due(iteration, task.divisor, phase)) {
+                MEASURE_TIME(axis.task_times_.*task.timer)
+                    task.run(axis, task.divisor * current_meas_period);
+            }
+        }
+    }
+
+    MEASURE_TIME(task_times_.control_loop_checks) {
+        for (auto& axis: axes) {
+            // look for errors at axis level and also all subcomponents
+            bool checks_ok = axis.do_checks(timestamp);
+
+            // make sure the watchdog is being fed. 
+            bool watchdog_ok = axis.watchdog_check();
+
+            if (!checks_ok || !watchdog_ok) {
+                axis.motor_.disarm();
+            }
+        }
+    }
+
+    for (auto& axis: axes) {
+        // Sub-components should use set_error which will propegate to this error_
+        MEASURE_TIME(axis.task_times_.encoder_update)
+            axis.encoder_.update();
+    }
+
+    // Controller of either axis might use the encoder estimate of the other
+    // axis so we process both encoders before we continue.
+
+    if (sync_move_requested_.exchange(false, std::memory_order_acquire)) {
+        plan_synchronized_move();
+    }
+
+    for (auto& axis: axes) {
+        MEASURE_TIME(axis.task_times_.sensorless_estimator_update)
+            axis.sensorless_estimator_.update();
+
+        MEASURE_TIME(axis.task_times_.controller_update) {
+            if (!axis.controller_.update()) { // uses position and velocity from encoder
+                axis.error_ |= Axis::ERROR_CONTROLLER_FAILED;
+            }
+        }
+
+        MEASURE_TIME(axis.task_times_.open_loop_controller_update)
+            axis.open_loop_controller_.update(timestamp);
+
+        MEASURE_TIME(axis.task_times_.motor_update)
+            axis.motor_.update(timestamp); // uses torque from controller and phase_vel from encoder
+
+        MEASURE_TIME(axis.task_times_.current_controller_update)
+            axis.motor_.current_control_.update(timestamp); // uses the output of controller_ or open_loop_contoller_ and encoder_ or sensorless_estimator_ or acim_estimator_
+    }
+
+    // Tell the axis threads that the control loop has finished
+    for (auto& axis: axes) {
+        if (axis.thread_id_) {
+            osSignalSet(axis.thread_id_, 0x0001);
+        }
+    }
+    if(odrv.any_error()) {
+        //error_check_count+=1;
+        if(error_check_count++>2500) {
+            get_gpio(odrv.config_.error_gpio_pin).toggle();
+            error_check_count = 0;
+        }
+    } else {
+        get_gpio(odrv.config_.error_gpio_pin).write(0);
+    }
+    //get_gpio(odrv.config_.error_gpio_pin).write(odrv.any_error());
+}
+
+
@@ -1,11 +1,18 @@
 
 #include "odrive_main.h"
+#include "sincos.hpp"
 #include <algorithm>
 #include <numeric>
 
 bool Controller::apply_config() {
     config_.parent = this;
+    for (size_t i = 0; i < kNumFilterSections; ++i) {
+        config_.torque_filters[i].parent = this;
+        config_.vel_estimate_filters[i].parent = this;
+    }
     update_filter_gains();
+    update_biquad_filters();
+    select_update_fn();
     return true;
 }
 
@@ -16,6 +23,12 @@ void Controller::reset() {
     torque_setpoint_ = 0.0f;
     mechanical_power_ = 0.0f;
     electrical_power_ = 0.0f;
+    load_torque_estimate_ = 0.0f;
+    disturbance_observer_state_ = 0.0f;
+    last_torque_ = 0.0f;
+    frequency_response_.stop();
+    torque_filter_.reset(0.0f);
+    vel_estimate_filter_.reset(0.0f);
 }
 
 void Controller::set_error(Error error) {
@@ -28,25 +41,70 @@ void Controller::set_error(Error error) {
 //--------------------------------
 
 
-void Controller::move_to_pos(float goal_point) {
+void Controller::move_to_pos(const Position& goal_point) {
+    // The move is stretched to input_move_time_ if it would finish earlier.
+    // This is used to synchronize multiple axes.
     axis_->trap_traj_.planTrapezoidal(goal_point, pos_setpoint_, vel_setpoint_,
                                  axis_->trap_traj_.config_.vel_limit,
                                  axis_->trap_traj_.config_.accel_limit,
-                                 axis_->trap_traj_.config_.decel_limit);
+                                 axis_->trap_traj_.config_.decel_limit,
+                                 input_move_time_);
+    input_move_time_ = 0.0f;
     axis_->trap_traj_.t_ = 0.0f;
     trajectory_done_ = false;
 }
 
+// Returns the duration of the fastest trapezoidal move from the current
+// setpoint to goal_point.
+float Controller::get_move_time(const Position& goal_point) {
+    TrapezoidalTrajectory traj;
+    traj.planTrapezoidal(goal_point, pos_setpoint_, vel_setpoint_,
+                         axis_->trap_traj_.config_.vel_limit,
+                         axis_->trap_traj_.config_.accel_limit,
+                         axis_->trap_traj_.config_.decel_limit);
+    return traj.Tf_;
+}
+
+void Controller::move_to_pos_scurve(const Position& goal_point) {
+    SCurveTrajectory& traj = axis_->scurve_traj_;
+    // If a move is in progress, start the new one from the acceleration of the
+    // last setpoint so that the acceleration stays continuous.
+    float accel_setpoint = trajectory_done_ ? 0.0f : traj.eval(traj.t_ - current_meas_period).Ydd;
+    // The S-curve is planned in floats relative to the whole turn of the
+    // setpoint so that it has the same resolution at any distance from zero
+    scurve_origin_ = Position::from_parts(pos_setpoint_.whole(), 0.0f);
+    bool success = traj.planSCurve(goal_point - scurve_origin_, pos_setpoint_.frac(), vel_setpoint_, accel_setpoint,
+                                   axis_->trap_traj_.config_.vel_limit,
+                                   axis_->trap_traj_.config_.accel_limit,
+                                   axis_->trap_traj_.config_.decel_limit,
+                                   axis_->trap_traj_.config_.jerk_limit);
+    if (!success) {
+        set_error(ERROR_INVALID_TRAJECTORY_LIMITS);
+        trajectory_done_ = true;
+        return;
+    }
+    traj.t_ = 0.0f;
+    trajectory_done_ = false;
+}
+
 void Controller::move_incremental(float displacement, bool from_input_pos = true){
     if(from_input_pos){
-        input_pos_ += displacement;
+        write_input_pos(input_pos_ + displacement);
     } else{
-        input_pos_ = pos_setpoint_ + displacement;
+        write_input_pos(pos_setpoint_ + displacement);
     }
 
     input_pos_updated();
 }
 
+std::tuple<int64_t, float> Controller::get_pos_setpoint_turns() {
+    Position pos;
+    CRITICAL_SECTION() {
+        pos = pos_setpoint_;
+    }
+    return {pos.whole(), pos.frac()};
+}
+
 void Controller::start_anticogging_calibration() {
     // Ensure the cogging map was correctly allocated earlier and that the motor is capable of calibrating
     if (axis_->error_ == Axis::ERROR_NONE) {
@@ -57,13 +115,9 @@ void Controller::start_anticogging_calibration() {
 float Controller::remove_anticogging_bias()
 {
     auto& cogmap = config_.anticogging.cogging_map;
-    
-    auto sum = std::accumulate(std::begin(cogmap), std::end(cogmap), 0.0f);
-    auto average = sum / std::size(cogmap);
 
-    for(auto& val : cogmap) {
-        val -= average;
-    }
+    float average = cogmap.mean();
+    cogmap.subtract(average);
 
     return average;
 }
@@ -76,15 +130,15 @@ float Controller::remove_anticogging_bias()
  * 
  * This holding current is added as a feedforward term in the control loop.
  */
-bool Controller::anticogging_calibration(float pos_estimate, float vel_estimate) {
+bool Controller::anticogging_calibration(const Position& pos_estimate, float vel_estimate) {
     float pos_err = input_pos_ - pos_estimate;
     if (std::abs(pos_err) <= config_.anticogging.calib_pos_threshold / (float)axis_->encoder_.config_.cpr &&
         std::abs(vel_estimate) < config_.anticogging.calib_vel_threshold / (float)axis_->encoder_.config_.cpr) {
-        config_.anticogging.cogging_map[std::clamp<uint32_t>(config_.anticogging.index++, 0, 3600)] = vel_integrator_torque_;
+        config_.anticogging.cogging_map.set(config_.anticogging.index++, vel_integrator_torque_);
     }
-    if (config_.anticogging.index < 3600) {
+    if (config_.anticogging.index < config_.anticogging.cogging_map.size()) {
         config_.control_mode = CONTROL_MODE_POSITION_CONTROL;
-        input_pos_ = config_.anticogging.index * axis_->encoder_.getCoggingRatio();
+        input_pos_ = (float)config_.anticogging.index / (float)config_.anticogging.cogging_map.size();
         input_vel_ = 0.0f;
         input_torque_ = 0.0f;
         input_pos_updated();
@@ -102,26 +156,221 @@ bool Controller::anticogging_calibration(float pos_estimate, float vel_estimate)
     }
 }
 
-void Controller::set_input_pos_and_steps(float const pos) {
-    input_pos_ = pos;
+bool Controller::start_frequency_response() {
+    if (config_.input_mode != INPUT_MODE_TUNING) {
+        return false;
+    }
+    return frequency_response_.start(current_meas_period);
+}
+
+/*
+ * The sweep calibration moves the axis at constant velocity over
+ * calib_sweep_turns turns in both directions and records the torque
+ * that the position and velocity loops apply. Each time the axis passes a bin
+ * ("visit"), the mean torque of that visit is merged into the running average
+ * of the bin. Friction has opposite signs in the two directions and cancels
+ * out in the average, as does the position lag of the control loop.
+ *
+ * The recorded range starts on a boundary between two bins and spans full
+ * turns, so every bin is visited the same number of times.
+ */
+bool Controller::start_anticogging_sweep() {
+    const Anticogging_t& cfg = config_.anticogging;
+    // At least two samples per bin so that no bin is skipped
+    bool vel_ok = cfg.calib_sweep_vel > 0.0f
+               && cfg.calib_sweep_vel * (float)cfg.cogging_map.size() * current_meas_period <= 0.5f;
+    if (axis_->error_ != Axis::ERROR_NONE || !vel_ok || cfg.calib_sweep_turns == 0
+        || config_.vel_ramp_rate <= 0.0f || cfg.calib_anticogging
+        || is_anticogging_sweep_active()) {
+        return false;
+    }
+
+    anticogging_sweep_ = {};
+    anticogging_sweep_.phase = AnticoggingSweep_t::PHASE_RAMP_UP;
+    anticogging_sweep_.origin = pos_setpoint_.whole();
+    anticogging_sweep_.pos = pos_setpoint_.frac();
+    anticogging_valid_ = false;
+    config_.control_mode = CONTROL_MODE_POSITION_CONTROL;
+    return true;
+}
+
+// Runs after the input mode and overrides its setpoints
+void Controller::anticogging_sweep_update() {
+    AnticoggingSweep_t& s = anticogging_sweep_;
+    const float v = config_.anticogging.calib_sweep_vel;
+    const float dv = config_.vel_ramp_rate * current_meas_period;
+    const float settle_dist = 0.2f * v; // let the control loop settle for 200ms after each ramp
+    const float turns = (float)config_.anticogging.calib_sweep_turns;
+    const uint32_t n_bins = config_.anticogging.cogging_map.size();
+
+    switch (s.phase) {
+        case AnticoggingSweep_t::PHASE_RAMP_UP: {
+            s.vel = std::min(s.vel + dv, v);
+            if (s.vel == v) {
+                int32_t bin = (int32_t)std::ceil((s.pos + settle_dist) * (float)n_bins - 0.5f);
+                s.rec_start = ((float)bin + 0.5f) / (float)n_bins;
+                s.rec_bin = (uint32_t)mod(bin, (int32_t)n_bins);
+                s.phase = AnticoggingSweep_t::PHASE_FORWARD;
+            }
+        } break;
+        case AnticoggingSweep_t::PHASE_FORWARD: {
+            if (s.pos >= s.rec_start + turns + settle_dist) {
+                anticogging_sweep_flush();
+                s.phase = AnticoggingSweep_t::PHASE_REVERSE;
+            }
+        } break;
+        case AnticoggingSweep_t::PHASE_REVERSE: {
+            s.vel = std::max(s.vel - dv, -v);
+            if (s.vel == -v) {
+                s.phase = AnticoggingSweep_t::PHASE_BACKWARD;
+            }
+        } break;
+        case AnticoggingSweep_t::PHASE_BACKWARD: {
+            if (s.pos <= s.rec_start - settle_dist) {
+                anticogging_sweep_flush();
+                s.phase = AnticoggingSweep_t::PHASE_RAMP_DOWN;
+            }
+        } break;
+        case AnticoggingSweep_t::PHASE_RAMP_DOWN: {
+            s.vel = std::min(s.vel + dv, 0.0f);
+            if (s.vel == 0.0f) {
+                anticogging_sweep_finish();
+            }
+        } break;
+        default: break;
+    }
+
+    s.pos += s.vel * current_meas_period;
+    pos_setpoint_ = Position::from_parts(s.origin, s.pos);
+    vel_setpoint_ = s.vel;
+    torque_setpoint_ = 0.0f;
+}
+
+void Controller::anticogging_sweep_record(float pos_estimate, float torque) {
+    AnticoggingSweep_t& s = anticogging_sweep_;
+    const uint32_t n_bins = config_.anticogging.cogging_map.size();
+    const uint32_t turns = config_.anticogging.calib_sweep_turns;
+
+    bool forward = s.phase == AnticoggingSweep_t::PHASE_FORWARD;
+    if (!forward && s.phase != AnticoggingSweep_t::PHASE_BACKWARD) {
+        return;
+    }
+    float dist = forward ? pos_estimate - s.rec_start : s.rec_start + (float)turns - pos_estimate;
+    if (!(dist >= 0.0f && dist < (float)turns)) {
+        return;
+    }
+
+    int32_t visit = (int32_t)(dist * (float)n_bins) + (forward ? 0 : (int32_t)(turns * n_bins));
+    // Only move on in the direction of the sweep. If noise pushes the position
+    // back into the previous bin, the sample is added to the current bin.
+    if (visit > s.visit) {
+        anticogging_sweep_flush();
+        s.visit = visit;
+    }
+    s.visit_sum += torque;
+    s.visit_samples++;
+}
+
+void Controller::anticogging_sweep_flush() {
+    AnticoggingSweep_t& s = anticogging_sweep_;
+    CoggingMap& map = config_.anticogging.cogging_map;
+    const uint32_t n_bins = map.size();
+    const uint32_t n_fwd = config_.anticogging.calib_sweep_turns * n_bins;
+
+    if (s.visit < 0 || s.visit_samples == 0) {
+        return;
+    }
+
+    bool forward = (uint32_t)s.visit < n_fwd;
+    uint32_t offset = forward ? (uint32_t)s.visit : (uint32_t)s.visit - n_fwd;
+    uint32_t bin = forward ? (s.rec_bin + 1 + offset) % n_bins
+                           : (s.rec_bin + n_bins - offset % n_bins) % n_bins;
+    uint32_t n_prev = (uint32_t)s.visit / n_bins; // earlier visits of the same bin
+
+    float x = s.visit_sum / (float)s.visit_samples;
+    float mean = map.get(bin);
+    map.set(bin, mean + (x - mean) / (float)(n_prev + 1));
+    s.dir_sum[forward ? 0 : 1] += x;
+    s.dir_visits[forward ? 0 : 1]++;
+
+    s.visit_sum = 0.0f;
+    s.visit_samples = 0;
+}
+
+void Controller::anticogging_sweep_finish() {
+    AnticoggingSweep_t& s = anticogging_sweep_;
+    Anticogging_t& cfg = config_.anticogging;
+    const CoggingMap& map = cfg.cogging_map;
+    const uint32_t n_bins = map.size();
+    const uint32_t n_visits = 2 * cfg.calib_sweep_turns * n_bins;
+
+    float friction = 0.0f;
+    if (s.dir_visits[0] && s.dir_visits[1]) {
+        friction = 0.5f * (s.dir_sum[0] / (float)s.dir_visits[0] - s.dir_sum[1] / (float)s.dir_visits[1]);
+    }
+
+    // The cogging torque is smooth compared to the bin width while the noise
+    // is independent from bin to bin. The second difference of white noise
+    // has 6 times its variance, so it gives an estimate of the noise that
+    // barely depends on the cogging torque itself.
+    float mean = map.mean();
+    float var = 0.0f;
+    float diff2_var = 0.0f;
+    for (uint32_t i = 0; i < n_bins; ++i) {
+        float prev = map.get((i + n_bins - 1) % n_bins);
+        float next = map.get((i + 1) % n_bins);
+        var += SQ(map.get(i) - mean);
+        diff2_var += SQ(next - 2.0f * map.get(i) + prev);
+    }
+    var /= (float)n_bins;
+    float noise_var = diff2_var / (6.0f * (float)n_bins);
+
+    cfg.calib_friction = friction;
+    cfg.calib_noise_rms = std::sqrt(noise_var);
+    cfg.calib_quality = noise_var > 0.0f ? std::sqrt(std::max(0.0f, var - noise_var) / noise_var) : INFINITY;
+
+    s.phase = AnticoggingSweep_t::PHASE_IDLE;
+    input_pos_ = Position::from_parts(s.origin, s.pos);
+    input_vel_ = 0.0f;
+    input_torque_ = 0.0f;
+    input_pos_updated();
+    anticogging_valid_ = s.dir_visits[0] + s.dir_visits[1] == n_visits;
+}
+
+void Controller::set_input_pos_and_steps(const Position& pos) {
+    write_input_pos(pos);
     if (config_.circular_setpoints) {
         float const range = config_.circular_setpoint_range;
-        axis_->steps_ = (int64_t)(fmodf_pos(pos, range) / range * config_.steps_per_circular_range);
+        axis_->steps_ = (int64_t)(fmodf_pos(pos.to_float(), range) / range * config_.steps_per_circular_range);
     } else {
-        axis_->steps_ = (int64_t)(pos * config_.steps_per_circular_range);
+        axis_->steps_ = pos.whole() * config_.steps_per_circular_range
+                      + (int64_t)(pos.frac() * config_.steps_per_circular_range);
+    }
+}
+
+// A Position is written in several stores. This keeps the control loop from
+// seeing a half written input_pos_ when it is set from outside of it.
+void Controller::write_input_pos(const Position& pos) {
+    CRITICAL_SECTION() {
+        input_pos_ = pos;
     }
 }
 
 bool Controller::control_mode_updated() {
+    select_update_fn();
     if (config_.control_mode >= CONTROL_MODE_POSITION_CONTROL) {
-        std::optional<float> estimate = (config_.circular_setpoints ?
-                                pos_estimate_circular_src_ :
-                                pos_estimate_linear_src_).any();
+        std::optional<Position> estimate = axis_->wiring_->pos_estimate_linear_src.any();
+        if (config_.circular_setpoints) {
+            std::optional<float> circular = axis_->wiring_->pos_estimate_circular_src.any();
+            estimate = circular.has_value() ? std::make_optional<Position>(*circular) : std::nullopt;
+        }
         if (!estimate.has_value()) {
             return false;
         }
 
-        pos_setpoint_ = *estimate;
+        CRITICAL_SECTION() {
+            pos_setpoint_ = *estimate;
+        }
         set_input_pos_and_steps(*estimate);
     }
     return true;
@@ -134,53 +383,176 @@ void Controller::update_filter_gains() {
     input_filter_kp_ = 0.25f * (input_filter_ki_ * input_filter_ki_); // Critically damped
 }
 
+static_assert(Controller::FILTER_TYPE_LOW_PASS == (int)Biquad::TYPE_LOW_PASS
+              && Controller::FILTER_TYPE_NOTCH == (int)Biquad::TYPE_NOTCH
+              && Controller::FILTER_TYPE_LEAD_LAG == (int)Biquad::TYPE_LEAD_LAG, "filter types must match");
+
+// Computes the coefficients of the active sections of a filter chain
+static size_t design_filter_chain(const Controller::FilterSection_t* config, Biquad* sections) {
+    size_t n = 0;
+    for (size_t i = 0; i < Controller::kNumFilterSections; ++i) {
+        const Controller::FilterSection_t& section = config[i];
+        if (section.type != Controller::FILTER_TYPE_NONE
+            && Biquad::design((Biquad::Type)section.type, section.frequency, section.q, section.depth, 1.0f / current_meas_period, &sections[n])) {
+            n++;
+        }
+    }
+    return n;
+}
+
+void Controller::update_biquad_filters() {
+    Biquad sections[kNumFilterSections];
+    size_t n = design_filter_chain(config_.torque_filters, sections);
+    torque_filter_.set_sections(sections, n);
+    n = design_filter_chain(config_.vel_estimate_filters, sections);
+    vel_estimate_filter_.set_sections(sections, n);
+}
+
 static float limitVel(const float vel_limit, const float vel_estimate, const float vel_gain, const float torque) {
     float Tmax = (vel_limit - vel_estimate) * vel_gain;
     float Tmin = (-vel_limit - vel_estimate) * vel_gain;
     return std::clamp(torque, Tmin, Tmax);
 }
 
+// The estimates are read once per update and shared by the update stages
+struct Controller::Estimates_t {
+    std::optional<Position> pos_estimate_linear;
+    std::optional<float> pos_estimate_circular;
+    std::optional<float> pos_wrap;
+    std::optional<float> vel_estimate;
+    std::optional<Position> anticogging_pos_estimate;
+    std::optional<float> anticogging_vel_estimate;
+};
+
+// Control modes that behave the same share one update routine
+static constexpr Controller::ControlMode control_variant(Controller::ControlMode mode) {
+    return (mode >= Controller::CONTROL_MODE_POSITION_CONTROL) ? Controller::CONTROL_MODE_POSITION_CONTROL
+         : (mode >= Controller::CONTROL_MODE_VELOCITY_CONTROL) ? Controller::CONTROL_MODE_VELOCITY_CONTROL
+         : Controller::CONTROL_MODE_TORQUE_CONTROL;
+}
+
+template<bool CIRCULAR>
+static Controller::UpdateFn update_fn_for_input_mode(Controller::InputMode input_mode) {
+    switch (input_mode) {
+        case Controller::INPUT_MODE_INACTIVE: return &Controller::update_impl<Controller::INPUT_MODE_INACTIVE, CIRCULAR>;
+        case Controller::INPUT_MODE_PASSTHROUGH: return &Controller::update_impl<Controller::INPUT_MODE_PASSTHROUGH, CIRCULAR>;
+        case Controller::INPUT_MODE_VEL_RAMP: return &Controller::update_impl<Controller::INPUT_MODE_VEL_RAMP, CIRCULAR>;
+        case Controller::INPUT_MODE_TORQUE_RAMP: return &Controller::update_impl<Controller::INPUT_MODE_TORQUE_RAMP, CIRCULAR>;
+        case Controller::INPUT_MODE_POS_FILTER: return &Controller::update_impl<Controller::INPUT_MODE_POS_FILTER, CIRCULAR>;
+        case Controller::INPUT_MODE_MIRROR: return &Controller::update_impl<Controller::INPUT_MODE_MIRROR, CIRCULAR>;
+        case Controller::INPUT_MODE_TRAP_TRAJ: return &Controller::update_impl<Controller::INPUT_MODE_TRAP_TRAJ, CIRCULAR>;
+        case Controller::INPUT_MODE_SCURVE_TRAJ: return &Controller::update_impl<Controller::INPUT_MODE_SCURVE_TRAJ, CIRCULAR>;
+        case Controller::INPUT_MODE_PVT: return &Controller::update_impl<Controller::INPUT_MODE_PVT, CIRCULAR>;
+        case Controller::INPUT_MODE_TUNING: return &Controller::update_impl<Controller::INPUT_MODE_TUNING, CIRCULAR>;
+        // MIX_CHANNELS is not implemented and stands in for all invalid input modes
+        default: return &Controller::update_impl<Controller::INPUT_MODE_MIX_CHANNELS, CIRCULAR>;
+    }
+}
+
+template<Controller::ControlMode CM, bool CIRCULAR>
+static Controller::ControlFn control_fn_for_motor_type(ODriveIntf::MotorIntf::MotorType motor_type) {
+    return (motor_type == Motor::MOTOR_TYPE_ACIM) ? &Controller::update_control<CM, CIRCULAR, true>
+                                                  : &Controller::update_control<CM, CIRCULAR, false>;
+}
+
+void Controller::select_update_fn() {
+    update_fn_control_mode_ = config_.control_mode;
+    update_fn_input_mode_ = config_.input_mode;
+    update_fn_circular_setpoints_ = config_.circular_setpoints;
+    update_fn_motor_type_ = axis_->motor_.config_.motor_type;
+    update_fn_ = update_fn_circular_setpoints_ ? update_fn_for_input_mode<true>(config_.input_mode)
+                                               : update_fn_for_input_mode<false>(config_.input_mode);
+    // Circular setpoints only change the position error
+    switch (control_variant(config_.control_mode)) {
+        case CONTROL_MODE_POSITION_CONTROL:
+            control_fn_ = update_fn_circular_setpoints_ ? control_fn_for_motor_type<CONTROL_MODE_POSITION_CONTROL, true>(update_fn_motor_type_)
+                                                        : control_fn_for_motor_type<CONTROL_MODE_POSITION_CONTROL, false>(update_fn_motor_type_);
+            break;
+        case CONTROL_MODE_VELOCITY_CONTROL: control_fn_ = control_fn_for_motor_type<CONTROL_MODE_VELOCITY_CONTROL, false>(update_fn_motor_type_); break;
+        default: control_fn_ = control_fn_for_motor_type<CONTROL_MODE_TORQUE_CONTROL, false>(update_fn_motor_type_); break;
+    }
+}
+
+/*
+ * The update routine is specialized for the input mode and circular setpoints,
+ * the control stage for the control mode, circular setpoints and ACIM gain
+ * scheduling, so that these checks are resolved at compile time instead of
+ * on every iteration. Both are selected when the configuration changes.
+ * Settings that are written directly (e.g. over CAN) are picked up here on
+ * the next iteration.
+ */
 bool Controller::update() {
-    std::optional<float> pos_estimate_linear = pos_estimate_linear_src_.present();
-    std::optional<float> pos_estimate_circular = pos_estimate_circular_src_.present();
-    std::optional<float> pos_wrap = pos_wrap_src_.present();
-    std::optional<float> vel_estimate = vel_estimate_src_.present();
+    if (config_.control_mode != update_fn_control_mode_ || config_.input_mode != update_fn_input_mode_
+            || config_.circular_setpoints != update_fn_circular_setpoints_
+            || axis_->motor_.config_.motor_type != update_fn_motor_type_ || !update_fn_) {
+        select_update_fn();
+    }
+    return (this->*update_fn_)();
+}
 
-    std::optional<float> anticogging_pos_estimate = axis_->encoder_.pos_estimate_.present();
-    std::optional<float> anticogging_vel_estimate = axis_->encoder_.vel_estimate_.present();
+template<Controller::InputMode IM, bool CIRCULAR>
+bool Controller::update_impl() {
+    const SignalWiring& wiring = *axis_->wiring_;
+    Estimates_t est = {
+        wiring.pos_estimate_linear_src.present(),
+        wiring.pos_estimate_circular_src.present(),
+        wiring.pos_wrap_src.present(),
+        wiring.vel_estimate_src.present(),
+        axis_->encoder_.pos_estimate_.present(),
+        axis_->encoder_.vel_estimate_.present(),
+    };
+
+    // Only the position filter uses circular deltas, the other input modes
+    // share one instance
+    if (!update_prologue<CIRCULAR>(est) || !update_input<IM, CIRCULAR && IM == INPUT_MODE_POS_FILTER>(est)) {
+        return false;
+    }
 
+    // Trajectories and the anticogging calibration switch to position control
+    // within an iteration
+    if (config_.control_mode != update_fn_control_mode_) {
+        select_update_fn();
+    }
+    return (this->*control_fn_)(est);
+}
+
+template<bool CIRCULAR>
+bool Controller::update_prologue(Estimates_t& est) {
     if (axis_->step_dir_active_) {
-        if (config_.circular_setpoints) {
-            if (!pos_wrap.has_value()) {
+        if (CIRCULAR) {
+            if (!est.pos_wrap.has_value()) {
                 set_error(ERROR_INVALID_CIRCULAR_RANGE);
                 return false;
             }
-            input_pos_ = (float)(axis_->steps_ % config_.steps_per_circular_range) * (*pos_wrap / (float)(config_.steps_per_circular_range));
+            input_pos_ = (float)(axis_->steps_ % config_.steps_per_circular_range) * (*est.pos_wrap / (float)(config_.steps_per_circular_range));
         } else {
-            input_pos_ = (float)(axis_->steps_) / (float)(config_.steps_per_circular_range);
+            input_pos_ = Position::from_counts(Position::from_parts(axis_->steps_, 0.0f), config_.steps_per_circular_range);
         }
     }
 
     if (config_.anticogging.calib_anticogging) {
-        if (!anticogging_pos_estimate.has_value() || !anticogging_vel_estimate.has_value()) {
+        if (!est.anticogging_pos_estimate.has_value() || !est.anticogging_vel_estimate.has_value()) {
             set_error(ERROR_INVALID_ESTIMATE);
             return false;
         }
         // non-blocking
-        anticogging_calibration(*anticogging_pos_estimate, *anticogging_vel_estimate);
+        anticogging_calibration(*est.anticogging_pos_estimate, *est.anticogging_vel_estimate);
     }
 
     // TODO also enable circular deltas for 2nd order filter, etc.
-    if (config_.circular_setpoints) {
-        if (!pos_wrap.has_value()) {
+    if (CIRCULAR) {
+        if (!est.pos_wrap.has_value()) {
             set_error(ERROR_INVALID_CIRCULAR_RANGE);
             return false;
         }
-        input_pos_ = fmodf_pos(input_pos_, *pos_wrap);
+        input_pos_ = fmodf_pos(input_pos_.to_float(), *est.pos_wrap);
     }
+    return true;
+}
 
-    // Update inputs
-    switch (config_.input_mode) {
+template<Controller::InputMode IM, bool CIRCULAR>
+bool Controller::update_input(Estimates_t& est) {
+    switch (IM) {
         case INPUT_MODE_INACTIVE: {
             // do nothing
         } break;
@@ -207,12 +579,12 @@ bool Controller::update() {
         case INPUT_MODE_POS_FILTER: {
             // 2nd order pos tracking filter
             float delta_pos = input_pos_ - pos_setpoint_; // Pos error
-            if (config_.circular_setpoints) {
-                if (!pos_wrap.has_value()) {
+            if (CIRCULAR) {
+                if (!est.pos_wrap.has_value()) {
                     set_error(ERROR_INVALID_CIRCULAR_RANGE);
                     return false;
                 }
-                delta_pos = wrap_pm(delta_pos, *pos_wrap);
+                delta_pos = wrap_pm(delta_pos, *est.pos_wrap);
             }
             float delta_vel = input_vel_ - vel_setpoint_; // Vel error
             float accel = input_filter_kp_*delta_pos + input_filter_ki_*delta_vel; // Feedback
@@ -222,7 +594,7 @@ bool Controller::update() {
         } break;
         case INPUT_MODE_MIRROR: {
             if (config_.axis_to_mirror < AXIS_COUNT) {
-                std::optional<float> other_pos = axes[config_.axis_to_mirror].encoder_.pos_estimate_.present();
+                std::optional<Position> other_pos = axes[config_.axis_to_mirror].encoder_.pos_estimate_.present();
                 std::optional<float> other_vel = axes[config_.axis_to_mirror].encoder_.vel_estimate_.present();
                 std::optional<float> other_torque = axes[config_.axis_to_mirror].controller_.torque_output_.present();
 
@@ -231,7 +603,7 @@ bool Controller::update() {
                     return false;
                 }
 
-                pos_setpoint_ = *other_pos * config_.mirror_ratio;
+                pos_setpoint_ = other_pos->to_float() * config_.mirror_ratio;
                 vel_setpoint_ = *other_vel * config_.mirror_ratio;
                 torque_setpoint_ = *other_torque * config_.torque_mirror_ratio;
             } else {
@@ -265,15 +637,65 @@ bool Controller::update() {
                 torque_setpoint_ = traj_step.Ydd * config_.inertia;
                 axis_->trap_traj_.t_ += current_meas_period;
             }
-            anticogging_pos_estimate = pos_setpoint_; // FF the position setpoint instead of the pos_estimate
+            est.anticogging_pos_estimate = pos_setpoint_; // FF the position setpoint instead of the pos_estimate
+        } break;
+        case INPUT_MODE_SCURVE_TRAJ: {
+            if(input_pos_updated_){
+                move_to_pos_scurve(input_pos_);
+                input_pos_updated_ = false;
+            }
+            // Avoid updating uninitialized trajectory
+            if (trajectory_done_)
+                break;
+
+            if (axis_->scurve_traj_.t_ > axis_->scurve_traj_.Tf_) {
+                // Drop into position control mode when done to avoid problems on loop counter delta overflow
+                config_.control_mode = CONTROL_MODE_POSITION_CONTROL;
+                pos_setpoint_ = scurve_origin_ + axis_->scurve_traj_.Xf_;
+                vel_setpoint_ = 0.0f;
+                torque_setpoint_ = 0.0f;
+                trajectory_done_ = true;
+            } else {
+                SCurveTrajectory::Step_t traj_step = axis_->scurve_traj_.eval(axis_->scurve_traj_.t_);
+                pos_setpoint_ = scurve_origin_ + traj_step.Y;
+                vel_setpoint_ = traj_step.Yd;
+                torque_setpoint_ = traj_step.Ydd * config_.inertia;
+                axis_->scurve_traj_.t_ += current_meas_period;
+            }
+            est.anticogging_pos_estimate = pos_setpoint_; // FF the position setpoint instead of the pos_estimate
+        } break;
+        case INPUT_MODE_PVT: {
+            PvtBuffer::Step_t step;
+            if (pvt_buffer_.update(current_meas_period, pos_setpoint_.to_float(), vel_setpoint_, &step)) {
+                pos_setpoint_ = step.Y;
+                vel_setpoint_ = step.Yd;
+                torque_setpoint_ = step.Ydd * config_.inertia;
+            }
         } break;
         case INPUT_MODE_TUNING: {
+            if (frequency_response_.is_active()) {
+                autotuning_.frequency = frequency_response_.frequency();
+            }
             autotuning_phase_ = wrap_pm_pi(autotuning_phase_ + (2.0f * M_PI * autotuning_.frequency * current_meas_period));
-            float c = our_arm_cos_f32(autotuning_phase_);
-            float s = our_arm_sin_f32(autotuning_phase_);
+            auto [s, c] = fast_sincos(autotuning_phase_);
             pos_setpoint_ = input_pos_ + autotuning_.pos_amplitude * s; // + pos_amp_c * c
             vel_setpoint_ = input_vel_ + autotuning_.vel_amplitude * c;
             torque_setpoint_ = input_torque_ + autotuning_.torque_amplitude * -s;
+
+            if (frequency_response_.is_active()) {
+                // The response is measured relative to the position sine wave
+                // if there is one, else relative to the velocity or torque sine wave.
+                // Positions relative to input_pos_, the offset drops out
+                float ref = (autotuning_.pos_amplitude != 0.0f) ? pos_setpoint_ - input_pos_
+                          : (autotuning_.vel_amplitude != 0.0f) ? vel_setpoint_
+                          : torque_setpoint_;
+                float meas[FrequencyResponseAnalyzer::kNumChannels] = {
+                    est.pos_estimate_linear.has_value() ? *est.pos_estimate_linear - input_pos_ : 0.0f,
+                    est.vel_estimate.value_or(0.0f),
+                    axis_->motor_.current_control_.Iq_measured_
+                };
+                frequency_response_.update(current_meas_period, s, c, ref, meas);
+            }
         } break;
         default: {
             set_error(ERROR_INVALID_INPUT_MODE);
@@ -282,6 +704,22 @@ bool Controller::update() {
         
     }
 
+    if (IM != INPUT_MODE_TUNING) {
+        frequency_response_.stop();
+    }
+    return true;
+}
+
+template<Controller::ControlMode CM, bool CIRCULAR, bool ACIM>
+bool Controller::update_control(Estimates_t& est) {
+    if (is_anticogging_sweep_active()) {
+        if (axis_->motor_.is_armed_) {
+            anticogging_sweep_update();
+        } else {
+            anticogging_sweep_.phase = AnticoggingSweep_t::PHASE_IDLE; // abort
+        }
+    }
+
     // Never command a setpoint beyond its limit
     if(config_.enable_vel_limit) {
         vel_setpoint_ = std::clamp(vel_setpoint_, -config_.vel_limit, config_.vel_limit);
@@ -293,25 +731,27 @@ bool Controller::update() {
     // TODO Decide if we want to use encoder or pll position here
     float gain_scheduling_multiplier = 1.0f;
     float vel_des = vel_setpoint_;
-    if (config_.control_mode >= CONTROL_MODE_POSITION_CONTROL) {
+    if (CM >= CONTROL_MODE_POSITION_CONTROL) {
         float pos_err;
 
-        if (config_.circular_setpoints) {
-            if (!pos_estimate_circular.has_value() || !pos_wrap.has_value()) {
+        if (CIRCULAR) {
+            if (!est.pos_estimate_circular.has_value() || !est.pos_wrap.has_value()) {
                 set_error(ERROR_INVALID_ESTIMATE);
                 return false;
             }
             // Keep pos setpoint from drifting
-            pos_setpoint_ = fmodf_pos(pos_setpoint_, *pos_wrap);
+            float pos_setpoint = fmodf_pos(pos_setpoint_.to_float(), *est.pos_wrap);
+            pos_setpoint_ = pos_setpoint;
             // Circular delta
-            pos_err = pos_setpoint_ - *pos_estimate_circular;
-            pos_err = wrap_pm(pos_err, *pos_wrap);
+            pos_err = pos_setpoint - *est.pos_estimate_circular;
+            pos_err = wrap_pm(pos_err, *est.pos_wrap);
         } else {
-            if (!pos_estimate_linear.has_value()) {
+            if (!est.pos_estimate_linear.has_value()) {
                 set_error(ERROR_INVALID_ESTIMATE);
                 return false;
             }
-            pos_err = pos_setpoint_ - *pos_estimate_linear;
+            // Exact difference, also far from zero
+            pos_err = pos_setpoint_ - *est.pos_estimate_linear;
         }
 
         vel_des += config_.pos_gain * pos_err;
@@ -330,11 +770,11 @@ bool Controller::update() {
 
     // Check for overspeed fault (done in this module (controller) for cohesion with vel_lim)
     if (config_.enable_overspeed_error) {  // 0.0f to disable
-        if (!vel_estimate.has_value()) {
+        if (!est.vel_estimate.has_value()) {
             set_error(ERROR_INVALID_ESTIMATE);
             return false;
         }
-        if (std::abs(*vel_estimate) > config_.vel_limit_tolerance * vel_lim) {
+        if (std::abs(*est.vel_estimate) > config_.vel_limit_tolerance * vel_lim) {
             set_error(ERROR_OVERSPEED);
             return false;
         }
@@ -344,7 +784,7 @@ bool Controller::update() {
     // Torque per amp gain scheduling (ACIM)
     float vel_gain = config_.vel_gain;
     float vel_integrator_gain = config_.vel_integrator_gain;
-    if (axis_->motor_.config_.motor_type == Motor::MOTOR_TYPE_ACIM) {
+    if (ACIM) {
         float effective_flux = axis_->acim_estimator_.rotor_flux_;
         float minflux = axis_->motor_.config_.acim_gain_min_flux;
         if (std::abs(effective_flux) < minflux)
@@ -360,37 +800,64 @@ bool Controller::update() {
 
     // Anti-cogging is enabled after calibration
     // We get the current position and apply a current feed-forward
-    // ensuring that we handle negative encoder positions properly (-1 == motor->encoder.encoder_cpr - 1)
+    // interpolated between the two nearest bins of the cogging map
     if (anticogging_valid_ && config_.anticogging.anticogging_enabled) {
-        if (!anticogging_pos_estimate.has_value()) {
+        if (!est.anticogging_pos_estimate.has_value()) {
             set_error(ERROR_INVALID_ESTIMATE);
             return false;
         }
-        float anticogging_pos = *anticogging_pos_estimate / axis_->encoder_.getCoggingRatio();
-        torque += config_.anticogging.cogging_map[std::clamp(mod((int)anticogging_pos, 3600), 0, 3600)];
+        torque += config_.anticogging.cogging_map.interpolate(est.anticogging_pos_estimate->frac());
     }
 
+    // Velocity feedback for the velocity loop. The filter also runs in torque
+    // control so that it is settled when the control mode changes.
+    float vel_feedback = est.vel_estimate.has_value() ? vel_estimate_filter_.step(*est.vel_estimate) : 0.0f;
+
     float v_err = 0.0f;
-    if (config_.control_mode >= CONTROL_MODE_VELOCITY_CONTROL) {
-        if (!vel_estimate.has_value()) {
+    if (CM >= CONTROL_MODE_VELOCITY_CONTROL) {
+        if (!est.vel_estimate.has_value()) {
             set_error(ERROR_INVALID_ESTIMATE);
             return false;
         }
 
-        v_err = vel_des - *vel_estimate;
+        v_err = vel_des - vel_feedback;
         torque += (vel_gain * gain_scheduling_multiplier) * v_err;
 
         // Velocity integral action before limiting
         torque += vel_integrator_torque_;
     }
 
+    // Disturbance observer
+    // The load torque is what is left of the last torque output after
+    // accelerating the inertia: T_load = T - J * dv/dt. This is low pass
+    // filtered with the observer bandwidth L. The filter is rearranged as
+    // LPF(T + L*J*v) - L*J*v so that the velocity is not differentiated.
+    if (config_.enable_disturbance_observer && CM >= CONTROL_MODE_VELOCITY_CONTROL) {
+        if (!est.vel_estimate.has_value()) {
+            set_error(ERROR_INVALID_ESTIMATE);
+            return false;
+        }
+        float LJv = config_.disturbance_observer_bandwidth * config_.inertia * *est.vel_estimate;
+        float k = std::min(config_.disturbance_observer_bandwidth * current_meas_period, 1.0f);
+        disturbance_observer_state_ += k * (last_torque_ + LJv - disturbance_observer_state_);
+        load_torque_estimate_ = std::clamp(disturbance_observer_state_ - LJv, -Tlim, Tlim);
+        torque += load_torque_estimate_;
+    } else if (est.vel_estimate.has_value()) {
+        // Start from a zero estimate when the observer is enabled
+        disturbance_observer_state_ = config_.disturbance_observer_bandwidth * config_.inertia * *est.vel_estimate;
+        load_torque_estimate_ = 0.0f;
+    }
+
+    // Resonance suppression
+    torque = torque_filter_.step(torque);
+
     // Velocity limiting in current mode
-    if (config_.control_mode < CONTROL_MODE_VELOCITY_CONTROL && config_.enable_torque_mode_vel_limit) {
-        if (!vel_estimate.has_value()) {
+    if (CM < CONTROL_MODE_VELOCITY_CONTROL && config_.enable_torque_mode_vel_limit) {
+        if (!est.vel_estimate.has_value()) {
             set_error(ERROR_INVALID_ESTIMATE);
             return false;
         }
-        torque = limitVel(config_.vel_limit, *vel_estimate, vel_gain, torque);
+        torque = limitVel(config_.vel_limit, *est.vel_estimate, vel_gain, torque);
     }
 
     // Torque limiting
@@ -404,8 +871,17 @@ bool Controller::update() {
         torque = -Tlim;
     }
 
+    last_torque_ = torque;
+
+    if (is_anticogging_sweep_active()) {
+        std::optional<Position> motor_pos_estimate = axis_->encoder_.pos_estimate_.present();
+        if (motor_pos_estimate.has_value()) {
+            anticogging_sweep_record(*motor_pos_estimate - Position::from_parts(anticogging_sweep_.origin, 0.0f), torque);
+        }
+    }
+
     // Velocity integrator (behaviour dependent on limiting)
-    if (config_.control_mode < CONTROL_MODE_VELOCITY_CONTROL) {
+    if (CM < CONTROL_MODE_VELOCITY_CONTROL) {
         // reset integral if not in use
         vel_integrator_torque_ = 0.0f;
     } else {
@@ -428,7 +904,7 @@ bool Controller::update() {
     else {
         ideal_electrical_power = axis_->motor_.current_control_.power_;
     }
-    mechanical_power_ += config_.mechanical_power_bandwidth * current_meas_period * (torque * *vel_estimate * M_PI * 2.0f - mechanical_power_);
+    mechanical_power_ += config_.mechanical_power_bandwidth * current_meas_period * (torque * *est.vel_estimate * M_PI * 2.0f - mechanical_power_);
     electrical_power_ += config_.electrical_power_bandwidth * current_meas_period * (ideal_electrical_power - electrical_power_);
 
     // Spinout check
@@ -1,19 +1,67 @@
 #ifndef __CONTROLLER_HPP
 #define __CONTROLLER_HPP
 
+#include "biquad_filter.hpp"
+#include "cogging_map.hpp"
+#include "frequency_response_analyzer.hpp"
+#include "position.hpp"
+#include "pvt_buffer.hpp"
+
 class Controller : public ODriveIntf::ControllerIntf {
 public:
     struct Anticogging_t {
         uint32_t index = 0;
-        float cogging_map[3600];
+        CoggingMap cogging_map;
         bool pre_calibrated = false;
         bool calib_anticogging = false;
         float calib_pos_threshold = 1.0f;
         float calib_vel_threshold = 1.0f;
         float cogging_ratio = 1.0f;
         bool anticogging_enabled = true;
+        float calib_sweep_vel = 0.2f;     // [turn/s]
+        uint32_t calib_sweep_turns = 1;   // turns recorded in each direction
+        float calib_quality = 0.0f;       // RMS cogging torque (without noise) divided by calib_noise_rms
+        float calib_noise_rms = 0.0f;     // [Nm] estimated RMS error of the map
+        float calib_friction = 0.0f;      // [Nm] friction that was cancelled by averaging both directions
+    };
+
+    struct AnticoggingSweep_t {
+        enum Phase {
+            PHASE_IDLE,
+            PHASE_RAMP_UP,
+            PHASE_FORWARD,
+            PHASE_REVERSE,
+            PHASE_BACKWARD,
+            PHASE_RAMP_DOWN,
+        };
+        Phase phase = PHASE_IDLE;
+        int64_t origin = 0;        // [turn] whole turns from which pos and rec_start count
+        float pos = 0.0f;          // [turn] position setpoint of the sweep
+        float vel = 0.0f;          // [turn/s] velocity setpoint of the sweep
+        float rec_start = 0.0f;    // [turn] start of the recorded range, on a boundary between two bins
+        uint32_t rec_bin = 0;      // bin that ends at rec_start
+        int32_t visit = -1;        // bin visits since the start of the recording
+        float visit_sum = 0.0f;    // [Nm]
+        uint32_t visit_samples = 0;
+        float dir_sum[2] = {};     // [Nm] sum of the visit means of the forward and backward sweep
+        uint32_t dir_visits[2] = {};
     };
 
+    struct FilterSection_t {
+        FilterType type = FILTER_TYPE_NONE;
+        float frequency = 300.0f; // [Hz]
+        float q = 1.0f;
+        float depth = 1.0f;
+
+        // custom setters
+        Controller* parent;
+        void set_type(FilterType value) { type = value; parent->update_biquad_filters(); }
+        void set_frequency(float value) { frequency = value; parent->update_biquad_filters(); }
+        void set_q(float value) { q = value; parent->update_biquad_filters(); }
+        void set_depth(float value) { depth = value; parent->update_biquad_filters(); }
+    };
+    static constexpr size_t kNumFilterSections = 4;
+
     struct Autotuning_t {
         float frequency = 0.0f;
         float pos_amplitude = 0.0f;
@@ -53,12 +101,17 @@ public:
         float electrical_power_bandwidth = 20.0f; // [rad/s] filter cutoff for electrical power for spinout detection
         float spinout_electrical_power_threshold = 10.0f; // [W] electrical power threshold for spinout detection
         float spinout_mechanical_power_threshold = -10.0f; // [W] mechanical power threshold for spinout detection
+        bool enable_disturbance_observer = false; // requires inertia to be set
+        float disturbance_observer_bandwidth = 100.0f; // [rad/s]
+        FilterSection_t torque_filters[kNumFilterSections];
+        FilterSection_t vel_estimate_filters[kNumFilterSections];
 
         // custom setters
         Controller* parent;
         void set_input_filter_bandwidth(float value) { input_filter_bandwidth = value; parent->update_filter_gains(); }
         void set_steps_per_circular_range(uint32_t value) { steps_per_circular_range = value > 0 ? value : steps_per_circular_range; }
         void set_control_mode(ControlMode value) { control_mode = value; parent->control_mode_updated(); }
+        void set_input_mode(InputMode value) { input_mode = value; parent->select_update_fn(); }
     };
 
     
@@ -71,63 +124,122 @@ public:
         input_pos_updated_ = true;
     }
     bool control_mode_updated();
-    void set_input_pos_and_steps(float pos);
+    void set_input_pos_and_steps(const Position& pos);
+    void write_input_pos(const Position& pos);
 
     bool select_encoder(size_t encoder_num);
 
     // Trajectory-Planned control
-    void move_to_pos(float goal_point);
+    void move_to_pos(const Position& goal_point);
+    void move_to_pos_scurve(const Position& goal_point);
+    void move_to_pos_timed(float goal_point, float move_time) {
+        // Only trapezoidal moves can be stretched. In any other input mode
+        // move_time would linger until the next trapezoidal move.
+        if (config_.input_mode != INPUT_MODE_TRAP_TRAJ) {
+            return;
+        }
+        set_input_pos_and_steps(goal_point);
+        input_move_time_ = move_time;
+        input_pos_updated();
+    }
+    float get_move_time(const Position& goal_point);
     void move_incremental(float displacement, bool from_goal_point);
+
+    // Full resolution access to input_pos_ and pos_setpoint_ [turns]
+    void set_input_pos_turns(int64_t turns, float fraction) { set_input_pos_and_steps(Position::from_parts(turns, fraction)); input_pos_updated(); }
+    std::tuple<int64_t, float> get_pos_setpoint_turns();
+
+    // Streamed PVT setpoints (INPUT_MODE_PVT)
+    bool push_pvt_point(float pos, float vel, float dt) { return pvt_buffer_.push({pos, vel, dt}); }
+    void clear_pvt_buffer() { pvt_buffer_.clear(); }
     
     // TODO: make this more similar to other calibration loops
     void start_anticogging_calibration();
+    bool start_anticogging_sweep();
+    bool is_anticogging_sweep_active() const { return anticogging_sweep_.phase != AnticoggingSweep_t::PHASE_IDLE; }
     float remove_anticogging_bias();
-    bool anticogging_calibration(float pos_estimate, float vel_estimate);
+    bool anticogging_calibration(const Position& pos_estimate, float vel_estimate);
+    void anticogging_sweep_update();
+    void anticogging_sweep_record(float pos_estimate, float torque);
+    void anticogging_sweep_flush();
+    void anticogging_sweep_finish();
     
     float get_anticogging_value(uint32_t index) {
-        return (index < 3600) ? config_.anticogging.cogging_map[index] : 0.0f;
+        return config_.anticogging.cogging_map.get(index);
+    }
+
+    // Frequency response measurement (INPUT_MODE_TUNING)
+    bool start_frequency_response();
+    void stop_frequency_response() { frequency_response_.stop(); }
+    std::tuple<float, float, float, float, float, float, float> get_frequency_response(uint32_t index) {
+        const FrequencyResponseAnalyzer::Point_t& p = frequency_response_.result(index);
+        return {p.frequency, p.gain[0], p.phase[0], p.gain[1], p.phase[1], p.gain[2], p.phase[2]};
     }
 
     void update_filter_gains();
+    void update_biquad_filters();
     bool update();
 
+    // Specialized update routines, see update()
+    struct Estimates_t;
+    using UpdateFn = bool (Controller::*)();
+    using ControlFn = bool (Controller::*)(Estimates_t& est);
+    void select_update_fn();
+    template<InputMode IM, bool CIRCULAR> bool update_impl();
+    template<bool CIRCULAR> bool update_prologue(Estimates_t& est);
+    template<InputMode IM, bool CIRCULAR> bool update_input(Estimates_t& est);
+    template<ControlMode CM, bool CIRCULAR, bool ACIM> bool update_control(Estimates_t& est);
+
     Config_t config_;
     Axis* axis_ = nullptr; // set by Axis constructor
 
     Error error_ = ERROR_NONE;
     float last_error_time_ = 0.0f;
 
-    // Inputs
-    InputPort<float> pos_estimate_linear_src_;
-    InputPort<float> pos_estimate_circular_src_;
-    InputPort<float> vel_estimate_src_;
-    InputPort<float> pos_wrap_src_; 
-
-    float pos_setpoint_ = 0.0f; // [turns]
+    Position pos_setpoint_; // [turns]
     float vel_setpoint_ = 0.0f; // [turn/s]
     // float vel_setpoint = 800.0f; <sensorless example>
     float vel_integrator_torque_ = 0.0f;    // [Nm]
     float torque_setpoint_ = 0.0f;  // [Nm]
 
-    float input_pos_ = 0.0f;     // [turns]
+    Position input_pos_;         // [turns]
     float input_vel_ = 0.0f;     // [turn/s]
     float input_torque_ = 0.0f;  // [Nm]
+    float input_move_time_ = 0.0f; // [s] minimum duration of the next trapezoidal move
     float input_filter_kp_ = 0.0f;
     float input_filter_ki_ = 0.0f;
 
     Autotuning_t autotuning_;
     float autotuning_phase_ = 0.0f;
+    FrequencyResponseAnalyzer frequency_response_;
     
     bool input_pos_updated_ = false;
     
     bool trajectory_done_ = true;
+    Position scurve_origin_; // [turns] the S-curve trajectory is planned relative to this
+
+    PvtBuffer pvt_buffer_;
 
     bool anticogging_valid_ = false;
+    AnticoggingSweep_t anticogging_sweep_;
     float mechanical_power_ = 0.0f; // [W]
+    float load_torque_estimate_ = 0.0f; // [Nm]
+    float disturbance_observer_state_ = 0.0f; // [Nm] low pass filtered (torque + bandwidth * inertia * vel)
+    float last_torque_ = 0.0f; // [Nm] torque output of the previous iteration
     float electrical_power_ = 0.0f; // [W]
+    BiquadCascade<kNumFilterSections> torque_filter_;
+    BiquadCascade<kNumFilterSections> vel_estimate_filter_;
+
+    UpdateFn update_fn_ = nullptr;
+    ControlFn control_fn_ = nullptr;
+    ControlMode update_fn_control_mode_ = CONTROL_MODE_VOLTAGE_CONTROL; // configuration that update_fn_ and control_fn_ were selected for
+    InputMode update_fn_input_mode_ = INPUT_MODE_INACTIVE;
+    bool update_fn_circular_setpoints_ = false;
+    ODriveIntf::MotorIntf::MotorType update_fn_motor_type_ = ODriveIntf::MotorIntf::MOTOR_TYPE_HIGH_CURRENT;
 
     // Outputs
-    OutputPort<float> torque_output_ = 0.0f;
+    SignalOutput<float> torque_output_{SignalFrame::CONTROLLER_TORQUE_OUTPUT};
+    SignalOutput<float> circular_setpoint_range_{SignalFrame::CONTROLLER_CIRCULAR_SETPOINT_RANGE}; // config_.circular_setpoint_range, latched each iteration
 
     // custom setters
     void set_input_pos(float value) { set_input_pos_and_steps(value); input_pos_updated(); }
@@ -0,0 +1,105 @@
+#ifndef __DEAD_TIME_COMPENSATION_HPP
+#define __DEAD_TIME_COMPENSATION_HPP
+
+#include <algorithm>
+#include <optional>
+#include <stddef.h>
+#include <utility>
+
+#include "utils.hpp"
+
+/**
+ * @brief Model of the voltage error of the inverter, used to compensate it.
+ *
+ * During the dead time both FETs of a half bridge are off and the phase
+ * current flows through a body diode, so the phase voltage follows the current
+ * direction instead of the PWM. Together with the diode and FET drops this
+ * makes each phase voltage lower than commanded by `voltage` while the current
+ * flows into the motor and higher while it flows out. Around the zero crossing
+ * the current ripple and the FET capacitances make the error change gradually.
+ * This is modelled as a linear transition within +-`current`.
+ *
+ * In the dq frame the error ripples at six times the electrical frequency,
+ * which the current controller cannot follow at low speed. It also biases
+ * everything that uses the commanded voltage as the applied one.
+ */
+class DeadTimeCompensation {
+public:
+    DeadTimeCompensation(float voltage, float current)
+        : voltage_(voltage), inv_current_(1.0f / std::max(current, 1e-3f)) {}
+
+    /** @brief Voltage error [V] of a phase that carries the given current [A] */
+    float phase_error(float current) const {
+        return voltage_ * std::clamp(current * inv_current_, -1.0f, 1.0f);
+    }
+
+    /**
+     * @brief Returns the alpha-beta voltage [V] that must be added to the
+     * commanded voltage so that the inverter applies the commanded voltage at
+     * the given alpha-beta current [A].
+     */
+    std::pair<float, float> get_voltage(float Ialpha, float Ibeta) const {
+        float eA = phase_error(Ialpha);
+        float eB = phase_error(-0.5f * Ialpha + sqrt3_by_2 * Ibeta);
+        float eC = phase_error(-0.5f * Ialpha - sqrt3_by_2 * Ibeta);
+        return {(2.0f / 3.0f) * eA - (1.0f / 3.0f) * (eB + eC), one_by_sqrt3 * (eB - eC)};
+    }
+
+    /**
+     * @brief Alpha component of the voltage error [V] when the current I [A]
+     * flows along the alpha axis (I in phase A, -I/2 in phases B and C). This
+     * is what the calibration measures. It is 4/3 * voltage for currents above
+     * 2 * current.
+     */
+    float alpha_error(float I) const {
+        return (2.0f / 3.0f) * (phase_error(I) + phase_error(0.5f * I));
+    }
+
+    /**
+     * @brief Fits the model and the phase resistance to the voltages [V]
+     * needed to hold n >= 3 currents [A] along the alpha axis.
+     *
+     * The currents must be positive and sorted from largest to smallest. The
+     * first two must lie above 2 * current. They give the resistance (slope)
+     * and the voltage (offset). The remaining ones are expected to lie in the
+     * transition and give the current. If they are all above the transition,
+     * the current is set to half the smallest one.
+     *
+     * Returns std::nullopt if the resistance does not come out positive.
+     */
+    static std::optional<DeadTimeCompensation> fit(const float* currents, const float* voltages, size_t n, float* resistance) {
+        if (n < 3 || !(currents[0] > currents[1])) {
+            return std::nullopt;
+        }
+        float R = (voltages[0] - voltages[1]) / (currents[0] - currents[1]);
+        float offset = std::max(voltages[0] - R * currents[0], 0.0f);
+        if (!(R > 0.0f)) {
+            return std::nullopt;
+        }
+
+        // alpha_error(I) / offset is 0.75 x below x = I / current = 1, rises
+        // to 1 at x = 2 and stays there
+        float sum = 0.0f;
+        size_t count = 0;
+        for (size_t i = 2; i < n; ++i) {
+            float f = (voltages[i] - R * currents[i]) / offset;
+            if (f > 0.05f && f < 0.95f) {
+                float x = (f <= 0.75f) ? f / 0.75f : 4.0f * f - 2.0f;
+                sum += currents[i] / x;
+                count++;
+            }
+        }
+
+        *resistance = R;
+        return DeadTimeCompensation{0.75f * offset, count ? sum / (float)count : 0.5f * currents[n - 1]};
+    }
+
+    float get_voltage_magnitude() const { return voltage_; } // [V]
+    float get_transition_current() const { return 1.0f / inv_current_; } // [A]
+
+private:
+    float voltage_; // [V]
+    float inv_current_; // [1/A]
+};
+
+#endif // __DEAD_TIME_COMPENSATION_HPP
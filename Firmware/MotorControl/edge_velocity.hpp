@@ -0,0 +1,102 @@
+#ifndef __EDGE_VELOCITY_HPP
+#define __EDGE_VELOCITY_HPP
+
+#include <cmath>
+#include <stdint.h>
+
+/**
+ * @brief Velocity from the time between encoder edges (M/T method).
+ *
+ * The counts between two edges are divided by the time between the same two
+ * edges, so neither the count (M) nor the time (T) has a quantization error
+ * at its ends. At low speed this is exact to the resolution of the edge
+ * times, where counts per control period would give a staircase. At high
+ * speed a window spans several edges and is closed by the first edge at
+ * least min_window after its start.
+ *
+ * Between edges the speed can't be higher than the distance to the next edge
+ * per time since the last edge, so the estimate decays towards zero if the
+ * next edge is late. A reversal of the count direction starts over at zero speed, which also
+ * keeps an encoder that dithers on an edge at zero.
+ */
+class EdgeVelocityEstimator {
+public:
+    /**
+     * @param min_window: Minimum time between the edges that a velocity is
+     *        computed from [s]
+     * @param timeout: The estimate is zero once no edge was seen for this
+     *        long [s]
+     * @param max_edge_distance: Largest distance between two adjacent
+     *        edges [count]
+     */
+    void set_window(float min_window, float timeout, float max_edge_distance = 1.0f) {
+        min_window_ = min_window;
+        timeout_ = timeout;
+        max_edge_distance_ = max_edge_distance;
+    }
+
+    void reset() {
+        direction_ = 0;
+        vel_ = 0.0f;
+    }
+
+    float vel() const { return vel_; }
+
+    /**
+     * @brief Processes one sample of the count.
+     * @param dt: Time since the previous sample [s]
+     * @param delta: Counts since the previous sample
+     * @param edge_offset: Position of the edge that was crossed last,
+     *        relative to the nominal count boundary [count]. Zero except for
+     *        encoders with calibrated edges like hall sensors.
+     * @param edge_age: Time from the last edge to this sample [s]. Zero if
+     *        edges are only seen by sampling, in which case the edge times
+     *        are the sample times.
+     */
+    void update(float dt, int32_t delta, float edge_offset = 0.0f, float edge_age = 0.0f) {
+        window_time_ += dt;
+        since_edge_ += dt;
+
+        if (delta != 0) {
+            int32_t direction = (delta > 0) ? 1 : -1;
+            float distance = (float)delta + edge_offset - last_edge_offset_;
+            last_edge_offset_ = edge_offset;
+            since_edge_ = edge_age;
+            if (direction != direction_) {
+                // First edge after a standstill or a reversal
+                direction_ = direction;
+                vel_ = 0.0f;
+                window_distance_ = 0.0f;
+                window_time_ = edge_age;
+                return;
+            }
+            window_distance_ += distance;
+            float edge_time = window_time_ - edge_age;
+            if (edge_time >= min_window_ && edge_time > 0.0f) {
+                vel_ = window_distance_ / edge_time;
+                window_distance_ = 0.0f;
+                window_time_ = edge_age;
+            }
+        } else if (direction_ != 0 && since_edge_ >= timeout_) {
+            reset();
+        }
+
+        if (std::abs(vel_) * since_edge_ > max_edge_distance_) {
+            vel_ = (float)direction_ * max_edge_distance_ / since_edge_;
+        }
+    }
+
+private:
+    float min_window_ = 0.0f; // [s]
+    float timeout_ = INFINITY; // [s]
+    float max_edge_distance_ = 1.0f; // [count]
+
+    int32_t direction_ = 0; // of the last edge, 0 if there was none
+    float last_edge_offset_ = 0.0f; // [count]
+    float window_distance_ = 0.0f; // [count] from the first edge of the window to the last
+    float window_time_ = 0.0f; // [s] since the first edge of the window
+    float since_edge_ = 0.0f; // [s]
+    float vel_ = 0.0f; // [count/s]
+};
+
+#endif // __EDGE_VELOCITY_HPP
@@ -20,6 +20,8 @@ bool Encoder::apply_config(ODriveIntf::MotorIntf::MotorType motor_type) {
     config_.parent = this;
 
     update_pll_gains();
+    update_kalman_gains();
+    update_edge_timing();
 
     if (config_.pre_calibrated) {
         if (config_.mode == Encoder::MODE_HALL && config_.hall_polarity_calibrated)
@@ -43,7 +45,8 @@ void Encoder::setup() {
         .Mode = SPI_MODE_MASTER,
         .Direction = SPI_DIRECTION_2LINES,
         .DataSize = SPI_DATASIZE_16BIT,
-        .CLKPolarity = (mode_ == MODE_SPI_ABS_AEAT || mode_ == MODE_SPI_ABS_MA732) ? SPI_POLARITY_HIGH : SPI_POLARITY_LOW,
+        .CLKPolarity = (mode_ == MODE_SPI_ABS_AEAT || mode_ == MODE_SPI_ABS_MA732
+                        || mode_ == MODE_SPI_ABS_SSI || mode_ == MODE_SPI_ABS_BISS_C) ? SPI_POLARITY_HIGH : SPI_POLARITY_LOW,
         .CLKPhase = SPI_PHASE_2EDGE,
         .NSS = SPI_NSS_SOFT,
         .BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16,
@@ -57,6 +60,9 @@ void Encoder::setup() {
         abs_spi_dma_tx_[0] = 0x0000;
     }
 
+    pos_abs_multi_turn_ = std::nullopt;
+    abs_spi_turns_applied_ = false;
+
     if(mode_ & MODE_FLAG_ABS){
         abs_spi_cs_pin_init();
 
@@ -127,6 +133,33 @@ void Encoder::update_pll_gains() {
     }
 }
 
+void Encoder::update_kalman_gains() {
+    // Both noises are in counts, so the tracking bandwidth does not depend on
+    // the cpr, like the PLL bandwidth. Scaling the process noise with the cpr
+    // instead made the filter too slow for the velocity loop on coarse
+    // encoders.
+    bool converged = kalman_.set_noise(config_.kalman_process_noise, config_.kalman_measurement_noise, current_meas_period);
+    if (!converged && config_.estimator == ESTIMATOR_KALMAN) {
+        set_error(ERROR_UNSTABLE_GAIN);
+    }
+}
+
+void Encoder::update_edge_timing() {
+    // Calibrated hall edges are not equidistant, the velocity can only be
+    // bounded by the longest gap between them.
+    float max_edge_distance = 1.0f;
+    if (config_.mode == MODE_HALL) {
+        for (int i = 0; i < 6; i++) {
+            max_edge_distance = std::max(max_edge_distance, 1.0f + count_edge_offset(i + 1) - count_edge_offset(i));
+        }
+    }
+    // The setters run in the comms thread while update() steps the estimator
+    CRITICAL_SECTION() {
+        edge_velocity_.set_window(config_.edge_timing_window, edge_timing_timeout, max_edge_distance);
+        edge_velocity_.reset();
+    }
+}
+
 void Encoder::check_pre_calibrated() {
     // TODO: restoring config from python backup is fragile here (ACIM motor type must be set first)
     if (axis_->motor_.config_.motor_type != Motor::MOTOR_TYPE_ACIM) {
@@ -144,7 +177,7 @@ void Encoder::set_linear_count(int32_t count) {
 
     // Update states
     shadow_count_ = count;
-    pos_estimate_counts_ = (float)count;
+    pos_estimate_counts_ = Position::from_parts(count, 0.0f);
     tim_cnt_sample_ = count;
 
     //Write hardware last
@@ -181,7 +214,7 @@ bool Encoder::run_index_search() {
 }
 
 bool Encoder::run_direction_find() {
-    int32_t init_enc_val = shadow_count_;
+    int64_t init_enc_val = shadow_count_;
 
     Axis::LockinConfig_t lockin_config = axis_->config_.calibration_lockin;
     lockin_config.finish_distance = lockin_config.vel * 3.0f; // run for 3 seconds
@@ -319,6 +352,53 @@ bool Encoder::run_hall_phase_calibration() {
     }
 
     calibrate_hall_phase_ = false;
+    update_edge_timing();
+    return success;
+}
+
+// @brief Turns the motor in lockin for 10 turns and maps the difference
+// between the absolute encoder reading and the lockin angle over one turn.
+// The map corrects the reading from then on, see EncoderErrorMap.
+bool Encoder::run_error_map_calibration() {
+    if (!(mode_ & MODE_FLAG_ABS)) {
+        set_error(ERROR_UNSUPPORTED_ENCODER_MODE);
+        return false;
+    }
+
+    // The direction tells which way the reading should move with the lockin
+    if (config_.direction == 0 && !run_direction_find())
+        return false;
+    if (config_.direction == 0) {
+        set_error(ERROR_NO_RESPONSE);
+        return false;
+    }
+
+    Axis::LockinConfig_t lockin_config = axis_->config_.calibration_lockin;
+    float distance = 10.0f * 2.0f * M_PI * (float)axis_->motor_.config_.pole_pairs;
+    lockin_config.finish_distance = std::copysign(distance, lockin_config.vel);
+    lockin_config.finish_on_distance = true;
+    lockin_config.finish_on_enc_idx = false;
+    lockin_config.finish_on_vel = false;
+
+    auto loop_cb = [this](bool const_vel) {
+        if (const_vel)
+            sample_error_map_ = true;
+        // No need to cancel early
+        return true;
+    };
+
+    error_map_calib_.reset();
+    error_map_last_phase_ = std::nullopt;
+    calibrate_error_map_ = true;
+    bool success = axis_->run_lockin_spin(lockin_config, false, loop_cb);
+    calibrate_error_map_ = false;
+    sample_error_map_ = false;
+
+    // On failure the previous map stays in use
+    if (success)
+        success = error_map_calib_.finish(&config_.error_map);
+    if (success)
+        config_.error_map_calibrated = true;
     return success;
 }
 
@@ -361,15 +441,7 @@ bool Encoder::run_offset_calibration() {
         axis_->open_loop_controller_.phase_ = axis_->open_loop_controller_.initial_phase_ = wrap_pm_pi(0 - config_.calib_scan_distance / 2.0f);
 
         axis_->motor_.current_control_.enable_current_control_src_ = (axis_->motor_.config_.motor_type != Motor::MOTOR_TYPE_GIMBAL);
-        axis_->motor_.current_control_.Idq_setpoint_src_.connect_to(&axis_->open_loop_controller_.Idq_setpoint_);
-        axis_->motor_.current_control_.Vdq_setpoint_src_.connect_to(&axis_->open_loop_controller_.Vdq_setpoint_);
-        
-        axis_->motor_.current_control_.phase_src_.connect_to(&axis_->open_loop_controller_.phase_);
-        axis_->acim_estimator_.rotor_phase_src_.connect_to(&axis_->open_loop_controller_.phase_);
-
-        axis_->motor_.phase_vel_src_.connect_to(&axis_->open_loop_controller_.phase_vel_);
-        axis_->motor_.current_control_.phase_vel_src_.connect_to(&axis_->open_loop_controller_.phase_vel_);
-        axis_->acim_estimator_.rotor_phase_vel_src_.connect_to(&axis_->open_loop_controller_.phase_vel_);
+        axis_->wiring_ = &axis_->open_loop_wiring_;
     }
     axis_->wait_for_control_iteration();
 
@@ -388,7 +460,7 @@ bool Encoder::run_offset_calibration() {
     }
 
 
-    int32_t init_enc_val = shadow_count_;
+    int64_t init_enc_val = shadow_count_;
     uint32_t num_steps = 0;
     int64_t encvaluesum = 0;
 
@@ -494,6 +566,8 @@ void Encoder::sample_now() {
         case MODE_SPI_ABS_AEAT:
         case MODE_SPI_ABS_RLS:
         case MODE_SPI_ABS_MA732:
+        case MODE_SPI_ABS_SSI:
+        case MODE_SPI_ABS_BISS_C:
         {
             abs_spi_start_transaction();
             // Do nothing
@@ -531,7 +605,8 @@ bool Encoder::abs_spi_start_transaction() {
             spi_task_.ncs_gpio = abs_spi_cs_gpio_;
             spi_task_.tx_buf = (uint8_t*)abs_spi_dma_tx_;
             spi_task_.rx_buf = (uint8_t*)abs_spi_dma_rx_;
-            spi_task_.length = 1;
+            spi_task_.length = (mode_ == MODE_SPI_ABS_SSI || mode_ == MODE_SPI_ABS_BISS_C)
+                             ? sizeof(abs_spi_dma_rx_) / sizeof(abs_spi_dma_rx_[0]) : 1;
             spi_task_.on_complete = [](void* ctx, bool success) { ((Encoder*)ctx)->abs_spi_cb(success); };
             spi_task_.on_complete_ctx = this;
             spi_task_.next = nullptr;
@@ -560,7 +635,7 @@ uint8_t cui_parity(uint16_t v) {
 }
 
 void Encoder::abs_spi_cb(bool success) {
-    uint16_t pos;
+    int32_t pos;
 
     if (!success) {
         goto done;
@@ -595,6 +670,46 @@ void Encoder::abs_spi_cb(bool success) {
             pos = (rawVal >> 2) & 0x3fff;
         } break;
 
+        case MODE_SPI_ABS_SSI:
+        case MODE_SPI_ABS_BISS_C: {
+            uint32_t single_turn_bits = config_.abs_spi_single_turn_bits;
+            uint32_t multi_turn_bits = config_.abs_spi_multi_turn_bits;
+            // The position is stored in count_in_cpr_ and pos_abs_ (int32)
+            // and pos_cpr_counts_ (float), which limits it to 24 bits
+            if (single_turn_bits == 0 || single_turn_bits > 24 || multi_turn_bits > 16) {
+                set_error(ERROR_UNSUPPORTED_ENCODER_MODE);
+                goto done;
+            }
+            if (config_.cpr != (1 << single_turn_bits)) {
+                set_error(ERROR_CPR_POLEPAIRS_MISMATCH);
+                goto done;
+            }
+
+            uint64_t frame = 0;
+            for (uint16_t word : abs_spi_dma_rx_) {
+                frame = (frame << 16) | word;
+            }
+            uint64_t data;
+            bool valid = (mode_ == MODE_SPI_ABS_SSI)
+                       ? decode_ssi_frame(frame, single_turn_bits + multi_turn_bits, &data)
+                       : decode_biss_c_frame(frame, single_turn_bits + multi_turn_bits, &data);
+            if (!valid) {
+                goto done;
+            }
+            pos = (int32_t)(data & ((1U << single_turn_bits) - 1));
+
+            if (multi_turn_bits > 0 && !abs_spi_turns_applied_) {
+                // The multi-turn count is two's complement
+                int32_t turns = (int32_t)(data >> single_turn_bits);
+                if (turns >= (1 << (multi_turn_bits - 1))) {
+                    turns -= (1 << multi_turn_bits);
+                }
+                // The turns and the single-turn position are published as one
+                // value, so that update() never combines two different frames
+                pos_abs_multi_turn_ = (int64_t)turns * config_.cpr + pos;
+            }
+        } break;
+
         default: {
            set_error(ERROR_UNSUPPORTED_ENCODER_MODE);
            goto done;
@@ -627,10 +742,11 @@ void Encoder::abs_spi_cs_pin_init(){
 }
 
 // Note that this may return counts +1 or -1 without any wrapping
-int32_t Encoder::hall_model(float internal_pos) {
-    int32_t base_cnt = (int32_t)std::floor(internal_pos);
+int64_t Encoder::hall_model(const Position& internal_pos) {
+    int64_t base_cnt = internal_pos.whole();
 
-    float pos_in_range = fmodf_pos(internal_pos, 6.0f);
+    float pos_in_range = (float)(internal_pos.whole() % 6) + internal_pos.frac();
+    if (pos_in_range < 0.0f) pos_in_range += 6.0f;
     int pos_idx = (int)pos_in_range;
     if (pos_idx == 6) pos_idx = 5; // in case of rounding error
     int next_i = (pos_idx == 5) ? 0 : pos_idx+1;
@@ -648,6 +764,16 @@ int32_t Encoder::hall_model(float internal_pos) {
     return base_cnt;
 }
 
+// Position of the lower edge of the specified count, relative to the count.
+// This is zero except for hall sensors, which have calibrated edges.
+float Encoder::count_edge_offset(int64_t count) {
+    if (config_.mode != MODE_HALL)
+        return 0.0f;
+    int idx = (int)(count % 6);
+    if (idx < 0) idx += 6;
+    return wrap_pm(config_.hall_edge_phcnt[idx] - (float)idx, 6.0f);
+}
+
 bool Encoder::update() {
     // update internal encoder state.
     int32_t delta_enc = 0;
@@ -655,8 +781,6 @@ bool Encoder::update() {
 
     switch (mode_) {
         case MODE_INCREMENTAL: {
-            //TODO: use count_in_cpr_ instead as shadow_count_ can overflow
-            //or use 64 bit
             int16_t delta_enc_16 = (int16_t)tim_cnt_sample_ - (int16_t)shadow_count_;
             delta_enc = (int32_t)delta_enc_16; //sign extend
         } break;
@@ -732,7 +856,9 @@ bool Encoder::update() {
         case MODE_SPI_ABS_AMS:
         case MODE_SPI_ABS_CUI: 
         case MODE_SPI_ABS_AEAT:
-        case MODE_SPI_ABS_MA732: {
+        case MODE_SPI_ABS_MA732:
+        case MODE_SPI_ABS_SSI:
+        case MODE_SPI_ABS_BISS_C: {
             if (abs_spi_pos_updated_ == false) {
                 // Low pass filter the error
                 spi_error_rate_ += current_meas_period * (1.0f - spi_error_rate_);
@@ -746,6 +872,49 @@ bool Encoder::update() {
             }
 
             abs_spi_pos_updated_ = false;
+
+            if (pos_abs_multi_turn_.has_value()) {
+                // abs_spi_cb may preempt this, so the position is taken and
+                // further frames are stopped in one step
+                int64_t pos_abs_multi_turn = 0;
+                CRITICAL_SECTION() {
+                    pos_abs_multi_turn = pos_abs_multi_turn_.value();
+                    abs_spi_turns_applied_ = true;
+                    pos_abs_multi_turn_ = std::nullopt;
+                }
+                // Start the linear count at the absolute multi-turn position
+                // instead of within half a turn of zero. This is before the
+                // error map correction, which then moves the count by its
+                // usual delta even across the wrap. The rest of this update
+                // uses the single-turn position of the same frame.
+                pos_abs_latched = (int32_t)(pos_abs_multi_turn % config_.cpr);
+                if (pos_abs_latched < 0) {
+                    pos_abs_latched += config_.cpr;
+                }
+                shadow_count_ = pos_abs_multi_turn;
+                pos_estimate_counts_ = Position::from_parts(shadow_count_, 0.0f);
+                pos_cpr_counts_ = (float)pos_abs_latched;
+                count_in_cpr_ = pos_abs_latched;
+            }
+
+            if (calibrate_error_map_) {
+                auto maybe_phase = axis_->open_loop_controller_.phase_.any();
+                if (sample_error_map_ && maybe_phase) {
+                    float phase = maybe_phase.value();
+                    float ref_delta = 0.0f;
+                    if (error_map_last_phase_.has_value()) {
+                        ref_delta = (float)config_.direction * wrap_pm_pi(phase - error_map_last_phase_.value())
+                                  / (2.0f * M_PI * (float)axis_->motor_.config_.pole_pairs);
+                    }
+                    error_map_calib_.add((float)pos_abs_latched / (float)config_.cpr, ref_delta);
+                    error_map_last_phase_ = phase;
+                }
+            } else if (config_.error_map_calibrated) {
+                // Correct the reading before anything is derived from it
+                float error = config_.error_map.interpolate((float)pos_abs_latched / (float)config_.cpr);
+                pos_abs_latched = mod(pos_abs_latched - (int32_t)std::lround(error * (float)config_.cpr), config_.cpr);
+            }
+
             delta_enc = pos_abs_latched - count_in_cpr_; //LATCH
             delta_enc = mod(delta_enc, config_.cpr);
             if (delta_enc > config_.cpr/2) {
@@ -769,35 +938,111 @@ bool Encoder::update() {
     // Memory for pos_circular
     float pos_cpr_counts_last = pos_cpr_counts_;
 
-    //// run pll (for now pll is in units of encoder counts)
-    // Predict current pos
-    pos_estimate_counts_ += current_meas_period * vel_estimate_counts_;
-    pos_cpr_counts_      += current_meas_period * vel_estimate_counts_;
-    // Encoder model
-    auto encoder_model = [this](float internal_pos)->int32_t {
-        if (config_.mode == MODE_HALL)
-            return hall_model(internal_pos);
-        else
-            return (int32_t)std::floor(internal_pos);
-    };
-    // discrete phase detector
-    float delta_pos_counts = (float)(shadow_count_ - encoder_model(pos_estimate_counts_));
-    float delta_pos_cpr_counts = (float)(count_in_cpr_ - encoder_model(pos_cpr_counts_));
-    delta_pos_cpr_counts = wrap_pm(delta_pos_cpr_counts, (float)(config_.cpr));
-    delta_pos_cpr_counts_ += 0.1f * (delta_pos_cpr_counts - delta_pos_cpr_counts_); // for debug
-    // pll feedback
-    pos_estimate_counts_ += current_meas_period * pll_kp_ * delta_pos_counts;
-    pos_cpr_counts_ += current_meas_period * pll_kp_ * delta_pos_cpr_counts;
-    pos_cpr_counts_ = fmodf_pos(pos_cpr_counts_, (float)(config_.cpr));
-    vel_estimate_counts_ += current_meas_period * pll_ki_ * delta_pos_cpr_counts;
     bool snap_to_zero_vel = false;
-    if (std::abs(vel_estimate_counts_) < 0.5f * current_meas_period * pll_ki_) {
-        vel_estimate_counts_ = 0.0f;  //align delta-sigma on zero to prevent jitter
-        snap_to_zero_vel = true;
+    if (config_.estimator == ESTIMATOR_KALMAN) {
+        //// run Kalman tracker (in units of encoder counts)
+        // Innovation of a count measurement, given the count minus the
+        // estimated position:
+        // - After a single step the position was at the edge that was just
+        //   crossed. Without an edge timestamp the edge is assumed to be half
+        //   a period old.
+        // - While the count does not change, it only tells that the position
+        //   is between the edges of the count.
+        // - After larger steps the quantization is noise around the middle of
+        //   the count.
+        auto innovation = [&](int64_t count, float count_minus_pos) {
+            float lower = count_minus_pos + count_edge_offset(count);
+            float upper = count_minus_pos + 1.0f + count_edge_offset(count + 1);
+            float age = 0.5f * current_meas_period;
+            if (delta_enc == 1)
+                return kalman_.edge_innovation(lower, vel_estimate_counts_, age);
+            else if (delta_enc == -1)
+                return kalman_.edge_innovation(upper, vel_estimate_counts_, age);
+            else if (delta_enc == 0)
+                return KalmanTracker::interval_innovation(lower, upper);
+            return 0.5f * (lower + upper);
+        };
+
+        Position pos_last = pos_estimate_counts_;
+        kalman_.predict(pos_estimate_counts_, vel_estimate_counts_);
+        pos_cpr_counts_ += pos_estimate_counts_ - pos_last;
+        float innovation_linear = innovation(shadow_count_, (float)(shadow_count_ - pos_estimate_counts_.whole()) - pos_estimate_counts_.frac());
+        float innovation_cpr = innovation(count_in_cpr_, wrap_pm((float)count_in_cpr_ - pos_cpr_counts_, (float)(config_.cpr)));
+        delta_pos_cpr_counts_ += 0.1f * (innovation_cpr - delta_pos_cpr_counts_); // for debug
+
+        // At low speed the uncertain age of an edge moves it by less than the
+        // measurement noise, so the position is set to the edge.
+        bool exact_edge = (delta_enc == 1 || delta_enc == -1)
+                       && std::abs(vel_estimate_counts_) * current_meas_period < config_.kalman_measurement_noise;
+        if (exact_edge) {
+            kalman_.correct_exact(pos_estimate_counts_, vel_estimate_counts_, innovation_linear);
+            pos_cpr_counts_ += innovation_cpr;
+        } else {
+            kalman_.correct(pos_estimate_counts_, vel_estimate_counts_, innovation_linear);
+            pos_cpr_counts_ += kalman_.gains().pos * innovation_cpr;
+        }
+        pos_cpr_counts_ = fmodf_pos(pos_cpr_counts_, (float)(config_.cpr));
+
+        if (delta_enc != 0) {
+            kalman_cycles_in_count_ = 0;
+        } else if (kalman_cycles_in_count_ < UINT32_MAX) {
+            kalman_cycles_in_count_++;
+        }
+        if (delta_enc == 0 && innovation_linear == 0.0f) {
+            // Inside a count there is nothing to correct the acceleration
+            // with, so it is dropped. The speed can't be more than one count
+            // per time since the last edge.
+            kalman_.reset();
+            float max_vel = 1.0f / ((float)kalman_cycles_in_count_ * current_meas_period);
+            vel_estimate_counts_ = std::clamp(vel_estimate_counts_, -max_vel, max_vel);
+            snap_to_zero_vel = vel_estimate_counts_ == 0.0f;
+        }
+    } else {
+        //// run pll (for now pll is in units of encoder counts)
+        // With ESTIMATOR_EDGE_TIMING the velocity comes from the time between
+        // edges and the PLL only tracks the position. Edges are seen when the
+        // count is sampled, so their time is the time of this update.
+        if (config_.estimator == ESTIMATOR_EDGE_TIMING) {
+            float edge_offset = 0.0f;
+            if (delta_enc > 0)
+                edge_offset = count_edge_offset(shadow_count_);
+            else if (delta_enc < 0)
+                edge_offset = count_edge_offset(shadow_count_ + 1);
+            edge_velocity_.update(current_meas_period, delta_enc, edge_offset);
+            vel_estimate_counts_ = edge_velocity_.vel();
+        }
+        // Predict current pos
+        pos_estimate_counts_ += current_meas_period * vel_estimate_counts_;
+        pos_cpr_counts_      += current_meas_period * vel_estimate_counts_;
+        // Encoder model
+        auto encoder_model = [this](const Position& internal_pos)->int64_t {
+            if (config_.mode == MODE_HALL)
+                return hall_model(internal_pos);
+            else
+                return internal_pos.whole();
+        };
+        // discrete phase detector
+        float delta_pos_counts = (float)(shadow_count_ - encoder_model(pos_estimate_counts_));
+        float delta_pos_cpr_counts = (float)(count_in_cpr_ - encoder_model(Position{pos_cpr_counts_}));
+        delta_pos_cpr_counts = wrap_pm(delta_pos_cpr_counts, (float)(config_.cpr));
+        delta_pos_cpr_counts_ += 0.1f * (delta_pos_cpr_counts - delta_pos_cpr_counts_); // for debug
+        // pll feedback
+        pos_estimate_counts_ += current_meas_period * pll_kp_ * delta_pos_counts;
+        pos_cpr_counts_ += current_meas_period * pll_kp_ * delta_pos_cpr_counts;
+        pos_cpr_counts_ = fmodf_pos(pos_cpr_counts_, (float)(config_.cpr));
+        if (config_.estimator == ESTIMATOR_EDGE_TIMING) {
+            snap_to_zero_vel = vel_estimate_counts_ == 0.0f;
+        } else {
+            vel_estimate_counts_ += current_meas_period * pll_ki_ * delta_pos_cpr_counts;
+            if (std::abs(vel_estimate_counts_) < 0.5f * current_meas_period * pll_ki_) {
+                vel_estimate_counts_ = 0.0f;  //align delta-sigma on zero to prevent jitter
+                snap_to_zero_vel = true;
+            }
+        }
     }
 
     // Outputs from Encoder for Controller
-    pos_estimate_ = pos_estimate_counts_ / (float)config_.cpr;
+    pos_estimate_ = Position::from_counts(pos_estimate_counts_, config_.cpr);
     vel_estimate_ = vel_estimate_counts_ / (float)config_.cpr;
     
     // TODO: we should strictly require that this value is from the previous iteration
@@ -8,6 +8,10 @@ class Encoder;
 #include "utils.hpp"
 #include <autogen/interfaces.hpp>
 #include "component.hpp"
+#include "kalman_tracker.hpp"
+#include "edge_velocity.hpp"
+#include "encoder_error_map.hpp"
+#include "ssi_biss_frame.hpp"
 
 
 class Encoder : public ODriveIntf::EncoderIntf {
@@ -15,6 +19,7 @@ public:
     static constexpr uint32_t MODE_FLAG_ABS = 0x100;
     static constexpr std::array<float, 6> hall_edge_defaults = 
         {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f};
+    static constexpr float edge_timing_timeout = 1.0f; // [s] zero velocity without edges for this long
 
     struct Config_t {
         Mode mode = MODE_INCREMENTAL;
@@ -22,6 +27,10 @@ public:
         float calib_scan_distance = 16.0f * M_PI; // rad electrical
         float calib_scan_omega = 4.0f * M_PI; // rad/s electrical
         float bandwidth = 1000.0f;
+        Estimator estimator = ESTIMATOR_PLL;
+        float kalman_process_noise = 8e5f; // [count/s^3/sqrt(Hz)]
+        float kalman_measurement_noise = 0.29f; // [count] about the quantization noise 1/sqrt(12)
+        float edge_timing_window = 0.002f; // [s]
         int32_t phase_offset = 0;        // Offset between encoder count and rotor electrical phase
         float phase_offset_float = 0.0f; // Sub-count phase alignment offset
         int32_t cpr = (2048 * 4);   // Default resolution of CUI-AMT102 encoder,
@@ -41,8 +50,12 @@ public:
         bool hall_polarity_calibrated = false;
         std::array<float, 6> hall_edge_phcnt = hall_edge_defaults;
         uint16_t abs_spi_cs_gpio_pin = 1;
+        uint8_t abs_spi_single_turn_bits = 18; // SSI and BiSS-C only, cpr must be 2^abs_spi_single_turn_bits
+        uint8_t abs_spi_multi_turn_bits = 0; // SSI and BiSS-C only
         uint16_t sincos_gpio_pin_sin = 3;
         uint16_t sincos_gpio_pin_cos = 4;
+        bool error_map_calibrated = false; // If true, readings of absolute encoders are corrected by error_map
+        EncoderErrorMap error_map;
 
 
         // custom setters
@@ -52,6 +65,10 @@ public:
         void set_abs_spi_cs_gpio_pin(uint16_t value) { abs_spi_cs_gpio_pin = value; parent->abs_spi_cs_pin_init(); }
         void set_pre_calibrated(bool value) { pre_calibrated = value; parent->check_pre_calibrated(); }
         void set_bandwidth(float value) { bandwidth = value; parent->update_pll_gains(); }
+        void set_estimator(Estimator value) { estimator = value; parent->update_kalman_gains(); parent->update_edge_timing(); }
+        void set_kalman_process_noise(float value) { kalman_process_noise = value; parent->update_kalman_gains(); }
+        void set_kalman_measurement_noise(float value) { kalman_measurement_noise = value; parent->update_kalman_gains(); }
+        void set_edge_timing_window(float value) { edge_timing_window = value; parent->update_edge_timing(); }
     };
 
     Encoder(TIM_HandleTypeDef* timer, Stm32Gpio index_gpio,
@@ -66,9 +83,15 @@ public:
     void enc_index_cb();
     void set_idx_subscribe(bool override_enable = false);
     void update_pll_gains();
+    void update_kalman_gains();
+    void update_edge_timing();
     void check_pre_calibrated();
 
     void set_linear_count(int32_t count);
+    std::tuple<int64_t, float> get_pos_estimate_turns() {
+        Position pos = pos_estimate_.any().value_or(Position{});
+        return {pos.whole(), pos.frac()};
+    }
     void set_circular_count(int32_t count, bool update_offset);
     bool calib_enc_offset(float voltage_magnitude);
 
@@ -76,11 +99,14 @@ public:
     bool run_direction_find();
     bool run_hall_polarity_calibration();
     bool run_hall_phase_calibration();
+    bool run_error_map_calibration();
+    float get_error_map_value(uint32_t index) { return config_.error_map.get(index); }
     bool run_offset_calibration();
     void sample_now();
     bool read_sampled_gpio(Stm32Gpio gpio);
     void decode_hall_samples();
-    int32_t hall_model(float internal_pos);
+    int64_t hall_model(const Position& internal_pos);
+    float count_edge_offset(int64_t count);
     bool update();
 
     TIM_HandleTypeDef* timer_;
@@ -96,24 +122,29 @@ public:
     Error error_ = ERROR_NONE;
     bool index_found_ = false;
     bool is_ready_ = false;
-    int32_t shadow_count_ = 0;
+    int64_t shadow_count_ = 0;
     int32_t count_in_cpr_ = 0;
     float interpolation_ = 0.0f;
-    OutputPort<float> phase_ = 0.0f;     // [rad]
-    OutputPort<float> phase_vel_ = 0.0f; // [rad/s]
-    float pos_estimate_counts_ = 0.0f;  // [count]
+    SignalOutput<float> phase_{SignalFrame::ENCODER_PHASE};         // [rad]
+    SignalOutput<float> phase_vel_{SignalFrame::ENCODER_PHASE_VEL}; // [rad/s]
+    Position pos_estimate_counts_;  // [count]
     float pos_cpr_counts_ = 0.0f;  // [count]
     float delta_pos_cpr_counts_ = 0.0f;  // [count] phase detector result for debug
     float vel_estimate_counts_ = 0.0f;  // [count/s]
     float pll_kp_ = 0.0f;   // [count/s / count]
     float pll_ki_ = 0.0f;   // [(count/s^2) / count]
+    KalmanTracker kalman_;  // used instead of the PLL with ESTIMATOR_KALMAN, in counts
+    uint32_t kalman_cycles_in_count_ = 0;  // control periods since the count changed
+    EdgeVelocityEstimator edge_velocity_;  // velocity with ESTIMATOR_EDGE_TIMING, in counts
     float calib_scan_response_ = 0.0f; // debug report from offset calib
     int32_t pos_abs_ = 0;
+    std::optional<int64_t> pos_abs_multi_turn_ = std::nullopt; // [count] multi-turn position of a valid frame, until update() applies it
+    bool abs_spi_turns_applied_ = false;
     float spi_error_rate_ = 0.0f;
 
-    OutputPort<float> pos_estimate_ = 0.0f; // [turn]
-    OutputPort<float> vel_estimate_ = 0.0f; // [turn/s]
-    OutputPort<float> pos_circular_ = 0.0f; // [turn]
+    SignalOutput<Position> pos_estimate_{SignalFrame::ENCODER_POS_ESTIMATE}; // [turn]
+    SignalOutput<float> vel_estimate_{SignalFrame::ENCODER_VEL_ESTIMATE}; // [turn/s]
+    SignalOutput<float> pos_circular_{SignalFrame::ENCODER_POS_CIRCULAR}; // [turn]
 
     bool pos_estimate_valid_ = false;
     bool vel_estimate_valid_ = false;
@@ -129,6 +160,10 @@ public:
     bool sample_hall_phase_ = false;
     std::array<int, 8> states_seen_count_; // for hall polarity calibration
     std::array<int, 6> hall_phase_calib_seen_count_;
+    bool calibrate_error_map_ = false;
+    bool sample_error_map_ = false;
+    std::optional<float> error_map_last_phase_ = std::nullopt; // [rad]
+    EncoderErrorCalibration error_map_calib_;
 
     float sincos_sample_s_ = 0.0f;
     float sincos_sample_c_ = 0.0f;
@@ -141,14 +176,10 @@ public:
     Stm32Gpio abs_spi_cs_gpio_;
     uint32_t abs_spi_cr1;
     uint32_t abs_spi_cr2;
-    uint16_t abs_spi_dma_tx_[1] = {0xFFFF};
-    uint16_t abs_spi_dma_rx_[1];
+    uint16_t abs_spi_dma_tx_[4] = {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF}; // SSI and BiSS-C use all 64 bits, all other modes only the first word
+    uint16_t abs_spi_dma_rx_[4];
     Stm32SpiArbiter::SpiTask spi_task_;
 
-    constexpr float getCoggingRatio(){
-        return 1.0f / 3600.0f;
-    }
-
 };
 
 #endif // __ENCODER_HPP
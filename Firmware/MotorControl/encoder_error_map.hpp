@@ -0,0 +1,130 @@
+#ifndef __ENCODER_ERROR_MAP_HPP
+#define __ENCODER_ERROR_MAP_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdint.h>
+
+/**
+ * @brief Position error of an absolute encoder as a function of its reading,
+ * sampled at kBins equally spaced positions over one turn.
+ *
+ * Off-axis mounts and magnet eccentricity mostly give a once and twice per
+ * turn error, which kBins samples with linear interpolation resolve to a
+ * small fraction of their amplitude. Finer non-linearity is captured up to
+ * kBins / 2 cycles per turn.
+ *
+ * This is part of the encoder config and is stored in NVM as-is, so it must
+ * stay trivially copyable.
+ */
+class EncoderErrorMap {
+public:
+    static constexpr uint32_t kBins = 128;
+
+    void clear() {
+        std::fill(std::begin(map_), std::end(map_), 0.0f);
+    }
+
+    float get(uint32_t index) const {
+        return (index < kBins) ? map_[index] : 0.0f;
+    }
+
+    void set(uint32_t index, float error) {
+        if (index < kBins && std::isfinite(error)) {
+            map_[index] = error;
+        }
+    }
+
+    /**
+     * @brief Returns the interpolated error [turn] at the specified encoder
+     * reading [turn]. The reading does not need to be wrapped.
+     */
+    float interpolate(float pos) const {
+        float x = (pos - std::floor(pos)) * (float)kBins;
+        uint32_t i0 = std::min((uint32_t)x, kBins - 1);
+        uint32_t i1 = (i0 + 1 < kBins) ? i0 + 1 : 0;
+        float frac = x - (float)i0;
+        return map_[i0] + frac * (map_[i1] - map_[i0]);
+    }
+
+private:
+    float map_[kBins] = {}; // [turn]
+};
+
+/**
+ * @brief Builds an EncoderErrorMap from readings taken while the rotor turns
+ * by a known amount, e.g. in lockin spin at constant velocity.
+ *
+ * The reference position starts at the first reading and follows the known
+ * motion from there, so the error of a reading is its distance to the
+ * reference. Each bin averages the errors of the readings nearest to it.
+ * A constant offset between the reference and the rotor, such as the lag of
+ * the rotor behind the lockin field, does not matter because the mean is
+ * removed from the result.
+ */
+class EncoderErrorCalibration {
+public:
+    void reset() {
+        std::fill(std::begin(sum_), std::end(sum_), 0.0f);
+        std::fill(std::begin(count_), std::end(count_), 0);
+        started_ = false;
+    }
+
+    /**
+     * @param pos: Encoder reading [turn]
+     * @param ref_delta: Motion of the rotor since the previous reading [turn]
+     */
+    void add(float pos, float ref_delta) {
+        pos -= std::floor(pos);
+        if (!started_) {
+            ref_ = pos;
+            ref_compensation_ = 0.0f;
+            started_ = true;
+        } else {
+            // Compensated sum, the rounding errors of some 1e5 small steps
+            // would otherwise add up to the size of the errors to be measured
+            float y = ref_delta - ref_compensation_;
+            float t = ref_ + y;
+            ref_compensation_ = (t - ref_) - y;
+            ref_ = t - std::floor(t);
+        }
+        float error = pos - ref_;
+        error -= std::round(error); // wrap to [-0.5, 0.5]
+        uint32_t bin = (uint32_t)std::lround(pos * (float)EncoderErrorMap::kBins) % EncoderErrorMap::kBins;
+        sum_[bin] += error;
+        count_[bin]++;
+    }
+
+    /**
+     * @brief Writes the mean error of each bin, minus the mean over all bins,
+     * to map.
+     * @returns false if some bin was not visited, in which case map is left
+     * unchanged.
+     */
+    bool finish(EncoderErrorMap* map) const {
+        float mean[EncoderErrorMap::kBins];
+        float total = 0.0f;
+        for (uint32_t i = 0; i < EncoderErrorMap::kBins; ++i) {
+            if (count_[i] == 0) {
+                return false;
+            }
+            mean[i] = sum_[i] / (float)count_[i];
+            total += mean[i];
+        }
+        total /= (float)EncoderErrorMap::kBins;
+        for (uint32_t i = 0; i < EncoderErrorMap::kBins; ++i) {
+            map->set(i, mean[i] - total);
+        }
+        return true;
+    }
+
+private:
+    float sum_[EncoderErrorMap::kBins] = {}; // [turn]
+    uint32_t count_[EncoderErrorMap::kBins] = {};
+    float ref_ = 0.0f; // [turn]
+    float ref_compensation_ = 0.0f; // [turn]
+    bool started_ = false;
+};
+
+#endif // __ENCODER_ERROR_MAP_HPP
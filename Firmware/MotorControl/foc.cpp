@@ -1,6 +1,7 @@
 
 #include "foc.hpp"
-#include <board.h>
+#include "odrive_main.h"
+#include "sincos.hpp"
 
 Motor::Error AlphaBetaFrameController::on_measurement(
             std::optional<float> vbus_voltage,
@@ -32,7 +33,7 @@ Motor::Error AlphaBetaFrameController::get_output(
         return Motor::ERROR_MODULATION_IS_NAN;
     }
 
-    auto [tA, tB, tC, success] = SVM(mod_alpha_beta->first, mod_alpha_beta->second);
+    auto [tA, tB, tC, success] = SVM(mod_alpha_beta->first, mod_alpha_beta->second, svm_mode_, svm_sensed_phases_);
     if (!success) {
         return Motor::ERROR_MODULATION_MAGNITUDE;
     }
@@ -50,6 +51,8 @@ void FieldOrientedController::reset() {
     vbus_voltage_measured_ = std::nullopt;
     Ialpha_beta_measured_ = std::nullopt;
     power_ = 0.0f;
+    V_applied_alpha_beta_ = {0.0f, 0.0f};
+    I_predicted_alpha_beta_ = std::nullopt;
 }
 
 Motor::Error FieldOrientedController::on_measurement(
@@ -93,13 +96,13 @@ ODriveIntf::MotorIntf::Error FieldOrientedController::get_alpha_beta_output(
     float vbus_voltage = *vbus_voltage_measured_;
 
     std::optional<float2D> Idq;
+    float I_phase = phase + phase_vel * ((float)(int32_t)(i_timestamp_ - ctrl_timestamp_) / (float)TIM_1_8_CLOCK_HZ);
+    std::pair<float, float> sincos_I = fast_sincos(I_phase);
+    auto [s_I, c_I] = sincos_I;
 
     // Park transform
     if (Ialpha_beta_measured_.has_value()) {
         auto [Ialpha, Ibeta] = *Ialpha_beta_measured_;
-        float I_phase = phase + phase_vel * ((float)(int32_t)(i_timestamp_ - ctrl_timestamp_) / (float)TIM_1_8_CLOCK_HZ);
-        float c_I = our_arm_cos_f32(I_phase);
-        float s_I = our_arm_sin_f32(I_phase);
         Idq = {
             c_I * Ialpha + s_I * Ibeta,
             c_I * Ibeta - s_I * Ialpha
@@ -117,8 +120,82 @@ ODriveIntf::MotorIntf::Error FieldOrientedController::get_alpha_beta_output(
     float mod_d;
     float mod_q;
 
-    if (enable_current_control_) {
-        // Current control mode
+    // Angle for the inverse park transform. It is only a fraction of an
+    // electrical revolution ahead of I_phase, so it is derived by rotation.
+    float pwm_phase_delta = phase_vel * ((float)(int32_t)(output_timestamp - i_timestamp_) / (float)TIM_1_8_CLOCK_HZ);
+    auto [s_p, c_p] = sincos_rotate(sincos_I, I_phase, pwm_phase_delta);
+
+    if (enable_current_control_ && current_control_law_ == Motor::CURRENT_CONTROL_LAW_DEADBEAT) {
+        // Current control mode (deadbeat)
+
+        if (!deadbeat_gains_.has_value()) {
+            return Motor::ERROR_UNKNOWN_GAINS;
+        } else if (!Idq.has_value()) {
+            return Motor::ERROR_UNKNOWN_CURRENT_MEASUREMENT;
+        } else if (!Idq_setpoint_.has_value()) {
+            return Motor::ERROR_UNKNOWN_CURRENT_COMMAND;
+        }
+
+        // The output computed now only takes effect one control period after
+        // the current measurement. The law therefore predicts the current at
+        // the end of the period that is running now (using the voltage that
+        // is applied during it) and picks the voltage that moves the current
+        // from there to the setpoint within the next period. R and L are
+        // covered by the model. Everything else (mostly back-EMF) is tracked
+        // by a disturbance observer in v_current_control_integral_{d,q}_,
+        // which takes the place of the PI integrator.
+        auto [a, b, k_obs] = *deadbeat_gains_;
+        auto [Ialpha, Ibeta] = *Ialpha_beta_measured_;
+        auto [Id_setpoint, Iq_setpoint] = *Idq_setpoint_;
+        float phase_step = phase_vel * current_meas_period;
+
+        if (I_predicted_alpha_beta_.has_value()) {
+            float Ierr_alpha = Ialpha - I_predicted_alpha_beta_->first;
+            float Ierr_beta = Ibeta - I_predicted_alpha_beta_->second;
+            float Ierr_d = c_I * Ierr_alpha + s_I * Ierr_beta;
+            float Ierr_q = c_I * Ierr_beta - s_I * Ierr_alpha;
+            v_current_control_integral_d_ -= Ierr_d * (k_obs / b);
+            v_current_control_integral_q_ -= Ierr_q * (k_obs / b);
+        }
+
+        // Current at the end of the running period. The part of the applied
+        // voltage that compensates the disturbance (feed-forward plus
+        // observer) is not seen by the R-L model. It is evaluated in the
+        // middle of the period.
+        auto [s_m, c_m] = sincos_rotate(sincos_I, I_phase, 0.5f * phase_step);
+        float v_comp_d = Vd + v_current_control_integral_d_;
+        float v_comp_q = Vq + v_current_control_integral_q_;
+        float v_comp_alpha = c_m * v_comp_d - s_m * v_comp_q;
+        float v_comp_beta = c_m * v_comp_q + s_m * v_comp_d;
+        float I_next_alpha = a * Ialpha + b * (V_applied_alpha_beta_.first - v_comp_alpha);
+        float I_next_beta = a * Ibeta + b * (V_applied_alpha_beta_.second - v_comp_beta);
+        I_predicted_alpha_beta_ = {I_next_alpha, I_next_beta};
+
+        // Setpoint at the end of the next period, which ends half a period
+        // after output_timestamp.
+        auto [s_r, c_r] = sincos_rotate(sincos_I, I_phase, pwm_phase_delta + 0.5f * phase_step);
+        float I_ref_alpha = c_r * Id_setpoint - s_r * Iq_setpoint;
+        float I_ref_beta = c_r * Iq_setpoint + s_r * Id_setpoint;
+
+        float v_alpha = (I_ref_alpha - a * I_next_alpha) / b;
+        float v_beta = (I_ref_beta - a * I_next_beta) / b;
+
+        // V{d,q}_setpoint act as feed-forward terms in this mode
+        mod_d = V_to_mod * (Vd + v_current_control_integral_d_ + c_p * v_alpha + s_p * v_beta);
+        mod_q = V_to_mod * (Vq + v_current_control_integral_q_ + c_p * v_beta - s_p * v_alpha);
+
+        // Vector modulation saturation. The prediction uses the voltage that
+        // was actually applied, so no anti-windup is needed.
+        float mod_magnitude = std::sqrt(mod_d * mod_d + mod_q * mod_q);
+        mod_demand_ = mod_magnitude / max_mod;
+        float mod_scalefactor = max_mod * 1.0f / mod_magnitude;
+        if (mod_scalefactor < 1.0f) {
+            mod_d *= mod_scalefactor;
+            mod_q *= mod_scalefactor;
+        }
+
+    } else if (enable_current_control_) {
+        // Current control mode (PI)
 
         if (!pi_gains_.has_value()) {
             return Motor::ERROR_UNKNOWN_GAINS;
@@ -140,8 +217,9 @@ ODriveIntf::MotorIntf::Error FieldOrientedController::get_alpha_beta_output(
         mod_q = V_to_mod * (Vq + v_current_control_integral_q_ + Ierr_q * p_gain);
 
         // Vector modulation saturation, lock integrator if saturated
-        // TODO make maximum modulation configurable
-        float mod_scalefactor = 0.80f * sqrt3_by_2 * 1.0f / std::sqrt(mod_d * mod_d + mod_q * mod_q);
+        float mod_magnitude = std::sqrt(mod_d * mod_d + mod_q * mod_q);
+        mod_demand_ = mod_magnitude / max_mod;
+        float mod_scalefactor = max_mod * 1.0f / mod_magnitude;
         if (mod_scalefactor < 1.0f) {
             mod_d *= mod_scalefactor;
             mod_q *= mod_scalefactor;
@@ -157,18 +235,48 @@ ODriveIntf::MotorIntf::Error FieldOrientedController::get_alpha_beta_output(
         // Voltage control mode
         mod_d = V_to_mod * Vd;
         mod_q = V_to_mod * Vq;
+        mod_demand_ = std::sqrt(mod_d * mod_d + mod_q * mod_q) / max_mod;
+    }
+
+    if (!enable_current_control_ || current_control_law_ != Motor::CURRENT_CONTROL_LAW_DEADBEAT) {
+        I_predicted_alpha_beta_ = std::nullopt; // restart the observer when the deadbeat law becomes active
     }
 
     // Inverse park transform
-    float pwm_phase = phase + phase_vel * ((float)(int32_t)(output_timestamp - ctrl_timestamp_) / (float)TIM_1_8_CLOCK_HZ);
-    float c_p = our_arm_cos_f32(pwm_phase);
-    float s_p = our_arm_sin_f32(pwm_phase);
     float mod_alpha = c_p * mod_d - s_p * mod_q;
     float mod_beta = c_p * mod_q + s_p * mod_d;
 
     // Report final applied voltage in stationary frame (for sensorless estimator)
     final_v_alpha_ = mod_to_V * mod_alpha;
     final_v_beta_ = mod_to_V * mod_beta;
+    V_applied_alpha_beta_ = {final_v_alpha_, final_v_beta_};
+
+    // Add the inverter voltage error on top, so that the voltage reported
+    // above is the one that reaches the motor. In current control the error
+    // follows the setpoint because the measurement is a period old and noisy
+    // around the zero crossings. The compensation is limited to the headroom
+    // between max_mod and the SVM limit.
+    if (dead_time_compensation_.has_value()) {
+        std::optional<float2D> I_comp = Ialpha_beta_measured_;
+        if (enable_current_control_ && Idq_setpoint_.has_value()) {
+            auto [Id_setpoint, Iq_setpoint] = *Idq_setpoint_;
+            I_comp = {c_p * Id_setpoint - s_p * Iq_setpoint, c_p * Iq_setpoint + s_p * Id_setpoint};
+        }
+        if (I_comp.has_value()) {
+            auto [v_comp_alpha, v_comp_beta] = dead_time_compensation_->get_voltage(I_comp->first, I_comp->second);
+            float comp_alpha = V_to_mod * v_comp_alpha;
+            float comp_beta = V_to_mod * v_comp_beta;
+            constexpr float max_comp = sqrt3_by_2 - max_mod;
+            float comp_magnitude_sq = comp_alpha * comp_alpha + comp_beta * comp_beta;
+            if (comp_magnitude_sq > max_comp * max_comp) {
+                float comp_scalefactor = max_comp / std::sqrt(comp_magnitude_sq);
+                comp_alpha *= comp_scalefactor;
+                comp_beta *= comp_scalefactor;
+            }
+            mod_alpha += comp_alpha;
+            mod_beta += comp_beta;
+        }
+    }
 
     *mod_alpha_beta = {mod_alpha, mod_beta};
 
@@ -185,9 +293,10 @@ void FieldOrientedController::update(uint32_t timestamp) {
     CRITICAL_SECTION() {
         ctrl_timestamp_ = timestamp;
         enable_current_control_ = enable_current_control_src_;
-        Idq_setpoint_ = Idq_setpoint_src_.present();
-        Vdq_setpoint_ = Vdq_setpoint_src_.present();
-        phase_ = phase_src_.present();
-        phase_vel_ = phase_vel_src_.present();
+        const SignalWiring& wiring = *axis_->wiring_;
+        Idq_setpoint_ = wiring.Idq_setpoint_src.present();
+        Vdq_setpoint_ = wiring.Vdq_setpoint_src.present();
+        phase_ = wiring.phase_src.present();
+        phase_vel_ = wiring.phase_vel_src.present();
     }
 }
@@ -1,14 +1,19 @@
 #ifndef __FOC_HPP
 #define __FOC_HPP
 
+class Axis; // declared in axis.hpp
+
 #include "phase_control_law.hpp"
 #include "component.hpp"
+#include "dead_time_compensation.hpp"
+#include "utils.hpp"
 
 /**
  * @brief Field oriented controller.
  * 
  * This controller can run in either current control mode or voltage control
- * mode.
+ * mode. In current control mode the current is regulated either by a PI
+ * controller or by a deadbeat law (see current_control_law_).
  */
 class FieldOrientedController : public AlphaBetaFrameController, public ComponentBase {
 public:
@@ -26,16 +31,26 @@ public:
             std::optional<float2D>* mod_alpha_beta,
             std::optional<float>* ibus) final;
 
+    struct DeadbeatGains {
+        float a; // [1] current decay over one control period (discretized R-L plant: I[k+1] = a*I[k] + b*V[k])
+        float b; // [A/V] current change over one control period per volt
+        float k_obs; // [1] fraction of the prediction error that is attributed to the disturbance voltage each period
+    };
+
+    // Largest modulation magnitude that the current controller applies
+    // TODO make maximum modulation configurable
+    static constexpr float max_mod = 0.80f * sqrt3_by_2;
+
     // Config - these values are set while this controller is inactive
+    ODriveIntf::MotorIntf::CurrentControlLaw current_control_law_ = ODriveIntf::MotorIntf::CURRENT_CONTROL_LAW_PI;
     std::optional<float2D> pi_gains_; // [V/A, V/As] should be auto set after resistance and inductance measurement
+    std::optional<DeadbeatGains> deadbeat_gains_; // set together with pi_gains_
+    std::optional<DeadTimeCompensation> dead_time_compensation_; // std::nullopt if disabled
     float I_measured_report_filter_k_ = 1.0f;
 
     // Inputs
     bool enable_current_control_src_ = false;
-    InputPort<float2D> Idq_setpoint_src_;
-    InputPort<float2D> Vdq_setpoint_src_;
-    InputPort<float> phase_src_;
-    InputPort<float> phase_vel_src_;
+    Axis* axis_ = nullptr; // set by Axis constructor, provides the signal wiring
 
     // These values are set atomically by the update() function and read by the
     // calculate() function in an interrupt context.
@@ -60,7 +75,10 @@ public:
     //float ibus_ = 0.0f;
     float final_v_alpha_ = 0.0f; // [V]
     float final_v_beta_ = 0.0f; // [V]
+    float2D V_applied_alpha_beta_ = {0.0f, 0.0f}; // [V] previous output, applied until the next output takes effect
+    std::optional<float2D> I_predicted_alpha_beta_; // [A] deadbeat prediction of the next current measurement
     float power_ = 0.0f; // [W] dot product of Vdq and Idq
+    float mod_demand_ = 0.0f; // [1] requested modulation magnitude relative to max_mod, above 1 while the output saturates
 };
 
 #endif // __FOC_HPP
\ No newline at end of file
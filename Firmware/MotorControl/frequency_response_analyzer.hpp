@@ -0,0 +1,223 @@
+#ifndef __FREQUENCY_RESPONSE_ANALYZER_HPP
+#define __FREQUENCY_RESPONSE_ANALYZER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Measures the frequency response of the axis while INPUT_MODE_TUNING
+ * injects a sine wave.
+ *
+ * The analyzer sets the frequency of the sine wave generator and correlates
+ * the injected reference signal and the measured signals with the generator
+ * phasor (lock-in detection, equivalent to a single-bin DFT). Each measurement
+ * window is Hann weighted, which suppresses DC offsets and slow drift. The
+ * response of each channel is the ratio of its phasor to the reference phasor,
+ * so the window gain and the excitation amplitude cancel out.
+ *
+ * Two sweep modes are supported:
+ *  - Stepped sine: for each frequency the generator first runs for
+ *    settle_cycles and then measures for measure_cycles.
+ *  - Chirp: the frequency rises exponentially and without pauses from
+ *    start_frequency to end_frequency. Each point covers an equal
+ *    logarithmic band and lasts measure_cycles cycles of its lowest
+ *    frequency.
+ *
+ * The frequencies are logarithmically spaced.
+ */
+class FrequencyResponseAnalyzer {
+public:
+    static constexpr uint32_t kMaxPoints = 32;
+    static constexpr size_t kNumChannels = 3; // position, velocity, Iq
+
+    struct Config_t {
+        float start_frequency = 1.0f;   // [Hz]
+        float end_frequency = 200.0f;   // [Hz]
+        uint32_t n_points = 20;
+        float settle_cycles = 5.0f;
+        float measure_cycles = 10.0f;
+        bool chirp = false;
+    };
+
+    struct Point_t {
+        float frequency = 0.0f;             // [Hz]
+        float gain[kNumChannels] = {};      // [channel unit / reference unit]
+        float phase[kNumChannels] = {};     // [rad] in (-pi, pi]
+    };
+
+    /**
+     * @brief Starts a new sweep and discards the previous results.
+     * Returns false if the configuration is invalid for the control period dt.
+     */
+    bool start(float dt) {
+        if (!(config_.start_frequency > 0.0f) || !(config_.end_frequency > 0.0f)
+                || !(std::max(config_.start_frequency, config_.end_frequency) < 0.5f / dt)
+                || config_.n_points < 1 || config_.n_points > kMaxPoints
+                || !(config_.measure_cycles >= 1.0f) || !(config_.settle_cycles >= 0.0f)) {
+            return false;
+        }
+        n_results_ = 0;
+        if (config_.chirp) {
+            // n_points contiguous bands that span the whole range
+            freq_ratio_ = std::pow(config_.end_frequency / config_.start_frequency, 1.0f / (float)config_.n_points);
+        } else {
+            freq_ratio_ = (config_.n_points > 1)
+                    ? std::pow(config_.end_frequency / config_.start_frequency, 1.0f / (float)(config_.n_points - 1))
+                    : 1.0f;
+        }
+        frequency_ = config_.start_frequency;
+        sample_ = 0;
+        n_samples_ = (uint32_t)std::ceil(config_.settle_cycles / (frequency_ * dt));
+        state_ = STATE_SETTLING;
+        return true;
+    }
+
+    void stop() { state_ = STATE_IDLE; }
+    bool is_active() const { return state_ != STATE_IDLE; }
+
+    /** @brief Frequency that the sine wave generator should currently use [Hz] */
+    float frequency() const { return frequency_; }
+
+    uint32_t n_results() const { return n_results_; }
+
+    const Point_t& result(uint32_t index) const {
+        static const Point_t invalid = {};
+        return (index < n_results_) ? results_[index] : invalid;
+    }
+
+    /**
+     * @brief Must be called once per control period while active.
+     * @param s, c: sin and cos of the generator phase that was used for this period
+     * @param ref: injected reference signal
+     * @param meas: measured signals
+     */
+    void update(float dt, float s, float c, float ref, const float (&meas)[kNumChannels]) {
+        if (state_ == STATE_IDLE) {
+            return;
+        }
+
+        if (state_ == STATE_SETTLING) {
+            if (++sample_ < n_samples_) {
+                return;
+            }
+            start_window(dt, ref, meas);
+        }
+
+        // Hann window weight for this sample
+        float w = 0.5f - 0.5f * win_cos_;
+        float rot_c = win_cos_ * win_step_cos_ - win_sin_ * win_step_sin_;
+        win_sin_ = win_sin_ * win_step_cos_ + win_cos_ * win_step_sin_;
+        win_cos_ = rot_c;
+
+        // Correlate with exp(-j * phase)
+        float wc = w * c;
+        float ws = w * s;
+        float x = ref - ref_offset_;
+        ref_re_ += wc * x;
+        ref_im_ -= ws * x;
+        for (size_t i = 0; i < kNumChannels; ++i) {
+            x = meas[i] - meas_offset_[i];
+            meas_re_[i] += wc * x;
+            meas_im_[i] -= ws * x;
+        }
+
+        if (config_.chirp) {
+            frequency_ *= chirp_step_;
+        }
+
+        if (++sample_ < n_samples_) {
+            return;
+        }
+
+        // Window complete
+        Point_t& p = results_[n_results_];
+        p.frequency = config_.chirp ? window_frequency_ * std::sqrt(freq_ratio_) : window_frequency_;
+        float ref_mag = std::sqrt(ref_re_ * ref_re_ + ref_im_ * ref_im_);
+        float ref_phase = std::atan2(ref_im_, ref_re_);
+        for (size_t i = 0; i < kNumChannels; ++i) {
+            if (ref_mag > 0.0f) {
+                p.gain[i] = std::sqrt(meas_re_[i] * meas_re_[i] + meas_im_[i] * meas_im_[i]) / ref_mag;
+                p.phase[i] = wrap_pm_pi(std::atan2(meas_im_[i], meas_re_[i]) - ref_phase);
+            } else {
+                p.gain[i] = NAN;
+                p.phase[i] = NAN;
+            }
+        }
+        ++n_results_;
+
+        if (n_results_ >= config_.n_points) {
+            state_ = STATE_IDLE;
+            return;
+        }
+
+        if (config_.chirp) {
+            // Continue with the next band without settling
+            frequency_ = window_frequency_ * freq_ratio_;
+            start_window(dt, ref, meas);
+        } else {
+            frequency_ = config_.start_frequency * std::pow(freq_ratio_, (float)n_results_);
+            sample_ = 0;
+            n_samples_ = (uint32_t)std::ceil(config_.settle_cycles / (frequency_ * dt));
+            state_ = STATE_SETTLING;
+        }
+    }
+
+    Config_t config_;
+
+private:
+    enum State {
+        STATE_IDLE,
+        STATE_SETTLING,
+        STATE_MEASURING,
+    };
+
+    static float wrap_pm_pi(float x) {
+        if (x > (float)M_PI) x -= 2.0f * (float)M_PI;
+        if (x <= -(float)M_PI) x += 2.0f * (float)M_PI;
+        return x;
+    }
+
+    void start_window(float dt, float ref, const float (&meas)[kNumChannels]) {
+        window_frequency_ = frequency_;
+        n_samples_ = std::max((uint32_t)std::lround(config_.measure_cycles / (frequency_ * dt)), (uint32_t)2);
+        sample_ = 0;
+        if (config_.chirp) {
+            chirp_step_ = std::pow(freq_ratio_, 1.0f / (float)n_samples_);
+        }
+        float step = 2.0f * (float)M_PI / (float)n_samples_;
+        win_step_cos_ = std::cos(step);
+        win_step_sin_ = std::sin(step);
+        win_cos_ = 1.0f;
+        win_sin_ = 0.0f;
+        ref_offset_ = ref;
+        ref_re_ = ref_im_ = 0.0f;
+        for (size_t i = 0; i < kNumChannels; ++i) {
+            meas_offset_[i] = meas[i];
+            meas_re_[i] = meas_im_[i] = 0.0f;
+        }
+        state_ = STATE_MEASURING;
+    }
+
+    State state_ = STATE_IDLE;
+    float frequency_ = 0.0f;        // [Hz]
+    float freq_ratio_ = 1.0f;       // ratio between adjacent points
+    float chirp_step_ = 1.0f;       // frequency ratio per sample during a chirp
+    float window_frequency_ = 0.0f; // [Hz] generator frequency at the start of the window
+    uint32_t sample_ = 0;
+    uint32_t n_samples_ = 0;
+
+    float win_cos_ = 1.0f, win_sin_ = 0.0f;
+    float win_step_cos_ = 1.0f, win_step_sin_ = 0.0f;
+    float ref_offset_ = 0.0f;
+    float ref_re_ = 0.0f, ref_im_ = 0.0f;
+    float meas_offset_[kNumChannels] = {};
+    float meas_re_[kNumChannels] = {};
+    float meas_im_[kNumChannels] = {};
+
+    uint32_t n_results_ = 0;
+    Point_t results_[kMaxPoints];
+};
+
+#endif // __FREQUENCY_RESPONSE_ANALYZER_HPP
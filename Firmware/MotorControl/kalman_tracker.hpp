@@ -0,0 +1,170 @@
+#ifndef __KALMAN_TRACKER_HPP
+#define __KALMAN_TRACKER_HPP
+
+#include <cmath>
+#include <stdint.h>
+
+/**
+ * @brief Steady-state Kalman filter for position, velocity and acceleration
+ * (an alpha-beta-gamma tracker).
+ *
+ * The motion model is a constant acceleration driven by white jerk noise with
+ * power spectral density q, the position is measured every dt with noise
+ * variance r. The steady-state gains only depend on q * dt^5 / r and are
+ * found once, by iterating the Riccati equation until it converges. After
+ * that the filter costs a few multiply-adds per update, like the PLL it
+ * replaces.
+ *
+ * The position and the velocity states are owned by the caller (the encoder
+ * keeps them for its outputs anyway). Only the acceleration lives in here.
+ */
+class KalmanTracker {
+public:
+    struct Gains {
+        float pos = 0.0f; // [1]
+        float vel = 0.0f; // [1/s]
+        float acc = 0.0f; // [1/s^2]
+    };
+
+    /**
+     * @brief Computes the steady-state gains.
+     * @param process_noise: Square root of the PSD of the jerk [unit/s^3/sqrt(Hz)]
+     * @param measurement_noise: Standard deviation of a measurement [unit]
+     * @param dt: Update period [s]
+     * @returns false if the Riccati iteration did not converge, in which case
+     * the gains are left unchanged.
+     */
+    bool set_noise(float process_noise, float measurement_noise, float dt) {
+        if (!(process_noise > 0.0f && measurement_noise > 0.0f && dt > 0.0f)) {
+            return false;
+        }
+        // Everything below is normalized to dt = 1 and r = 1, so the states
+        // are [pos, vel * dt, acc * dt^2] in units of the measurement noise.
+        float lambda = (process_noise * process_noise) * (dt * dt * dt * dt * dt)
+                     / (measurement_noise * measurement_noise);
+        if (!std::isfinite(lambda) || lambda <= 0.0f) {
+            return false;
+        }
+        const float q[3][3] = {
+            {lambda / 20.0f, lambda / 8.0f, lambda / 6.0f},
+            {lambda / 8.0f,  lambda / 3.0f, lambda / 2.0f},
+            {lambda / 6.0f,  lambda / 2.0f, lambda}
+        };
+
+        float p[3][3] = {}; // a posteriori covariance
+        float k[3] = {};
+        for (uint32_t i = 0; i < kMaxIterations; ++i) {
+            // A priori covariance F * P * F' + Q with F = [[1,1,.5],[0,1,1],[0,0,1]]
+            float fp[3][3];
+            for (int c = 0; c < 3; ++c) {
+                fp[0][c] = p[0][c] + p[1][c] + 0.5f * p[2][c];
+                fp[1][c] = p[1][c] + p[2][c];
+                fp[2][c] = p[2][c];
+            }
+            float pm[3][3];
+            for (int r = 0; r < 3; ++r) {
+                pm[r][0] = fp[r][0] + fp[r][1] + 0.5f * fp[r][2] + q[r][0];
+                pm[r][1] = fp[r][1] + fp[r][2] + q[r][1];
+                pm[r][2] = fp[r][2] + q[r][2];
+            }
+
+            // Measurement of the position with unit variance
+            float s = pm[0][0] + 1.0f;
+            float k_new[3] = {pm[0][0] / s, pm[1][0] / s, pm[2][0] / s};
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 3; ++c) {
+                    p[r][c] = pm[r][c] - k_new[r] * pm[0][c];
+                }
+            }
+
+            bool converged = true;
+            for (int r = 0; r < 3; ++r) {
+                converged = converged && std::abs(k_new[r] - k[r]) <= kTolerance * k_new[r];
+                k[r] = k_new[r];
+            }
+            if (!std::isfinite(s)) {
+                return false;
+            }
+            if (converged && i > 0) {
+                gains_.pos = k[0];
+                gains_.vel = k[1] / dt;
+                gains_.acc = k[2] / (dt * dt);
+                dt_ = dt;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const Gains& gains() const { return gains_; }
+    float acc() const { return acc_; }
+
+    void reset() { acc_ = 0.0f; }
+
+    /**
+     * @brief Advances pos and vel by one period with the current acceleration.
+     * Pos may be any type that a float displacement can be added to.
+     */
+    template<typename TPos>
+    void predict(TPos& pos, float& vel) const {
+        pos += dt_ * (vel + 0.5f * dt_ * acc_);
+        vel += dt_ * acc_;
+    }
+
+    /**
+     * @brief Corrects the states by the innovation (measured minus predicted
+     * position).
+     */
+    template<typename TPos>
+    void correct(TPos& pos, float& vel, float innovation) {
+        pos += gains_.pos * innovation;
+        vel += gains_.vel * innovation;
+        acc_ += gains_.acc * innovation;
+    }
+
+    /**
+     * @brief Like correct(), but moves pos all the way to the measurement.
+     * For measurements that are much more accurate than the measurement noise
+     * that the gains were computed for.
+     */
+    template<typename TPos>
+    void correct_exact(TPos& pos, float& vel, float innovation) {
+        pos += innovation;
+        vel += gains_.vel * innovation;
+        acc_ += gains_.acc * innovation;
+    }
+
+    /**
+     * @brief Returns the innovation for a measurement at an edge, i.e. the
+     * position was exactly at the edge a time age [s] ago. The edge is given
+     * as offset from the estimated position.
+     */
+    float edge_innovation(float edge_pos_minus_pos, float vel, float age) const {
+        return edge_pos_minus_pos + age * (vel - 0.5f * age * acc_);
+    }
+
+    /**
+     * @brief Returns the innovation for a measurement that only says that the
+     * position is somewhere between lower and upper, given as offsets from
+     * the estimated position: Zero inside the interval, the distance to the
+     * nearest bound outside of it.
+     */
+    static float interval_innovation(float lower_minus_pos, float upper_minus_pos) {
+        if (lower_minus_pos > 0.0f) {
+            return lower_minus_pos;
+        } else if (upper_minus_pos < 0.0f) {
+            return upper_minus_pos;
+        }
+        return 0.0f;
+    }
+
+private:
+    static constexpr uint32_t kMaxIterations = 20000;
+    static constexpr float kTolerance = 1e-6f;
+
+    Gains gains_;
+    float dt_ = 0.0f; // [s]
+    float acc_ = 0.0f; // [unit/s^2]
+};
+
+#endif // __KALMAN_TRACKER_HPP
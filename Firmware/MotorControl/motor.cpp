@@ -68,7 +68,7 @@ struct ResistanceMeasurementControlLaw : AlphaBetaFrameController {
         return I_beta_;
     }
 
-    const float kI = 1.0f; // [(V/s)/A]
+    float kI = 1.0f; // [(V/s)/A]
     const float kIBetaFilt = 80.0f;
     float max_voltage_ = 0.0f;
     float actual_current_ = 0.0f;
@@ -82,10 +82,19 @@ struct ResistanceMeasurementControlLaw : AlphaBetaFrameController {
  * @brief This control law toggles rapidly between positive and negative output
  * voltage. By measuring how large the current ripples are, the phase inductance
  * can be determined.
+ *
+ * The voltage is applied along one or more directions (unit vectors in the
+ * alpha-beta frame). With several directions the law moves on to the next one
+ * after every positive/negative pair, so that all of them are measured over the
+ * same time span. On a salient motor the inductance depends on the rotor angle
+ * relative to the direction and the rotor may drift slightly during the
+ * measurement.
  * 
  * TODO: this method assumes a certain synchronization between current measurement and output application
  */
 struct InductanceMeasurementControlLaw : AlphaBetaFrameController {
+    static constexpr size_t kMaxDirections = 4;
+
     void reset() final {
         attached_ = false;
     }
@@ -99,17 +108,20 @@ struct InductanceMeasurementControlLaw : AlphaBetaFrameController {
             return {Motor::ERROR_UNKNOWN_CURRENT_MEASUREMENT};
         }
 
-        float Ialpha = Ialpha_beta->first;
-
         if (attached_) {
+            // The current change seen now was caused by the output before last
+            size_t k = output_direction_[1];
             float sign = test_voltage_ >= 0.0f ? 1.0f : -1.0f;
-            deltaI_ += -sign * (Ialpha - last_Ialpha_);
+            deltaI_[k] += -sign * (directions_[k].first * (Ialpha_beta->first - last_Ialpha_beta_.first)
+                                 + directions_[k].second * (Ialpha_beta->second - last_Ialpha_beta_.second));
+            n_samples_[k]++;
+            n_samples_total_++;
         } else {
             start_timestamp_ = input_timestamp;
             attached_ = true;
         }
 
-        last_Ialpha_ = Ialpha;
+        last_Ialpha_beta_ = *Ialpha_beta;
         last_input_timestamp_ = input_timestamp;
 
         return Motor::ERROR_NONE;
@@ -119,32 +131,42 @@ struct InductanceMeasurementControlLaw : AlphaBetaFrameController {
             uint32_t output_timestamp, std::optional<float2D>* mod_alpha_beta,
             std::optional<float>* ibus) final
     {
+        size_t k = (n_outputs_++ / 2) % n_directions_;
+        output_direction_[1] = output_direction_[0];
+        output_direction_[0] = k;
+
         test_voltage_ *= -1.0f;
         float vfactor = 1.0f / ((2.0f / 3.0f) * vbus_voltage);
-        *mod_alpha_beta = {test_voltage_ * vfactor, 0.0f};
+        *mod_alpha_beta = {test_voltage_ * vfactor * directions_[k].first, test_voltage_ * vfactor * directions_[k].second};
         *ibus = 0.0f;
         return Motor::ERROR_NONE;
     }
 
-    float get_inductance() {
+    float get_inductance(size_t k) {
         // Note: A more correct formula would also take into account that there is a finite timestep.
         // However, the discretisation in the current control loop inverts the same discrepancy
         float dt = (float)(last_input_timestamp_ - start_timestamp_) / (float)TIM_1_8_CLOCK_HZ; // at 216MHz this overflows after 19 seconds
-        return std::abs(test_voltage_) / (deltaI_ / dt);
+        dt *= (float)n_samples_[k] / (float)n_samples_total_; // share of this direction
+        return std::abs(test_voltage_) / (deltaI_[k] / dt);
     }
 
     // Config
     float test_voltage_ = 0.0f;
+    float2D directions_[kMaxDirections] = {{1.0f, 0.0f}};
+    size_t n_directions_ = 1;
 
     // State
     bool attached_ = false;
-    float sign_ = 0;
+    size_t n_outputs_ = 0;
+    size_t output_direction_[2] = {0, 0}; // direction of the last and second to last output
+    float2D last_Ialpha_beta_ = {NAN, NAN};
 
     // Outputs
     uint32_t start_timestamp_ = 0;
-    float last_Ialpha_ = NAN;
     uint32_t last_input_timestamp_ = 0;
-    float deltaI_ = 0.0f;
+    float deltaI_[kMaxDirections] = {};
+    uint32_t n_samples_[kMaxDirections] = {};
+    uint32_t n_samples_total_ = 0;
 };
 
 
@@ -295,23 +317,76 @@ bool Motor::disarm(bool* p_was_armed) {
 // This should be invoked whenever one of these values changes.
 // TODO: allow update on user-request or update automatically via hooks
 void Motor::update_current_controller_gains() {
-    // Calculate current control gains
-    float p_gain = config_.current_control_bandwidth * config_.phase_inductance;
+    // Calculate current control gains. The bandwidth is limited to a fraction
+    // of the control loop rate so that the discrete time approximation holds.
+    float bandwidth = std::min(config_.current_control_bandwidth, 0.25f * 2.0f * (float)M_PI * current_meas_hz);
+    float p_gain = bandwidth * config_.phase_inductance;
     float plant_pole = config_.phase_resistance / config_.phase_inductance;
     current_control_.pi_gains_ = {p_gain, plant_pole * p_gain};
+
+    // Exact discretization of the R-L plant for the deadbeat law. Here the
+    // bandwidth sets how fast the disturbance observer converges.
+    if (config_.phase_resistance > 0.0f && config_.phase_inductance > 0.0f) {
+        float decay = -plant_pole * current_meas_period;
+        current_control_.deadbeat_gains_ = {
+            std::exp(decay),
+            -std::expm1(decay) / config_.phase_resistance,
+            -std::expm1(-bandwidth * current_meas_period)
+        };
+    } else {
+        current_control_.deadbeat_gains_ = std::nullopt;
+    }
+}
+
+// @brief Applies the control law, modulation and dead time compensation
+// settings to the current controller.
+// This should be invoked whenever one of these settings changes.
+void Motor::update_current_controller_config() {
+    current_control_.current_control_law_ = config_.current_control_law;
+
+    static_assert(SVM_MODE_DPWM2 == (SvmMode)MODULATION_MODE_DPWM2 && SVM_MODE_DPWM_MAX == (SvmMode)MODULATION_MODE_DPWM_MAX,
+                  "SvmMode must mirror ModulationMode");
+    current_control_.svm_mode_ = (SvmMode)config_.modulation_mode;
+    current_control_.svm_sensed_phases_ = current_sensor_mask_;
+
+    if (config_.dead_time_compensation_enable) {
+        current_control_.dead_time_compensation_ = DeadTimeCompensation{config_.dead_time_voltage, config_.dead_time_current};
+    } else {
+        current_control_.dead_time_compensation_ = std::nullopt;
+    }
+}
+
+// @brief Recomputes the MTPA table from the motor parameters.
+// This should be invoked whenever one of them changes.
+void Motor::update_mtpa_table() {
+    // The table is designed outside of the control loop and published in one
+    // step, so that the control loop never sees a partly written table.
+    MtpaTable table;
+    bool valid = config_.mtpa_enable && config_.motor_type == MOTOR_TYPE_HIGH_CURRENT
+              && table.design(config_.torque_constant, config_.pole_pairs,
+                              config_.phase_inductance_d, config_.phase_inductance_q,
+                              config_.requested_current_range);
+    CRITICAL_SECTION() {
+        if (valid) {
+            mtpa_table_ = table;
+        }
+        mtpa_valid_ = valid;
+    }
 }
 
 bool Motor::apply_config() {
     config_.parent = this;
     is_calibrated_ = config_.pre_calibrated;
     update_current_controller_gains();
+    update_current_controller_config();
+    update_mtpa_table();
     return true;
 }
 
 // @brief Set up the gate drivers
 bool Motor::setup() {
-    fet_thermistor_.update();
-    motor_thermistor_.update();
+    fet_thermistor_.update(current_meas_period);
+    motor_thermistor_.update(current_meas_period);
 
     // Solve for exact gain, then snap down to have equal or larger range as requested
     // or largest possible range otherwise
@@ -388,7 +463,14 @@ float Motor::max_available_torque() {
         max_torque = std::clamp(max_torque, 0.0f, config_.torque_lim);
         return max_torque;
     } else {
-        float max_torque = effective_current_lim_ * config_.torque_constant;
+        // Id takes priority over Iq (see update())
+        float iq_lim = std::sqrt(std::max(SQ(effective_current_lim_) - SQ(field_weakening_Id_), 0.0f));
+        float max_torque = iq_lim * config_.torque_constant;
+        if (mtpa_valid_ && config_.motor_type == MOTOR_TYPE_HIGH_CURRENT) {
+            max_torque = (field_weakening_Id_ == 0.0f)
+                    ? mtpa_table_.torque_at_current(effective_current_lim_)
+                    : iq_lim * mtpa_table_.torque_constant_at(field_weakening_Id_);
+        }
         max_torque = std::clamp(max_torque, 0.0f, config_.torque_lim);
         return max_torque;
     }
@@ -454,9 +536,18 @@ bool Motor::measure_phase_resistance(float test_current, float max_voltage) {
 }
 
 
-bool Motor::measure_phase_inductance(float test_voltage) {
+/**
+ * @brief Measures the inductance along each of the n_directions unit vectors
+ * in the alpha-beta frame (at most 4).
+ *
+ * On a salient motor the results lie between Ld and Lq, depending on the
+ * (unknown) rotor angle.
+ */
+bool Motor::measure_inductance(float test_voltage, const float2D* directions, size_t n_directions, float* inductances) {
     InductanceMeasurementControlLaw control_law;
     control_law.test_voltage_ = test_voltage;
+    control_law.n_directions_ = std::min(n_directions, InductanceMeasurementControlLaw::kMaxDirections);
+    std::copy_n(directions, control_law.n_directions_, control_law.directions_);
 
     arm(&control_law);
 
@@ -475,17 +566,127 @@ bool Motor::measure_phase_inductance(float test_voltage) {
 
     disarm();
 
-    config_.phase_inductance = control_law.get_inductance();
+    for (size_t i = 0; i < control_law.n_directions_; ++i) {
+        inductances[i] = control_law.get_inductance(i);
     
-    // TODO arbitrary values set for now
-    if (!(config_.phase_inductance >= 2e-6f && config_.phase_inductance <= 4000e-6f)) {
-        error_ |= ERROR_PHASE_INDUCTANCE_OUT_OF_RANGE;
-        success = false;
+        // TODO arbitrary values set for now
+        if (!(inductances[i] >= 2e-6f && inductances[i] <= 4000e-6f)) {
+            error_ |= ERROR_PHASE_INDUCTANCE_OUT_OF_RANGE;
+            success = false;
+        }
     }
 
     return success;
 }
 
+bool Motor::measure_phase_inductance(float test_voltage) {
+    const float2D alpha = {1.0f, 0.0f};
+    return measure_inductance(test_voltage, &alpha, 1, &config_.phase_inductance);
+}
+
+/**
+ * @brief Measures the d and q axis inductances of a salient motor.
+ *
+ * The inverse inductance seen along the stator angle phi is
+ * (1/Ld + 1/Lq)/2 + (1/Ld - 1/Lq)/2 * cos(2 (phi - theta)), where theta is the
+ * electrical rotor angle. Sampling it at 0°, 45°, 90° and 135° gives the mean
+ * and the amplitude without knowing theta, so this can run before the encoder
+ * is calibrated. The samples are interleaved because the ripple current
+ * produces a small reluctance torque that can move the rotor.
+ *
+ * On success config_.phase_inductance is replaced by Ld. The current
+ * controller gains are based on it, and underestimating the inductance only
+ * slows down the q axis while overestimating it makes the deadbeat law
+ * oscillate.
+ */
+bool Motor::measure_saliency(float test_voltage) {
+    constexpr float one_by_sqrt2 = 0.70710678118f;
+    const float2D directions[4] = {{1.0f, 0.0f}, {one_by_sqrt2, one_by_sqrt2}, {0.0f, 1.0f}, {-one_by_sqrt2, one_by_sqrt2}};
+
+    float inv_L[4];
+    if (!measure_inductance(test_voltage, directions, 4, inv_L))
+        return false;
+    for (float& x : inv_L) {
+        x = 1.0f / x;
+    }
+
+    float mean = 0.25f * (inv_L[0] + inv_L[1] + inv_L[2] + inv_L[3]);
+    float amplitude = std::hypot(0.5f * (inv_L[0] - inv_L[2]), 0.5f * (inv_L[1] - inv_L[3]));
+    float Ld = 1.0f / (mean + amplitude);
+    float Lq = 1.0f / (mean - amplitude);
+    if (!(Lq >= Ld && Lq <= 4000e-6f)) {
+        error_ |= ERROR_PHASE_INDUCTANCE_OUT_OF_RANGE;
+        return false;
+    }
+
+    config_.phase_inductance_d = Ld;
+    config_.phase_inductance_q = Lq;
+    config_.phase_inductance = Ld;
+    return true;
+}
+
+
+/**
+ * @brief Measures the inverter voltage error (see DeadTimeCompensation) and
+ * the phase resistance without it.
+ *
+ * The current is held along the alpha axis at decreasing fractions of
+ * test_current. Below the transition current the error behaves like a large
+ * resistance, so the integrator gain is raised from the resistance
+ * measurement to settle within the time given to each level.
+ *
+ * On success config_.phase_resistance, dead_time_voltage and
+ * dead_time_current are replaced.
+ */
+bool Motor::measure_dead_time(float test_current, float max_voltage) {
+    static constexpr float kLevels[] = {1.0f, 0.5f, 0.2f, 0.1f, 0.05f};
+    static constexpr size_t kNumLevels = sizeof(kLevels) / sizeof(kLevels[0]);
+    float currents[kNumLevels];
+    float voltages[kNumLevels];
+
+    ResistanceMeasurementControlLaw control_law;
+    control_law.kI = std::max(1.0f, 2.0f * (float)M_PI * 20.0f * config_.phase_resistance);
+    control_law.target_current_ = test_current;
+    control_law.max_voltage_ = max_voltage;
+
+    arm(&control_law);
+
+    bool aborted = false;
+    for (size_t k = 0; k < kNumLevels && !aborted; ++k) {
+        control_law.target_current_ = kLevels[k] * test_current;
+        size_t settle_ms = (k == 0) ? 3000 : 1000;
+        for (size_t i = 0; i < settle_ms; ++i) {
+            if (!((axis_->requested_state_ == Axis::AXIS_STATE_UNDEFINED) && axis_->motor_.is_armed_)) {
+                aborted = true;
+                break;
+            }
+            osDelay(1);
+        }
+        currents[k] = control_law.target_current_;
+        voltages[k] = control_law.test_voltage_;
+    }
+
+    bool success = is_armed_ && !aborted;
+
+    disarm();
+
+    if (!success) {
+        return false;
+    }
+
+    float resistance;
+    std::optional<DeadTimeCompensation> result = DeadTimeCompensation::fit(currents, voltages, kNumLevels, &resistance);
+    if (!result.has_value()) {
+        disarm_with_error(ERROR_PHASE_RESISTANCE_OUT_OF_RANGE);
+        return false;
+    }
+
+    config_.phase_resistance = resistance;
+    config_.dead_time_voltage = result->get_voltage_magnitude();
+    config_.dead_time_current = result->get_transition_current();
+    return true;
+}
+
 
 // TODO: motor calibration should only be a utility function that's called from
 // the UI on explicit user request. It should take its parameters as input
@@ -496,7 +697,21 @@ bool Motor::run_calibration() {
         || config_.motor_type == MOTOR_TYPE_ACIM) {
         if (!measure_phase_resistance(config_.calibration_current, R_calib_max_voltage))
             return false;
-        if (!measure_phase_inductance(R_calib_max_voltage))
+        if (config_.dead_time_compensation_enable
+            && !measure_dead_time(config_.calibration_current, R_calib_max_voltage))
+            return false;
+        // The current ripple of the inductance measurement grows with the
+        // control period. Below the default PWM frequency the test voltage is
+        // reduced so that the ripple stays the same.
+        float L_calib_voltage = R_calib_max_voltage;
+        const float default_period = (float)(TIM_1_8_RCR + 1) / DEFAULT_PWM_FREQUENCY;
+        if (current_meas_period > default_period) {
+            L_calib_voltage *= default_period / current_meas_period;
+        }
+        if (!measure_phase_inductance(L_calib_voltage))
+            return false;
+        if (config_.mtpa_enable && config_.motor_type == MOTOR_TYPE_HIGH_CURRENT
+            && !measure_saliency(L_calib_voltage))
             return false;
     } else if (config_.motor_type == MOTOR_TYPE_GIMBAL) {
         // no calibration needed
@@ -505,14 +720,47 @@ bool Motor::run_calibration() {
     }
 
     update_current_controller_gains();
+    update_current_controller_config();
+    update_mtpa_table();
     
     is_calibrated_ = true;
     return true;
 }
 
+/**
+ * @brief Adjusts field_weakening_Id_ such that the current controller keeps
+ * some voltage headroom.
+ *
+ * Once the requested modulation exceeds field_weakening_mod_target, Id is
+ * driven negative to counter the back-EMF. It returns to zero when the
+ * headroom comes back. The loop gain is scaled by 1/(w*L) because that is
+ * how much the voltage changes per ampere of Id, so the bandwidth stays the
+ * same at all speeds.
+ */
+void Motor::update_field_weakening(float ilim) {
+    std::optional<float> phase_vel = axis_->wiring_->phase_vel_src.present();
+    std::optional<float> vbus_voltage = current_control_.vbus_voltage_measured_;
+    if (!config_.field_weakening_enable || !phase_vel.has_value() || !vbus_voltage.has_value()) {
+        field_weakening_Id_ = 0.0f;
+        return;
+    }
+
+    float v_max = FieldOrientedController::max_mod * (2.0f / 3.0f) * *vbus_voltage;
+    float v_headroom = (config_.field_weakening_mod_target - current_control_.mod_demand_) * v_max;
+    float Ld = (config_.phase_inductance_d > 0.0f) ? config_.phase_inductance_d : config_.phase_inductance;
+    float wL = std::max(std::abs(*phase_vel) * Ld, 1e-6f); // [V/A]
+    field_weakening_Id_ += (config_.field_weakening_bandwidth * current_meas_period) * v_headroom / wL;
+
+    // Id takes priority in the 2-norm clamp, so field weakening may never take
+    // all of the current. A negative limit is treated as zero, which disables
+    // field weakening.
+    float max_Id = std::max(std::min(config_.field_weakening_max_current, 0.99f * ilim), 0.0f);
+    field_weakening_Id_ = std::clamp(field_weakening_Id_, -max_Id, 0.0f);
+}
+
 void Motor::update(uint32_t timestamp) {
     // Load torque setpoint, convert to motor direction
-    std::optional<float> maybe_torque = torque_setpoint_src_.present();
+    std::optional<float> maybe_torque = axis_->wiring_->torque_setpoint_src.present();
     if (!maybe_torque.has_value()) {
         error_ |= ERROR_UNKNOWN_TORQUE;
         return;
@@ -524,6 +772,8 @@ void Motor::update(uint32_t timestamp) {
                      .value_or(float2D{0.0f, 0.0f});
     // Load effective current limit
     float ilim = axis_->motor_.effective_current_lim_;
+    // The Id lookup and the torque constant must come from the same table
+    bool mtpa_valid = mtpa_valid_;
 
     // Autoflux tracks old Iq (that may be 2-norm clamped last cycle) to make sure we are chasing a feasable current.
     if ((axis_->motor_.config_.motor_type == Motor::MOTOR_TYPE_ACIM) && config_.acim_autoflux_enable) {
@@ -531,6 +781,13 @@ void Motor::update(uint32_t timestamp) {
         float gain = abs_iq > id ? config_.acim_autoflux_attack_gain : config_.acim_autoflux_decay_gain;
         id += gain * (abs_iq - id) * current_meas_period;
         id = std::clamp(id, config_.acim_autoflux_min_Id, 0.9f * ilim); // 10% space reserved for Iq
+    } else if (axis_->motor_.config_.motor_type == Motor::MOTOR_TYPE_HIGH_CURRENT) {
+        // Field weakening and MTPA are the only sources of Id for PM motors
+        update_field_weakening(ilim);
+        id = field_weakening_Id_;
+        if (mtpa_valid) {
+            id = std::max(id + mtpa_table_.lookup(torque).id, -ilim*0.99f);
+        }
     } else {
         id = std::clamp(id, -ilim*0.99f, ilim*0.99f); // 1% space reserved for Iq to avoid numerical issues
     }
@@ -538,6 +795,9 @@ void Motor::update(uint32_t timestamp) {
     // Convert requested torque to current
     if (axis_->motor_.config_.motor_type == Motor::MOTOR_TYPE_ACIM) {
         iq = torque / (axis_->motor_.config_.torque_constant * std::max(axis_->acim_estimator_.rotor_flux_, config_.acim_gain_min_flux));
+    } else if ((axis_->motor_.config_.motor_type == Motor::MOTOR_TYPE_HIGH_CURRENT) && mtpa_valid) {
+        // Includes the reluctance torque of whatever Id was chosen above
+        iq = torque / mtpa_table_.torque_constant_at(id);
     } else {
         iq = torque / axis_->motor_.config_.torque_constant;
     }
@@ -562,7 +822,7 @@ void Motor::update(uint32_t timestamp) {
     float vd = 0.0f;
     float vq = 0.0f;
 
-    std::optional<float> phase_vel = phase_vel_src_.present();
+    std::optional<float> phase_vel = axis_->wiring_->phase_vel_src.present();
 
     if (config_.R_wL_FF_enable) {
         if (!phase_vel.has_value()) {
@@ -570,8 +830,11 @@ void Motor::update(uint32_t timestamp) {
             return;
         }
 
-        vd -= *phase_vel * config_.phase_inductance * iq;
-        vq += *phase_vel * config_.phase_inductance * id;
+        bool salient = (config_.phase_inductance_d > 0.0f) && (config_.phase_inductance_q > 0.0f);
+        float Ld = salient ? config_.phase_inductance_d : config_.phase_inductance;
+        float Lq = salient ? config_.phase_inductance_q : config_.phase_inductance;
+        vd -= *phase_vel * Lq * iq;
+        vq += *phase_vel * Ld * id;
         vd += config_.phase_resistance * id;
         vq += config_.phase_resistance * iq;
     }
@@ -599,7 +862,6 @@ void Motor::update(uint32_t timestamp) {
  */
 void Motor::current_meas_cb(uint32_t timestamp, std::optional<Iph_ABC_t> current) {
     // TODO: this is platform specific
-    //const float current_meas_period = static_cast<float>(2 * TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1)) / TIM_1_8_CLOCK_HZ;
     TaskTimerContext tmr{axis_->task_times_.current_sense};
 
     n_evt_current_measurement_++;
@@ -663,17 +925,24 @@ void Motor::current_meas_cb(uint32_t timestamp, std::optional<Iph_ABC_t> current
 
 /**
  * @brief Called when the underlying hardware timer triggers an update event.
+ *
+ * The offsets are sampled in the middle of V7, where no current flows through
+ * the low-side shunts. The discontinuous modulation modes can leave a phase
+ * without (enough) V7. Since the unsensed phase is inferred from the others,
+ * the offsets are only updated if the high side of every phase was on for at
+ * least kSvmMinSenseWindow. At low modulation depths this pauses the offset
+ * calibration for as long as a discontinuous mode is active.
  */
 void Motor::dc_calib_cb(uint32_t timestamp, std::optional<Iph_ABC_t> current) {
-    const float dc_calib_period = static_cast<float>(2 * TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1)) / TIM_1_8_CLOCK_HZ;
     TaskTimerContext tmr{axis_->task_times_.dc_calib};
 
     if (current.has_value()) {
-        const float calib_filter_k = std::min(dc_calib_period / config_.dc_calib_tau, 1.0f);
+        bool in_v7 = *std::max_element(pwm_timings_, pwm_timings_ + 3) <= 1.0f - kSvmMinSenseWindow;
+        const float calib_filter_k = in_v7 ? std::min(current_meas_period / config_.dc_calib_tau, 1.0f) : 0.0f;
         DC_calib_.phA += (current->phA - DC_calib_.phA) * calib_filter_k;
         DC_calib_.phB += (current->phB - DC_calib_.phB) * calib_filter_k;
         DC_calib_.phC += (current->phC - DC_calib_.phC) * calib_filter_k;
-        dc_calib_running_since_ += dc_calib_period;
+        dc_calib_running_since_ += current_meas_period;
     } else {
         DC_calib_.phA = 0.0f;
         DC_calib_.phB = 0.0f;
@@ -704,6 +973,7 @@ void Motor::pwm_update_cb(uint32_t output_timestamp) {
             (uint16_t)(pwm_timings[2] * (float)TIM_1_8_PERIOD_CLOCKS)
         };
         apply_pwm_timings(next_timings, false);
+        std::copy_n(pwm_timings, 3, pwm_timings_);
     } else if (is_armed_) {
         if (!(timer_->Instance->BDTR & TIM_BDTR_MOE) && (control_law_status == ERROR_CONTROLLER_INITIALIZING)) {
             // If the PWM output is armed in software but not yet in
@@ -717,6 +987,7 @@ void Motor::pwm_update_cb(uint32_t output_timestamp) {
     if (!is_armed_) {
         // If something above failed, reset I_bus to 0A.
         i_bus = 0.0f;
+        std::fill_n(pwm_timings_, 3, 0.5f); // the phases are floating
     } else if (is_armed_ && !i_bus.has_value()) {
         // If the motor is armed then i_bus must be known
         disarm_with_error(ERROR_UNKNOWN_CURRENT_MEASUREMENT);
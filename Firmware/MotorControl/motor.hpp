@@ -7,6 +7,7 @@ class Motor;
 #include <board.h>
 #include <autogen/interfaces.hpp>
 #include "foc.hpp"
+#include "mtpa_table.hpp"
 
 class Motor : public ODriveIntf::MotorIntf {
 public:
@@ -21,6 +22,8 @@ public:
         float resistance_calib_max_voltage = 2.0f; // [V] - You may need to increase this if this voltage isn't sufficient to drive calibration_current through the motor.
         float phase_inductance = 0.0f;        // to be set by measure_phase_inductance
         float phase_resistance = 0.0f;        // to be set by measure_phase_resistance
+        float phase_inductance_d = 0.0f;      // [H] to be set by measure_saliency, 0 if unknown
+        float phase_inductance_q = 0.0f;      // [H] to be set by measure_saliency, 0 if unknown
         float torque_constant = 0.04f;         // [Nm/A] for PM motors, [Nm/A^2] for induction motors. Equal to 8.27/Kv of the motor
         MotorType motor_type = MOTOR_TYPE_HIGH_CURRENT;
         // Read out max_allowed_current to see max supported value for current_lim.
@@ -31,6 +34,11 @@ public:
         // Value used to compute shunt amplifier gains
         float requested_current_range = 60.0f; // [A]
         float current_control_bandwidth = 1000.0f;  // [rad/s]
+        CurrentControlLaw current_control_law = CURRENT_CONTROL_LAW_PI;
+        ModulationMode modulation_mode = MODULATION_MODE_CONTINUOUS;
+        bool dead_time_compensation_enable = false; // Measure and compensate the inverter voltage error
+        float dead_time_voltage = 0.0f;       // [V] to be set by measure_dead_time
+        float dead_time_current = 0.2f;       // [A] to be set by measure_dead_time
         float inverter_temp_limit_lower = 100;
         float inverter_temp_limit_upper = 120;
 
@@ -43,6 +51,13 @@ public:
         bool R_wL_FF_enable = false; // Enable feedforwards for R*I and w*L*I terms
         bool bEMF_FF_enable = false; // Enable feedforward for bEMF
 
+        bool field_weakening_enable = false;
+        float field_weakening_max_current = 10.0f; // [A] largest magnitude of the negative Id
+        float field_weakening_mod_target = 0.9f; // [1] fraction of the maximum modulation above which Id is injected
+        float field_weakening_bandwidth = 100.0f; // [rad/s]
+
+        bool mtpa_enable = false; // Measure Ld and Lq during calibration and use the reluctance torque
+
         float I_bus_hard_min = -INFINITY;
         float I_bus_hard_max = INFINITY;
         float I_leak_max = 0.1f;
@@ -58,6 +73,17 @@ public:
         void set_phase_inductance(float value) { phase_inductance = value; parent->update_current_controller_gains(); }
         void set_phase_resistance(float value) { phase_resistance = value; parent->update_current_controller_gains(); }
         void set_current_control_bandwidth(float value) { current_control_bandwidth = value; parent->update_current_controller_gains(); }
+        void set_current_control_law(CurrentControlLaw value) { current_control_law = value; parent->update_current_controller_config(); }
+        void set_modulation_mode(ModulationMode value) { modulation_mode = value; parent->update_current_controller_config(); }
+        void set_dead_time_compensation_enable(bool value) { dead_time_compensation_enable = value; parent->update_current_controller_config(); }
+        void set_dead_time_voltage(float value) { dead_time_voltage = value; parent->update_current_controller_config(); }
+        void set_dead_time_current(float value) { dead_time_current = value; parent->update_current_controller_config(); }
+        void set_pole_pairs(int32_t value) { pole_pairs = value; parent->update_mtpa_table(); }
+        void set_torque_constant(float value) { torque_constant = value; parent->update_mtpa_table(); }
+        void set_phase_inductance_d(float value) { phase_inductance_d = value; parent->update_mtpa_table(); }
+        void set_phase_inductance_q(float value) { phase_inductance_q = value; parent->update_mtpa_table(); }
+        void set_mtpa_enable(bool value) { mtpa_enable = value; parent->update_mtpa_table(); }
+        void set_requested_current_range(float value) { requested_current_range = value; parent->update_mtpa_table(); }
     };
 
     Motor(TIM_HandleTypeDef* timer,
@@ -75,14 +101,20 @@ public:
     bool setup();
 
     void update_current_controller_gains();
+    void update_current_controller_config();
+    void update_mtpa_table();
     void disarm_with_error(Error error);
     bool do_checks(uint32_t timestamp);
     float effective_current_lim();
     float max_available_torque();
     std::optional<float> phase_current_from_adcval(uint32_t ADCValue);
     bool measure_phase_resistance(float test_current, float max_voltage);
+    bool measure_inductance(float test_voltage, const float2D* directions, size_t n_directions, float* inductances);
     bool measure_phase_inductance(float test_voltage);
+    bool measure_saliency(float test_voltage);
+    bool measure_dead_time(float test_current, float max_voltage);
     bool run_calibration();
+    void update_field_weakening(float ilim);
     void update(uint32_t timestamp);
 
     // These functions are called as appropriate from the board.cpp file.
@@ -122,15 +154,16 @@ public:
     float phase_current_rev_gain_ = 0.0f; // Reverse gain for ADC to Amps (to be set by DRV8301_setup)
     FieldOrientedController current_control_;
     float effective_current_lim_ = 10.0f; // [A]
+    float field_weakening_Id_ = 0.0f; // [A] Id setpoint of PM motors, negative while field weakening is active
+    MtpaTable mtpa_table_;
+    bool mtpa_valid_ = false; // Set in update_mtpa_table()
     float max_allowed_current_ = 0.0f; // [A] set in setup()
     float max_dc_calib_ = 0.0f; // [A] set in setup()
-
-    InputPort<float> torque_setpoint_src_; // Usually points to the Controller object's output
-    InputPort<float> phase_vel_src_; // Usually points to the Encoder object's output
+    float pwm_timings_[3] = {0.5f, 0.5f, 0.5f}; // most recently applied timings, see dc_calib_cb()
 
     float direction_ = 0.0f; // if -1 then positive torque is converted to negative Iq
-    OutputPort<float2D> Vdq_setpoint_ = {{0.0f, 0.0f}}; // fed to the FOC
-    OutputPort<float2D> Idq_setpoint_ = {{0.0f, 0.0f}}; // fed to the FOC
+    SignalOutput<float2D> Vdq_setpoint_{SignalFrame::MOTOR_VDQ_SETPOINT}; // fed to the FOC
+    SignalOutput<float2D> Idq_setpoint_{SignalFrame::MOTOR_IDQ_SETPOINT}; // fed to the FOC
     
     PhaseControlLaw<3>* control_law_;
 };
@@ -0,0 +1,109 @@
+#ifndef __MTPA_TABLE_HPP
+#define __MTPA_TABLE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Maximum torque per ampere (MTPA) operating points of an interior
+ * permanent magnet motor, tabulated over the torque.
+ *
+ * With Lq > Ld the reluctance torque 1.5 p (Ld - Lq) Id Iq adds to the magnet
+ * torque 1.5 p psi Iq when Id is negative. For a given current magnitude Is
+ * the torque is largest at
+ *
+ *   Id = (psi - sqrt(psi^2 + 8 (Lq - Ld)^2 Is^2)) / (4 (Lq - Ld))
+ *
+ * design() solves this for kSize equally spaced torques from zero up to the
+ * torque at max_current. It is too slow for the control loop. lookup() then
+ * interpolates linearly between the points.
+ */
+class MtpaTable {
+public:
+    static constexpr size_t kSize = 32;
+
+    struct Point {
+        float id; // [A]
+        float iq; // [A]
+    };
+
+    /**
+     * @brief Fills the table. Returns false if the motor is not salient
+     * (Lq <= Ld) or a parameter is invalid. In that case the table must not be
+     * used.
+     */
+    bool design(float torque_constant, int32_t pole_pairs, float Ld, float Lq, float max_current) {
+        if (!(torque_constant > 0.0f) || !(pole_pairs > 0) || !(Ld > 0.0f)
+                || !(Lq > Ld) || !(max_current > 0.0f)) {
+            return false;
+        }
+        k_torque_ = 1.5f * (float)pole_pairs;
+        psi_ = torque_constant / k_torque_;
+        delta_L_ = Lq - Ld;
+
+        float max_torque = torque_at_current(max_current);
+        for (size_t i = 0; i < kSize; ++i) {
+            float torque = max_torque * (float)i / (float)(kSize - 1);
+            // T(Is) is monotonic, so the current is found by bisection
+            float lo = 0.0f;
+            float hi = max_current;
+            for (size_t j = 0; j < 32; ++j) {
+                float mid = 0.5f * (lo + hi);
+                if (torque_at_current(mid) < torque) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            float Is = 0.5f * (lo + hi);
+            float id = id_at_current(Is);
+            points_[i] = {id, std::sqrt(std::max(Is * Is - id * id, 0.0f))};
+        }
+        inv_torque_step_ = (float)(kSize - 1) / max_torque;
+        return true;
+    }
+
+    /**
+     * @brief Returns the MTPA currents for the given torque [Nm]. The sign of
+     * the torque goes to Iq. Torques above the design range return the last
+     * point.
+     */
+    Point lookup(float torque) const {
+        float x = std::abs(torque) * inv_torque_step_;
+        size_t i = std::min((size_t)x, kSize - 2);
+        float frac = std::min(x - (float)i, 1.0f);
+        float id = points_[i].id + frac * (points_[i + 1].id - points_[i].id);
+        float iq = points_[i].iq + frac * (points_[i + 1].iq - points_[i].iq);
+        return {id, torque < 0.0f ? -iq : iq};
+    }
+
+    /** @brief Torque [Nm] that the current magnitude Is [A] produces on the MTPA curve. */
+    float torque_at_current(float Is) const {
+        float id = id_at_current(Is);
+        float iq = std::sqrt(std::max(Is * Is - id * id, 0.0f));
+        return iq * torque_constant_at(id);
+    }
+
+    /**
+     * @brief Torque per ampere of Iq [Nm/A] at the given Id [A], including the
+     * reluctance torque.
+     */
+    float torque_constant_at(float id) const {
+        return k_torque_ * (psi_ - delta_L_ * id);
+    }
+
+private:
+    float id_at_current(float Is) const {
+        return (psi_ - std::sqrt(psi_ * psi_ + 8.0f * delta_L_ * delta_L_ * Is * Is)) / (4.0f * delta_L_);
+    }
+
+    Point points_[kSize] = {};
+    float inv_torque_step_ = 0.0f; // [1/Nm]
+    float k_torque_ = 0.0f; // 1.5 * pole pairs
+    float psi_ = 0.0f; // [Vs] magnet flux linkage
+    float delta_L_ = 0.0f; // [H] Lq - Ld
+};
+
+#endif // __MTPA_TABLE_HPP
@@ -110,6 +110,7 @@ struct BoardConfig_t {
     float dc_max_positive_current = INFINITY; // Max current [A] the power supply can source
     float dc_max_negative_current = -0.01f; // Max current [A] the power supply can sink. You most likely want a non-positive value here. Set to -INFINITY to disable.
     uint32_t error_gpio_pin = DEFAULT_ERROR_PIN;
+    float pwm_frequency = DEFAULT_PWM_FREQUENCY; // [Hz] applied at boot, see board_apply_config()
     PWMMapping_t pwm_mappings[4];
     PWMMapping_t analog_mappings[GPIO_COUNT];
 };
@@ -148,6 +149,7 @@ inline ENUMTYPE operator ~ (ENUMTYPE a) { return static_cast<ENUMTYPE>(~static_c
 #include <current_limiter.hpp>
 #include <thermistor.hpp>
 #include <trapTraj.hpp>
+#include <scurveTraj.hpp>
 #include <endstop.hpp>
 #include <mechanical_brake.hpp>
 #include <axis.hpp>
@@ -167,7 +169,7 @@ static Stm32Gpio get_gpio(size_t gpio_num) {
     return (gpio_num < GPIO_COUNT) ? gpios[gpio_num] : GPIO_COUNT ? gpios[0] : Stm32Gpio::none;
 }
 
-// general system functions defined in main.cpp
+// general system functions defined in main.cpp and control_loop.cpp
 class ODrive : public ODriveIntf {
 public:
     bool save_configuration() override;
@@ -181,6 +183,8 @@ public:
         return ::get_adc_voltage(get_gpio(gpio));
     }
 
+    bool move_to_pos_synchronized(float axis0_pos, float axis1_pos) override;
+
     int32_t test_function(int32_t delta) override {
         static int cnt = 0;
         return cnt += delta;
@@ -189,6 +193,7 @@ public:
     void do_fast_checks();
     void sampling_cb();
     void control_loop_cb(uint32_t timestamp);
+    void plan_synchronized_move();
 
     Axis& get_axis(int num) { return axes[num]; }
 
@@ -241,6 +246,8 @@ public:
     uint32_t last_update_timestamp_ = 0;
     uint32_t n_evt_sampling_ = 0;
     uint32_t n_evt_control_loop_ = 0;
+    float sync_move_goals_[AXIS_COUNT] = {};
+    std::atomic<bool> sync_move_requested_{false};
     bool task_timers_armed_ = false;
     TaskTimes task_times_;
     const bool otp_valid_ = true; //((uint8_t*)FLASH_OTP_BASE)[0] != 0xff;
@@ -248,6 +255,10 @@ public:
 
 extern ODrive odrv; // defined in main.cpp
 
+// defined in control_loop.cpp
+void config_clear_all();
+bool config_apply_all();
+
 #endif // __cplusplus
 
 #endif /* __ODRIVE_MAIN_H */
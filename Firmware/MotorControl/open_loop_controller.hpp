@@ -22,11 +22,11 @@ public:
 
     // State/Outputs
     uint32_t timestamp_ = 0;
-    OutputPort<float2D> Idq_setpoint_ = {{0.0f, 0.0f}};
-    OutputPort<float2D> Vdq_setpoint_ = {{0.0f, 0.0f}};
-    OutputPort<float> phase_ = 0.0f;
-    OutputPort<float> phase_vel_ = 0.0f;
-    OutputPort<float> total_distance_ = 0.0f;
+    SignalOutput<float2D> Idq_setpoint_{SignalFrame::OPEN_LOOP_IDQ_SETPOINT};
+    SignalOutput<float2D> Vdq_setpoint_{SignalFrame::OPEN_LOOP_VDQ_SETPOINT};
+    SignalOutput<float> phase_{SignalFrame::OPEN_LOOP_PHASE};
+    SignalOutput<float> phase_vel_{SignalFrame::OPEN_LOOP_PHASE_VEL};
+    SignalOutput<float> total_distance_{SignalFrame::OPEN_LOOP_TOTAL_DISTANCE};
 };
 
 #endif // __OPEN_LOOP_CONTROLLER_HPP
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <autogen/interfaces.hpp>
 #include <variant>
+#include "svm.hpp"
 
 template<size_t N_PHASES>
 class PhaseControlLaw {
@@ -71,6 +72,12 @@ public:
 };
 
 class AlphaBetaFrameController : public PhaseControlLaw<3> {
+public:
+    // Zero sequence of the modulator and the phases whose current is sensed
+    // (see SVM()). Measurement laws leave this at continuous modulation.
+    SvmMode svm_mode_ = SVM_MODE_CONTINUOUS;
+    uint8_t svm_sensed_phases_ = 0;
+
 private:
     ODriveIntf::MotorIntf::Error on_measurement(
             std::optional<float> vbus_voltage,
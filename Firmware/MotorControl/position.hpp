@@ -0,0 +1,122 @@
+#ifndef __POSITION_HPP
+#define __POSITION_HPP
+
+#include <cmath>
+#include <stdint.h>
+
+/**
+ * @brief Linear position as a whole number of units plus a fraction in [0, 1).
+ *
+ * The unit is turns, except inside the encoder PLL which works in counts.
+ *
+ * A float has 24 significant bits, so a float position in turns loses single
+ * counts of an 8192 cpr encoder beyond 2048 turns and keeps losing resolution
+ * from there. This type resolves 2^-24 units anywhere in the int64 range.
+ * Differences are formed from the whole and the fractional parts separately,
+ * so the position error of two nearby positions is exact no matter how far
+ * they are from zero.
+ */
+class Position {
+public:
+    constexpr Position() = default;
+
+    // Implicit so that float positions (from the protocol, the trajectory
+    // planners and the tests) can be assigned directly. The value is split
+    // without rounding. NaN and inf stay visible in to_float().
+    Position(float value) : frac_(value) { normalize(); }
+
+    static Position from_parts(int64_t whole, float frac) {
+        Position pos;
+        pos.whole_ = whole;
+        pos.frac_ = frac;
+        pos.normalize();
+        return pos;
+    }
+
+    /**
+     * @brief Converts a position in counts to turns, at cpr counts per turn.
+     * The division of the whole counts is exact.
+     */
+    static Position from_counts(const Position& counts, int32_t cpr) {
+        int64_t turns;
+        int32_t rem;
+        if (counts.whole_ == (int32_t)counts.whole_) {
+            // 32 bit division is a single instruction, 64 bit is a library call
+            turns = (int32_t)counts.whole_ / cpr;
+            rem = (int32_t)counts.whole_ % cpr;
+        } else {
+            turns = counts.whole_ / cpr;
+            rem = (int32_t)(counts.whole_ % cpr);
+        }
+        if (rem < 0) {
+            rem += cpr;
+            turns--;
+        }
+        return from_parts(turns, ((float)rem + counts.frac_) / (float)cpr);
+    }
+
+    int64_t whole() const { return whole_; }
+    float frac() const { return frac_; }
+
+    // Loses resolution far from zero, use differences where possible
+    float to_float() const { return (float)whole_ + frac_; }
+
+    Position& operator+=(float delta) {
+        if (std::abs(delta) < kMaxInt32) {
+            // Add the whole part separately so that frac_ is not rounded to
+            // the resolution of delta. The truncation is exact.
+            int32_t whole = (int32_t)delta;
+            whole_ += whole;
+            frac_ += delta - (float)whole;
+        } else {
+            Position d{delta};
+            whole_ += d.whole_;
+            frac_ += d.frac_;
+        }
+        normalize();
+        return *this;
+    }
+    Position& operator-=(float delta) { return *this += -delta; }
+    Position operator+(float delta) const { Position pos = *this; return pos += delta; }
+    Position operator-(float delta) const { Position pos = *this; return pos -= delta; }
+
+    // Difference [unit], exact if it is representable as a float
+    float operator-(const Position& other) const {
+        return (float)(whole_ - other.whole_) + (frac_ - other.frac_);
+    }
+
+    bool operator==(const Position& other) const { return whole_ == other.whole_ && frac_ == other.frac_; }
+    bool operator!=(const Position& other) const { return !(*this == other); }
+
+private:
+    static constexpr float kMaxInt32 = 2147483648.0f;
+
+    void normalize() {
+        if (frac_ >= 0.0f && frac_ < 1.0f) {
+            return;
+        }
+        if (std::abs(frac_) < kMaxInt32) {
+            // floor() through a truncating conversion, which is much cheaper
+            int32_t whole = (int32_t)frac_;
+            whole -= ((float)whole > frac_) ? 1 : 0;
+            whole_ += whole;
+            frac_ -= (float)whole;
+        } else if (std::isfinite(frac_)) {
+            float whole = std::floor(frac_);
+            whole_ += (int64_t)whole;
+            frac_ -= whole;
+        } else {
+            return; // NaN or inf
+        }
+        if (frac_ >= 1.0f) {
+            // a tiny negative fraction rounds up to 1
+            frac_ = 0.0f;
+            whole_++;
+        }
+    }
+
+    int64_t whole_ = 0;
+    float frac_ = 0.0f;
+};
+
+#endif // __POSITION_HPP
@@ -0,0 +1,183 @@
+#ifndef __PVT_BUFFER_HPP
+#define __PVT_BUFFER_HPP
+
+#include <atomic>
+#include <cmath>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Queue of streamed position-velocity-time (PVT) points and the
+ * interpolator that plays them back at the control loop rate.
+ *
+ * Each point specifies where the axis should be (pos, vel) after a duration dt
+ * relative to the previous point. Between two points the setpoint follows the
+ * cubic Hermite spline that matches position and velocity at both ends. The
+ * setpoint is therefore continuous in position and velocity and irregular
+ * arrival of the points (e.g. USB jitter) does not show up in the motion as
+ * long as the buffer does not run empty.
+ *
+ * The ring buffer is lock-free with a single producer (the protocol that
+ * receives the points) and a single consumer (the control loop). Points must
+ * only be pushed from one protocol at a time.
+ */
+class PvtBuffer {
+public:
+    static constexpr size_t kCapacity = 64; // Must be a power of two
+
+    struct Point_t {
+        float pos; // [turn]
+        float vel; // [turn/s]
+        float dt;  // [s] duration from the previous point to this point
+    };
+
+    struct Step_t {
+        float Y;   // [turn]
+        float Yd;  // [turn/s]
+        float Ydd; // [turn/s^2]
+    };
+
+    // Producer side ---------------------------------------------------------------
+
+    /**
+     * @brief Appends a point to the buffer. Returns false if the point is
+     * invalid or if the buffer is full. A full buffer counts as an overrun.
+     */
+    bool push(const Point_t& point) {
+        if (!std::isfinite(point.pos) || !std::isfinite(point.vel) || !(point.dt > 0.0f) || !std::isfinite(point.dt)) {
+            return false;
+        }
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= kCapacity) {
+            overrun_count_++;
+            return false;
+        }
+        points_[head % kCapacity] = point;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Discards all points that have not been played yet and stops the playback. */
+    void clear() {
+        clear_head_.store(head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        clear_requested_.store(true, std::memory_order_release);
+    }
+
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    // Consumer side ---------------------------------------------------------------
+
+    /**
+     * @brief Advances the playback by dt and returns the new setpoint.
+     *
+     * If the playback is stopped, the next point in the buffer starts a new
+     * segment at the current setpoint (pos, vel).
+     * Returns false if there is no new setpoint, i.e. if the playback is
+     * stopped and the buffer is empty. The caller should then hold its
+     * setpoint.
+     */
+    bool update(float dt, float pos, float vel, Step_t* step) {
+        if (clear_requested_.exchange(false, std::memory_order_acquire)) {
+            // Points that were pushed after the clear request are kept
+            uint32_t clear_head = clear_head_.load(std::memory_order_relaxed);
+            if ((int32_t)(clear_head - tail_.load(std::memory_order_relaxed)) > 0) {
+                tail_.store(clear_head, std::memory_order_release);
+            }
+            active_ = false;
+        }
+
+        if (!active_) {
+            if (!pop(&target_)) {
+                return false;
+            }
+            start_ = {pos, vel, 0.0f};
+            t_ = 0.0f;
+            active_ = true;
+        }
+
+        t_ += dt;
+        while (t_ >= target_.dt) {
+            Point_t next;
+            if (!pop(&next)) {
+                // Buffer ran empty: stop at the last point. This is only an
+                // underrun if the axis was supposed to keep moving.
+                if (target_.vel != 0.0f) {
+                    underrun_count_++;
+                }
+                active_ = false;
+                *step = {target_.pos, 0.0f, 0.0f};
+                return true;
+            }
+            t_ -= target_.dt;
+            start_ = target_;
+            target_ = next;
+        }
+
+        *step = eval(t_);
+        return true;
+    }
+
+    bool is_active() const { return active_; }
+
+    uint32_t underrun_count_ = 0;
+    uint32_t overrun_count_ = 0;
+
+private:
+    bool pop(Point_t* point) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        *point = points_[tail % kCapacity];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Evaluates the cubic Hermite spline between start_ and target_ at time t
+    // since start_.
+    Step_t eval(float t) const {
+        float T = target_.dt;
+        float s = t / T;
+        float s2 = s * s;
+        float s3 = s2 * s;
+        float dp = target_.pos - start_.pos;
+        float v0 = start_.vel * T;
+        float v1 = target_.vel * T;
+
+        // Basis functions h00 + h01 = 1, so the position is computed relative
+        // to the start point to avoid cancellation for large positions.
+        float h01 = -2.0f*s3 + 3.0f*s2;
+        float h10 = s3 - 2.0f*s2 + s;
+        float h11 = s3 - s2;
+        float dh01 = -6.0f*s2 + 6.0f*s;
+        float dh10 = 3.0f*s2 - 4.0f*s + 1.0f;
+        float dh11 = 3.0f*s2 - 2.0f*s;
+        float ddh01 = -12.0f*s + 6.0f;
+        float ddh10 = 6.0f*s - 4.0f;
+        float ddh11 = 6.0f*s - 2.0f;
+
+        return {
+            start_.pos + h01*dp + h10*v0 + h11*v1,
+            (dh01*dp + dh10*v0 + dh11*v1) / T,
+            (ddh01*dp + ddh10*v0 + ddh11*v1) / (T * T)
+        };
+    }
+
+    Point_t points_[kCapacity];
+    std::atomic<uint32_t> head_{0}; // Only written by the producer
+    std::atomic<uint32_t> tail_{0}; // Only written by the consumer
+    std::atomic<uint32_t> clear_head_{0}; // Value of head_ at the last clear request
+    std::atomic<bool> clear_requested_{false};
+
+    // Playback state (only accessed by the consumer)
+    bool active_ = false;
+    Point_t start_ = {};
+    Point_t target_ = {};
+    float t_ = 0.0f; // [s] time since start_
+};
+
+static_assert((PvtBuffer::kCapacity & (PvtBuffer::kCapacity - 1)) == 0, "capacity must be a power of two");
+
+#endif // __PVT_BUFFER_HPP
@@ -0,0 +1,169 @@
+#include "scurveTraj.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Symbol          Description
+// Xi, Vi, Ai      Initial position, velocity and acceleration
+// Xf              Position set-point
+// Vp              Peak velocity of a candidate profile
+// s               Direction (sign) of the trajectory
+// Vmax, Amax,
+// Dmax and Jmax   Kinematic bounds
+// Vr              Reached velocity
+
+// Advances a state by a segment of constant jerk J and duration T.
+static SCurveTrajectory::Step_t integrate(const SCurveTrajectory::Step_t& x, float J, float T) {
+    return {
+        x.Y + x.Yd*T + 0.5f*x.Ydd*T*T + (1.0f/6.0f)*J*T*T*T,
+        x.Yd + x.Ydd*T + 0.5f*J*T*T,
+        x.Ydd + J*T
+    };
+}
+
+// Plans the shortest change of velocity from (v0, a0) to (v1, 0) that satisfies
+// the acceleration and jerk limits. The result are three segments: jerk towards
+// the peak acceleration, constant acceleration, jerk back to zero acceleration.
+// Amax applies when speeding up, Dmax when slowing down and the lower of both
+// when the direction of motion reverses.
+static void plan_velocity_change(float v0, float a0, float v1, float Amax, float Dmax, float Jmax,
+                                 float (&T)[3], float (&J)[3]) {
+    float v_ramp = v0 + a0 * std::abs(a0) / (2.0f * Jmax); // Velocity after ramping a0 to zero
+    float d = std::copysign(1.0f, v1 - v_ramp); // Direction of the acceleration
+    float A = (v1 * v_ramp < 0.0f) ? std::min(Amax, Dmax)
+            : (std::abs(v1) <= std::abs(v_ramp)) ? Dmax : Amax;
+    float Ap = d * A; // Peak acceleration (signed)
+    float J0 = std::copysign(Jmax, Ap - a0);
+
+    // Velocity change if the peak acceleration is reached without any time
+    // spent at constant acceleration
+    float dv_ramps = (Ap*Ap - a0*a0) / (2.0f * J0) + d * Ap*Ap / (2.0f * Jmax);
+    float Tc = (v1 - v0 - dv_ramps) / Ap;
+
+    if (Tc < 0.0f) {
+        // Peak acceleration not reached (triangle acceleration profile)
+        Ap = d * std::sqrt(std::max(0.0f, 0.5f * (2.0f * Jmax * d * (v1 - v0) + a0*a0)));
+        J0 = std::copysign(Jmax, Ap - a0);
+        Tc = 0.0f;
+    }
+
+    T[0] = std::max(0.0f, (Ap - a0) / J0);
+    T[1] = Tc;
+    T[2] = std::abs(Ap) / Jmax;
+    J[0] = J0;
+    J[1] = 0.0f;
+    J[2] = -d * Jmax;
+}
+
+// Displacement of the profile without coast phase that peaks at velocity Vp.
+static float no_coast_displacement(float Vi, float Ai, float Vp, float Amax, float Dmax, float Jmax) {
+    float T[3], J[3];
+    SCurveTrajectory::Step_t x = {0.0f, Vi, Ai};
+    plan_velocity_change(Vi, Ai, Vp, Amax, Dmax, Jmax, T, J);
+    for (size_t i = 0; i < 3; ++i) {
+        x = integrate(x, J[i], T[i]);
+    }
+    plan_velocity_change(Vp, 0.0f, 0.0f, Amax, Dmax, Jmax, T, J);
+    x.Yd = Vp;
+    x.Ydd = 0.0f;
+    for (size_t i = 0; i < 3; ++i) {
+        x = integrate(x, J[i], T[i]);
+    }
+    return x.Y;
+}
+
+bool SCurveTrajectory::planSCurve(float Xf, float Xi, float Vi, float Ai,
+                                  float Vmax, float Amax, float Dmax, float Jmax) {
+    if (!(Vmax > 0.0f && Amax > 0.0f && Dmax > 0.0f && Jmax > 0.0f)) {
+        return false;
+    }
+
+    float dX = Xf - Xi; // Distance to travel
+    float dXstop = no_coast_displacement(Vi, Ai, 0.0f, Amax, Dmax, Jmax); // Minimum stopping displacement
+    float s = std::copysign(1.0f, dX - dXstop); // Sign of coast velocity (if any)
+    float Vp = s * Vmax;
+    float dXmin = no_coast_displacement(Vi, Ai, Vp, Amax, Dmax, Jmax); // Displacement required to reach cruising speed
+
+    // Tolerance below which Xf counts as reached by a direct stop. Without it,
+    // rounding errors would append a tiny extra move to the end of every replan.
+    float eps = 1e-6f * std::max({1.0f, std::abs(Xi), std::abs(Xf)});
+
+    float Tv;
+    if (std::abs(dX - dXstop) <= eps) {
+        // Stop as quickly as possible
+        Vp = 0.0f;
+        Tv = 0.0f;
+    } else if (s*dX >= s*dXmin) {
+        // Long move (profile with coast phase)
+        Tv = (dX - dXmin) / Vp;
+    } else {
+        // Short move: find the peak velocity that ends exactly at Xf. The
+        // displacement grows monotonically with the peak velocity, so a
+        // bisection between 0 and Vmax converges.
+        float lo = 0.0f;
+        float hi = Vp;
+        for (size_t i = 0; i < 32; ++i) {
+            float mid = 0.5f * (lo + hi);
+            if (s * no_coast_displacement(Vi, Ai, mid, Amax, Dmax, Jmax) < s*dX) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        Vp = 0.5f * (lo + hi);
+        Tv = 0.0f;
+    }
+
+    float T[3], J[3];
+    plan_velocity_change(Vi, Ai, Vp, Amax, Dmax, Jmax, T, J);
+    T_[0] = T[0]; T_[1] = T[1]; T_[2] = T[2];
+    J_[0] = J[0]; J_[1] = J[1]; J_[2] = J[2];
+    T_[3] = Tv;
+    J_[3] = 0.0f;
+    plan_velocity_change(Vp, 0.0f, 0.0f, Amax, Dmax, Jmax, T, J);
+    T_[4] = T[0]; T_[5] = T[1]; T_[6] = T[2];
+    J_[4] = J[0]; J_[5] = J[1]; J_[6] = J[2];
+
+    // The acceleration and coast segments start from the initial state...
+    start_[0] = {Xi, Vi, Ai};
+    t_start_[0] = 0.0f;
+    for (size_t i = 1; i < 4; ++i) {
+        start_[i] = integrate(start_[i - 1], J_[i - 1], T_[i - 1]);
+        t_start_[i] = t_start_[i - 1] + T_[i - 1];
+    }
+    start_[3].Ydd = 0.0f;
+
+    // ...while the deceleration segments are anchored at the final state such
+    // that the trajectory ends exactly at Xf.
+    Step_t x = {Xf, 0.0f, 0.0f};
+    for (size_t i = 6; i >= 4; --i) {
+        x = integrate(x, J_[i], -T_[i]);
+        start_[i] = x;
+    }
+    for (size_t i = 4; i < 7; ++i) {
+        t_start_[i] = t_start_[i - 1] + T_[i - 1];
+    }
+
+    Tf_ = t_start_[6] + T_[6];
+    Xi_ = Xi;
+    Xf_ = Xf;
+    Vi_ = Vi;
+    Ai_ = Ai;
+    Vr_ = Vp;
+
+    return true;
+}
+
+SCurveTrajectory::Step_t SCurveTrajectory::eval(float t) {
+    if (t < 0.0f) {  // Initial Condition
+        return {Xi_, Vi_, Ai_};
+    } else if (t >= Tf_) {  // Final Condition
+        return {Xf_, 0.0f, 0.0f};
+    }
+
+    size_t i = 6;
+    while (i > 0 && t < t_start_[i]) {
+        i--;
+    }
+    return integrate(start_[i], J_[i], t - t_start_[i]);
+}
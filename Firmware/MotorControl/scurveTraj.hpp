@@ -0,0 +1,49 @@
+#ifndef _SCURVE_TRAJ_H
+#define _SCURVE_TRAJ_H
+
+/**
+ * @brief Jerk limited ("S-curve") point-to-point trajectory planner.
+ *
+ * The profile consists of seven segments of constant jerk:
+ *
+ *   0..2  change the velocity from the initial velocity to the reached
+ *         velocity Vr_ (jerk, constant acceleration, jerk)
+ *   3     coast at Vr_
+ *   4..6  decelerate from Vr_ to standstill (jerk, constant deceleration, jerk)
+ *
+ * Any of the segments can have zero duration. The initial velocity and
+ * acceleration can be non-zero, so replanning in the middle of a move
+ * produces a setpoint that is continuous up to the acceleration.
+ *
+ * This class does not depend on the rest of the firmware so that it can be
+ * tested on the host.
+ */
+class SCurveTrajectory {
+public:
+    struct Step_t {
+        float Y;
+        float Yd;
+        float Ydd;
+    };
+
+    bool planSCurve(float Xf, float Xi, float Vi, float Ai,
+                    float Vmax, float Amax, float Dmax, float Jmax);
+    Step_t eval(float t);
+
+    float Xi_ = 0.0f;
+    float Xf_ = 0.0f;
+    float Vi_ = 0.0f;
+    float Ai_ = 0.0f;
+
+    float Vr_ = 0.0f;      // Reached velocity (signed)
+
+    float T_[7] = {};      // Duration of each segment
+    float J_[7] = {};      // Jerk of each segment (signed)
+    float t_start_[7] = {}; // Start time of each segment
+    Step_t start_[7] = {}; // State at the start of each segment
+    float Tf_ = 0.0f;
+
+    float t_ = 0.0f;
+};
+
+#endif
@@ -23,9 +23,9 @@ public:
     float flux_state_[2] = {0.0f, 0.0f};        // [Vs]
     float V_alpha_beta_memory_[2] = {0.0f, 0.0f}; // [V]
 
-    OutputPort<float> phase_ = 0.0f;                   // [rad]
-    OutputPort<float> phase_vel_ = 0.0f;               // [rad/s]
-    OutputPort<float> vel_estimate_ = 0.0f;            // [turns/s]
+    SignalOutput<float> phase_{SignalFrame::SENSORLESS_PHASE};                // [rad]
+    SignalOutput<float> phase_vel_{SignalFrame::SENSORLESS_PHASE_VEL};        // [rad/s]
+    SignalOutput<float> vel_estimate_{SignalFrame::SENSORLESS_VEL_ESTIMATE};  // [turns/s]
 };
 
 #endif /* __SENSORLESS_ESTIMATOR_HPP */
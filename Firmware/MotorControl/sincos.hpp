@@ -0,0 +1,76 @@
+#ifndef __SINCOS_HPP
+#define __SINCOS_HPP
+
+#include <cmath>
+#include <stdint.h>
+#include <utility>
+
+// 512 entry sine table (plus one wrap-around entry) of our_arm_sin_f32() and
+// our_arm_cos_f32(), see arm_common_tables.h
+extern "C" const float sinTable_f32[];
+
+/**
+ * @brief Returns {sin(x), cos(x)} [x in rad] from a single index computation
+ * in the sine table. The cosine is read a quarter period (128 entries)
+ * further on. Both are interpolated linearly like in our_arm_sin_f32().
+ *
+ * The interpolation error is at most h^2/8 with h = 2pi/512, so the
+ * absolute error of either value is below 1.9e-5 (plus float rounding of x
+ * for large |x|).
+ */
+inline std::pair<float, float> fast_sincos(float x, const float* table = sinTable_f32) {
+    constexpr uint32_t kSize = 512;
+
+    // Map to [0, 1) turns
+    float in = x * 0.159154943092f;
+    int32_t n = (int32_t)in;
+    if (in < 0.0f) {
+        n--;
+    }
+    in -= (float)n;
+
+    float findex = (float)kSize * in;
+    uint32_t index = (uint32_t)findex;
+    if (index >= kSize) {
+        // in rounded up to exactly 1
+        index = 0;
+        findex -= (float)kSize;
+    }
+    float fract = findex - (float)index;
+    uint32_t index_c = (index + kSize / 4) & (kSize - 1);
+
+    float s = table[index] + fract * (table[index + 1] - table[index]);
+    float c = table[index_c] + fract * (table[index_c + 1] - table[index_c]);
+    return {s, c};
+}
+
+// Largest angle [rad] by which sincos_rotate() rotates without a new lookup
+constexpr float kMaxSincosRotation = 0.5f;
+
+/**
+ * @brief Returns {sin(x + delta), cos(x + delta)} from sincos_x =
+ * fast_sincos(x).
+ *
+ * For |delta| <= kMaxSincosRotation, sincos_x is rotated by delta, with
+ * sin(delta) and cos(delta) from their Taylor series up to delta^5 and
+ * delta^4. The truncation error is below |delta|^6 / 720 (2.2e-5 at 0.5 rad),
+ * so the result is within 4.1e-5 of the exact values. Larger angles fall back
+ * to fast_sincos(x + delta).
+ *
+ * This is meant for angles that are extrapolated from the same estimate to
+ * slightly different times, e.g. the measurement and the output of the
+ * current controller.
+ */
+inline std::pair<float, float> sincos_rotate(std::pair<float, float> sincos_x, float x, float delta,
+                                             const float* table = sinTable_f32) {
+    if (!(std::abs(delta) <= kMaxSincosRotation)) {
+        return fast_sincos(x + delta, table);
+    }
+    float d2 = delta * delta;
+    float s_d = delta * (1.0f - d2 * (1.0f / 6.0f) * (1.0f - d2 * (1.0f / 20.0f)));
+    float c_d = 1.0f - d2 * 0.5f * (1.0f - d2 * (1.0f / 12.0f));
+    auto [s, c] = sincos_x;
+    return {s * c_d + c * s_d, c * c_d - s * s_d};
+}
+
+#endif // __SINCOS_HPP
@@ -0,0 +1,90 @@
+#ifndef __SSI_BISS_FRAME_HPP
+#define __SSI_BISS_FRAME_HPP
+
+#include <stdint.h>
+
+/**
+ * @brief Decoders for the frames of SSI and BiSS-C absolute encoders that are
+ * clocked in over SPI.
+ *
+ * A frame is the received bits MSB first, the first bit that was clocked in
+ * is bit 63. The position data is the multi-turn count followed by the
+ * single-turn position, both binary MSB first, and is returned right aligned.
+ */
+static constexpr uint32_t kSsiBissMaxDataBits = 40;
+
+/**
+ * @brief CRC of BiSS-C single cycle data, polynomial x^6 + x + 1, start value
+ * 0, over the lowest `bits` bits of data MSB first. The encoder sends it
+ * inverted.
+ */
+inline uint8_t biss_crc6(uint64_t data, uint32_t bits) {
+    uint8_t crc = 0;
+    for (uint32_t i = bits; i-- > 0;) {
+        uint8_t in = (uint8_t)((data >> i) & 1) ^ (uint8_t)(crc >> 5);
+        crc = (uint8_t)((crc << 1) & 0x3f);
+        if (in) {
+            crc ^= 0x03;
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Decodes an SSI frame: one leading 1 that is clocked in while the
+ * encoder latches the position, data_bits of data and a 0 while the encoder
+ * holds the line low after the data. SSI has no CRC, the leading and
+ * trailing bits reject a line that is stuck high or low.
+ */
+inline bool decode_ssi_frame(uint64_t frame, uint32_t data_bits, uint64_t* data) {
+    if (data_bits == 0 || data_bits > kSsiBissMaxDataBits) {
+        return false;
+    }
+    uint32_t data_lsb = 63 - data_bits; // bit index of the LSB of the data
+    if (!((frame >> 63) & 1) || ((frame >> (data_lsb - 1)) & 1)) {
+        return false;
+    }
+    *data = (frame >> data_lsb) & ((UINT64_C(1) << data_bits) - 1);
+    return true;
+}
+
+/**
+ * @brief Decodes a BiSS-C frame: The line is high until the encoder
+ * acknowledges with a 0 for as many clocks as it needs to latch the position,
+ * followed by the start bit (1), the CDS bit, data_bits of data, the active
+ * low error and warning bits and the inverted CRC6 over data, error and
+ * warning.
+ * @returns false if the start bit is not found, the frame is too short, the
+ * CRC does not match or the encoder reports an error.
+ */
+inline bool decode_biss_c_frame(uint64_t frame, uint32_t data_bits, uint64_t* data) {
+    if (data_bits == 0 || data_bits > kSsiBissMaxDataBits) {
+        return false;
+    }
+    int bit = 63;
+    while (bit >= 0 && ((frame >> bit) & 1)) {
+        bit--; // before the acknowledge
+    }
+    while (bit >= 0 && !((frame >> bit) & 1)) {
+        bit--; // acknowledge
+    }
+    // bit is the start bit now, followed by CDS, data, nE, nW and CRC
+    const int payload_bits = (int)data_bits + 2 + 6;
+    int payload_lsb = bit - 1 - payload_bits;
+    if (bit < 0 || payload_lsb < 0) {
+        return false;
+    }
+    uint64_t payload = (frame >> payload_lsb) & ((UINT64_C(1) << payload_bits) - 1);
+    uint8_t crc = (uint8_t)(~payload & 0x3f);
+    uint64_t checked = payload >> 6; // data, nE, nW
+    if (biss_crc6(checked, data_bits + 2) != crc) {
+        return false;
+    }
+    if (!((checked >> 1) & 1)) {
+        return false; // nE
+    }
+    *data = checked >> 2;
+    return true;
+}
+
+#endif // __SSI_BISS_FRAME_HPP
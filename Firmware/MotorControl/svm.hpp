@@ -0,0 +1,248 @@
+#ifndef __SVM_HPP
+#define __SVM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <tuple>
+
+#include "utils.hpp"
+
+/**
+ * @brief Zero sequence choices of the space vector modulator.
+ *
+ * All modes produce the same line-to-line voltages and differ only in how the
+ * zero vector time is split between V0 (all phases low) and V7 (all phases
+ * high).
+ *
+ *  - SVM_MODE_CONTINUOUS: V0 and V7 are equally long, every phase switches
+ *    every period.
+ *  - SVM_MODE_DPWM_MIN / SVM_MODE_DPWM_MAX: V7 (V0) is dropped, the phase with
+ *    the lowest (highest) voltage is clamped to the negative (positive) rail.
+ *  - SVM_MODE_DPWM1: the phase with the largest voltage magnitude is clamped to
+ *    its rail, i.e. each phase is clamped for 60° centered on its voltage peaks.
+ *  - SVM_MODE_DPWM0 / SVM_MODE_DPWM2: like DPWM1 but the clamped intervals
+ *    are shifted by 30° so that they end / start at the voltage peaks. DPWM2
+ *    clamps the phases while they carry their peak current in lagging
+ *    (inductive) loads.
+ *
+ * In the discontinuous modes one phase does not switch at all during a
+ * period, so there are a third fewer switching events.
+ */
+enum SvmMode {
+    SVM_MODE_CONTINUOUS,
+    SVM_MODE_DPWM0,
+    SVM_MODE_DPWM1,
+    SVM_MODE_DPWM2,
+    SVM_MODE_DPWM_MIN,
+    SVM_MODE_DPWM_MAX,
+};
+
+// Shortest low-side on-time (as a fraction of the period, centered on the
+// current sampling instant) that the discontinuous modes leave a phase with a
+// current shunt. It is what continuous SVM leaves at
+// FieldOrientedController::max_mod.
+constexpr float kSvmMinSenseWindow = 0.1f;
+
+// Compute rising edge timings (0.0 - 1.0) as a function of alpha-beta
+// as per the magnitude invariant clarke transform
+// The magnitude of the alpha-beta vector may not be larger than sqrt(3)/2
+// Returns true on success, and false if the input was out of range
+inline std::tuple<float, float, float, bool> SVM(float alpha, float beta) {
+    float tA, tB, tC;
+    int Sextant;
+
+    if (beta >= 0.0f) {
+        if (alpha >= 0.0f) {
+            //quadrant I
+            if (one_by_sqrt3 * beta > alpha)
+                Sextant = 2; //sextant v2-v3
+            else
+                Sextant = 1; //sextant v1-v2
+        } else {
+            //quadrant II
+            if (-one_by_sqrt3 * beta > alpha)
+                Sextant = 3; //sextant v3-v4
+            else
+                Sextant = 2; //sextant v2-v3
+        }
+    } else {
+        if (alpha >= 0.0f) {
+            //quadrant IV
+            if (-one_by_sqrt3 * beta > alpha)
+                Sextant = 5; //sextant v5-v6
+            else
+                Sextant = 6; //sextant v6-v1
+        } else {
+            //quadrant III
+            if (one_by_sqrt3 * beta > alpha)
+                Sextant = 4; //sextant v4-v5
+            else
+                Sextant = 5; //sextant v5-v6
+        }
+    }
+
+    switch (Sextant) {
+        // sextant v1-v2
+        case 1: {
+            // Vector on-times
+            float t1 = alpha - one_by_sqrt3 * beta;
+            float t2 = two_by_sqrt3 * beta;
+
+            // PWM timings
+            tA = (1.0f - t1 - t2) * 0.5f;
+            tB = tA + t1;
+            tC = tB + t2;
+        } break;
+
+        // sextant v2-v3
+        case 2: {
+            // Vector on-times
+            float t2 = alpha + one_by_sqrt3 * beta;
+            float t3 = -alpha + one_by_sqrt3 * beta;
+
+            // PWM timings
+            tB = (1.0f - t2 - t3) * 0.5f;
+            tA = tB + t3;
+            tC = tA + t2;
+        } break;
+
+        // sextant v3-v4
+        case 3: {
+            // Vector on-times
+            float t3 = two_by_sqrt3 * beta;
+            float t4 = -alpha - one_by_sqrt3 * beta;
+
+            // PWM timings
+            tB = (1.0f - t3 - t4) * 0.5f;
+            tC = tB + t3;
+            tA = tC + t4;
+        } break;
+
+        // sextant v4-v5
+        case 4: {
+            // Vector on-times
+            float t4 = -alpha + one_by_sqrt3 * beta;
+            float t5 = -two_by_sqrt3 * beta;
+
+            // PWM timings
+            tC = (1.0f - t4 - t5) * 0.5f;
+            tB = tC + t5;
+            tA = tB + t4;
+        } break;
+
+        // sextant v5-v6
+        case 5: {
+            // Vector on-times
+            float t5 = -alpha - one_by_sqrt3 * beta;
+            float t6 = alpha - one_by_sqrt3 * beta;
+
+            // PWM timings
+            tC = (1.0f - t5 - t6) * 0.5f;
+            tA = tC + t5;
+            tB = tA + t6;
+        } break;
+
+        // sextant v6-v1
+        case 6: {
+            // Vector on-times
+            float t6 = -two_by_sqrt3 * beta;
+            float t1 = alpha + one_by_sqrt3 * beta;
+
+            // PWM timings
+            tA = (1.0f - t6 - t1) * 0.5f;
+            tC = tA + t1;
+            tB = tC + t6;
+        } break;
+
+        default: {
+            return {0.0f, 0.0f, 0.0f, false};
+        }
+    }
+
+    bool result_valid =
+            tA >= 0.0f && tA <= 1.0f
+         && tB >= 0.0f && tB <= 1.0f
+         && tC >= 0.0f && tC <= 1.0f;
+    return {tA, tB, tC, result_valid};
+}
+
+/**
+ * @brief Same as SVM(alpha, beta) but with the zero sequence of the given mode.
+ *
+ * The current is sampled in the middle of V0, through low-side shunts. A phase
+ * in sensed_phases (bit 0 = A) therefore must not be clamped to the positive
+ * rail, and its low-side on-time must stay above kSvmMinSenseWindow. In
+ * periods where the mode would violate this, the phase with the lowest voltage
+ * is clamped to the negative rail instead, which only lengthens V0.
+ *
+ * The clamped phase is set to exactly 0.0 or 1.0, so that it produces no
+ * pulse after the conversion to timer compare values.
+ */
+inline std::tuple<float, float, float, bool> SVM(float alpha, float beta, SvmMode mode, uint8_t sensed_phases) {
+    auto [tA, tB, tC, result_valid] = SVM(alpha, beta);
+    if (mode == SVM_MODE_CONTINUOUS || !result_valid) {
+        return {tA, tB, tC, result_valid};
+    }
+
+    float t[3] = {tA, tB, tC};
+    size_t i_min = 0;
+    size_t i_max = 0;
+    for (size_t i = 1; i < 3; ++i) {
+        i_min = (t[i] < t[i_min]) ? i : i_min;
+        i_max = (t[i] > t[i_max]) ? i : i_max;
+    }
+
+    // A lower timing means a higher phase voltage
+    bool clamp_high;
+    switch (mode) {
+        case SVM_MODE_DPWM_MAX: {
+            clamp_high = true;
+        } break;
+
+        case SVM_MODE_DPWM_MIN: {
+            clamp_high = false;
+        } break;
+
+        case SVM_MODE_DPWM0:
+        case SVM_MODE_DPWM1:
+        case SVM_MODE_DPWM2: {
+            // Clamp to the rail that the reference comes closest to. DPWM0 and
+            // DPWM2 judge that on the line-to-line voltages, which are the phase
+            // voltages rotated by +30° and -30°.
+            float mean = (t[0] + t[1] + t[2]) * (1.0f / 3.0f);
+            float v_peak = 0.0f;
+            for (size_t i = 0; i < 3; ++i) {
+                float v = (mode == SVM_MODE_DPWM0) ? t[(i + 1) % 3] - t[i]
+                        : (mode == SVM_MODE_DPWM2) ? t[(i + 2) % 3] - t[i]
+                        : mean - t[i];
+                v_peak = (std::abs(v) > std::abs(v_peak)) ? v : v_peak;
+            }
+            clamp_high = v_peak > 0.0f;
+        } break;
+
+        default: {
+            // Unknown modes fall back to centered SVM
+            return {tA, tB, tC, result_valid};
+        }
+    }
+
+    if (clamp_high) {
+        for (size_t i = 0; i < 3; ++i) {
+            if ((sensed_phases & (1 << i)) && (t[i] - t[i_min] < kSvmMinSenseWindow)) {
+                clamp_high = false;
+            }
+        }
+    }
+
+    size_t i_clamp = clamp_high ? i_min : i_max;
+    float offset = clamp_high ? -t[i_min] : 1.0f - t[i_max];
+    for (size_t i = 0; i < 3; ++i) {
+        t[i] = std::clamp(t[i] + offset, 0.0f, 1.0f);
+    }
+    t[i_clamp] = clamp_high ? 0.0f : 1.0f;
+
+    return {t[0], t[1], t[2], true};
+}
+
+#endif // __SVM_HPP
@@ -17,7 +17,7 @@ public:
                              const float& temp_limit_upper,
                              const bool& enabled);
 
-    void update();
+    void update(float dt);
     bool do_checks();
     float get_current_limit(float base_current_lim) const override;
 
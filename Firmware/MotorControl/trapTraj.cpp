@@ -14,8 +14,11 @@ float sign_hard(float val) {
 // s                          Direction (sign) of the trajectory
 // Vmax, Amax, Dmax and jmax  Kinematic bounds
 // Ar, Dr and Vr              Reached values of acceleration and velocity
+//
+// The profile is planned and evaluated as a displacement from Xi, so that it
+// has the same resolution at any distance from zero.
 
-bool TrapezoidalTrajectory::planTrapezoidal(float Xf, float Xi, float Vi,
+bool TrapezoidalTrajectory::planTrapezoidal(const Position& Xf, const Position& Xi, float Vi,
                                             float Vmax, float Amax, float Dmax) {
     float dX = Xf - Xi;  // Distance to travel
     float stop_dist = (Vi * Vi) / (2.0f * Dmax); // Minimum stopping distance
@@ -56,7 +59,47 @@ bool TrapezoidalTrajectory::planTrapezoidal(float Xf, float Xi, float Vi,
     Xi_ = Xi;
     Xf_ = Xf;
     Vi_ = Vi;
-    yAccel_ = Xi + Vi*Ta_ + 0.5f*Ar_*SQ(Ta_); // pos at end of accel phase
+    yAccel_ = Vi*Ta_ + 0.5f*Ar_*SQ(Ta_); // displacement at end of accel phase
+
+    return true;
+}
+
+// Plans a move that takes at least Tmin seconds. If the fastest profile is
+// shorter, the velocity, acceleration and deceleration limits are scaled down
+// by a common factor until the move takes Tmin. This stretches Ta, Tv and Td
+// in proportion, so when several axes with identical limits start at rest and
+// are stretched to the same duration, they move along a straight line. Axes
+// with different limits only start and finish together.
+//
+// Only moves that start at rest (Vi == 0) are stretched. From rest the
+// profile keeps its shape when the limits are scaled. With an initial
+// velocity, lower limits can make the profile overshoot the goal and return,
+// so Tf jumps and is not monotonic in the scale factor. Such moves are
+// planned as fast as possible.
+bool TrapezoidalTrajectory::planTrapezoidal(const Position& Xf, const Position& Xi, float Vi,
+                                            float Vmax, float Amax, float Dmax, float Tmin) {
+    planTrapezoidal(Xf, Xi, Vi, Vmax, Amax, Dmax);
+    if (!(Tf_ < Tmin) || Vi != 0.0f) {
+        return true;
+    }
+
+    // From rest, Tf is continuous and monotonically decreasing in the scale
+    // factor, so we can bisect. k_lo always gives Tf >= Tmin.
+    float k_lo = 0.0f;
+    float k_hi = 1.0f;
+    for (size_t i = 0; i < 24; ++i) {
+        float k = 0.5f * (k_lo + k_hi);
+        planTrapezoidal(Xf, Xi, Vi, k * Vmax, k * Amax, k * Dmax);
+        if (Tf_ < Tmin) {
+            k_hi = k;
+        } else {
+            k_lo = k;
+        }
+    }
+    // k_lo is still zero if even the slowest factor that was tried is too fast
+    // (e.g. zero distance)
+    float k = (k_lo > 0.0f) ? k_lo : k_hi;
+    planTrapezoidal(Xf, Xi, Vi, k * Vmax, k * Amax, k * Dmax);
 
     return true;
 }
@@ -68,11 +111,11 @@ TrapezoidalTrajectory::Step_t TrapezoidalTrajectory::eval(float t) {
         trajStep.Yd  = Vi_;
         trajStep.Ydd = 0.0f;
     } else if (t < Ta_) {  // Accelerating
-        trajStep.Y   = Xi_ + Vi_*t + 0.5f*Ar_*SQ(t);
+        trajStep.Y   = Xi_ + (Vi_*t + 0.5f*Ar_*SQ(t));
         trajStep.Yd  = Vi_ + Ar_*t;
         trajStep.Ydd = Ar_;
     } else if (t < Ta_ + Tv_) {  // Coasting
-        trajStep.Y   = yAccel_ + Vr_*(t - Ta_);
+        trajStep.Y   = Xi_ + (yAccel_ + Vr_*(t - Ta_));
         trajStep.Yd  = Vr_;
         trajStep.Ydd = 0.0f;
     } else if (t < Tf_) {  // Deceleration
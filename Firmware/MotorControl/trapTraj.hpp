@@ -1,29 +1,34 @@
 #ifndef _TRAP_TRAJ_H
 #define _TRAP_TRAJ_H
 
+#include "position.hpp"
+
 class TrapezoidalTrajectory {
 public:
     struct Config_t {
         float vel_limit = 2.0f;   // [turn/s]
         float accel_limit = 0.5f; // [turn/s^2]
         float decel_limit = 0.5f; // [turn/s^2]
+        float jerk_limit = 5.0f;  // [turn/s^3] only used by INPUT_MODE_SCURVE_TRAJ
     };
     
     struct Step_t {
-        float Y;
+        Position Y;
         float Yd;
         float Ydd;
     };
 
-    bool planTrapezoidal(float Xf, float Xi, float Vi,
+    bool planTrapezoidal(const Position& Xf, const Position& Xi, float Vi,
                          float Vmax, float Amax, float Dmax);
+    bool planTrapezoidal(const Position& Xf, const Position& Xi, float Vi,
+                         float Vmax, float Amax, float Dmax, float Tmin);
     Step_t eval(float t);
 
     Axis* axis_ = nullptr;  // set by Axis constructor
     Config_t config_;
 
-    float Xi_;
-    float Xf_;
+    Position Xi_;
+    Position Xf_;
     float Vi_;
 
     float Ar_;
@@ -35,7 +40,7 @@ public:
     float Td_;
     float Tf_;
 
-    float yAccel_;
+    float yAccel_; // displacement from Xi_ at the end of the accel phase
 
     float t_;
 };
@@ -0,0 +1,233 @@
+/*
+* @brief Contains board specific configuration for the host simulator.
+*
+* This file shadows Board/v3/Inc/board.h when building the simulator. It
+* mirrors the ODrive v3.x configuration (same timer setup, shunts and GPIO
+* numbering) but replaces all memory mapped peripherals with register blocks
+* in host memory and the DRV8301 with a simulated gate driver.
+*/
+
+#ifndef __BOARD_CONFIG_H
+#define __BOARD_CONFIG_H
+
+#include <stdbool.h>
+
+// STM specific includes
+// Only the type and register definitions of these headers are used. The HAL
+// functions that are called by the firmware are stubbed out in sim_hal.cpp.
+#include <stm32f4xx_hal.h>
+#include <gpio.h>
+#include <spi.h>
+#include <tim.h>
+#include <can.h>
+#include <i2c.h>
+#include <main.h>
+#include "cmsis_os.h"
+
+#include <Drivers/STM32/stm32_system.h>
+
+// Peripheral register blocks ----------------------------------------------------
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Indexed by the peripheral number as in the datasheet (index 0 is unused).
+extern TIM_TypeDef sim_tim_regs[15];
+extern GPIO_TypeDef sim_gpio_regs[9];
+extern ADC_TypeDef sim_adc_regs[4];
+extern SPI_TypeDef sim_spi_regs[4];
+extern RCC_TypeDef sim_rcc_regs;
+extern EXTI_TypeDef sim_exti_regs;
+extern SYSCFG_TypeDef sim_syscfg_regs;
+
+#ifdef __cplusplus
+}
+#endif
+
+#undef TIM1
+#undef TIM2
+#undef TIM3
+#undef TIM4
+#undef TIM5
+#undef TIM8
+#undef TIM13
+#undef TIM14
+#define TIM1 (&sim_tim_regs[1])
+#define TIM2 (&sim_tim_regs[2])
+#define TIM3 (&sim_tim_regs[3])
+#define TIM4 (&sim_tim_regs[4])
+#define TIM5 (&sim_tim_regs[5])
+#define TIM8 (&sim_tim_regs[8])
+#define TIM13 (&sim_tim_regs[13])
+#define TIM14 (&sim_tim_regs[14])
+
+#undef GPIOA
+#undef GPIOB
+#undef GPIOC
+#undef GPIOD
+#undef GPIOE
+#undef GPIOF
+#undef GPIOG
+#undef GPIOH
+#undef GPIOI
+#define GPIOA (&sim_gpio_regs[0])
+#define GPIOB (&sim_gpio_regs[1])
+#define GPIOC (&sim_gpio_regs[2])
+#define GPIOD (&sim_gpio_regs[3])
+#define GPIOE (&sim_gpio_regs[4])
+#define GPIOF (&sim_gpio_regs[5])
+#define GPIOG (&sim_gpio_regs[6])
+#define GPIOH (&sim_gpio_regs[7])
+#define GPIOI (&sim_gpio_regs[8])
+
+#undef ADC1
+#undef ADC2
+#undef ADC3
+#define ADC1 (&sim_adc_regs[1])
+#define ADC2 (&sim_adc_regs[2])
+#define ADC3 (&sim_adc_regs[3])
+
+#undef SPI3
+#define SPI3 (&sim_spi_regs[3])
+
+#undef RCC
+#undef EXTI
+#undef SYSCFG
+#define RCC (&sim_rcc_regs)
+#define EXTI (&sim_exti_regs)
+#define SYSCFG (&sim_syscfg_regs)
+
+// Board definitions (same as ODrive v3.x) ----------------------------------------
+
+#if HW_VERSION_MINOR <= 3
+#define SHUNT_RESISTANCE (675e-6f)
+#else
+#define SHUNT_RESISTANCE (500e-6f)
+#endif
+
+#define AXIS_COUNT (2)
+
+// Total count of GPIOs, including encoder pins, CAN pins and a dummy GPIO0.
+#define GPIO_COUNT  (17)
+
+#define CAN_FREQ (2000000UL)
+
+#if HW_VERSION_MINOR >= 5 && HW_VERSION_VOLTAGE >= 48
+#define DEFAULT_BRAKE_RESISTANCE (2.0f) // [ohm]
+#else
+#define DEFAULT_BRAKE_RESISTANCE (0.47f) // [ohm]
+#endif
+
+#define DEFAULT_ERROR_PIN 0
+#define DEFAULT_MIN_DC_VOLTAGE 8.0f
+
+#define DEFAULT_GPIO_MODES \
+    ODriveIntf::GPIO_MODE_DIGITAL, \
+    ODriveIntf::GPIO_MODE_UART_A, \
+    ODriveIntf::GPIO_MODE_UART_A, \
+    ODriveIntf::GPIO_MODE_ANALOG_IN, \
+    ODriveIntf::GPIO_MODE_ANALOG_IN, \
+    ODriveIntf::GPIO_MODE_ANALOG_IN, \
+    ODriveIntf::GPIO_MODE_DIGITAL, \
+    ODriveIntf::GPIO_MODE_DIGITAL, \
+    ODriveIntf::GPIO_MODE_DIGITAL, \
+    ODriveIntf::GPIO_MODE_ENC0, \
+    ODriveIntf::GPIO_MODE_ENC0, \
+    ODriveIntf::GPIO_MODE_DIGITAL_PULL_DOWN, \
+    ODriveIntf::GPIO_MODE_ENC1, \
+    ODriveIntf::GPIO_MODE_ENC1, \
+    ODriveIntf::GPIO_MODE_DIGITAL_PULL_DOWN, \
+    ODriveIntf::GPIO_MODE_CAN_A, \
+    ODriveIntf::GPIO_MODE_CAN_A,
+
+#define TIM_TIME_BASE TIM14
+
+// Run control loop at the same frequency as the current measurements.
+#define CONTROL_TIMER_PERIOD_TICKS  (2 * TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1))
+
+#define TIM1_INIT_COUNT (TIM_1_8_PERIOD_CLOCKS / 2 - 1 * 128)
+
+// The delta from the control loop timestamp to the current sense timestamp is
+// exactly 0 for M0 and TIM1_INIT_COUNT for M1.
+#define MAX_CONTROL_LOOP_UPDATE_TO_CURRENT_UPDATE_DELTA (TIM_1_8_PERIOD_CLOCKS / 2 + 1 * 128)
+
+#ifdef __cplusplus
+#include <Drivers/gate_driver.hpp>
+#include <Drivers/STM32/stm32_gpio.hpp>
+#include <Drivers/STM32/stm32_spi_arbiter.hpp>
+#include <MotorControl/thermistor.hpp>
+
+/**
+ * @brief Stand-in for the DRV8301 which is always ready and offers the same
+ * discrete current sense amplifier gains.
+ */
+class SimGateDriver : public GateDriverBase, public OpAmpBase {
+public:
+    bool config(float requested_gain, float* actual_gain);
+    bool init() { is_ready_ = is_configured_; return is_ready_; }
+    void do_checks() {}
+    bool is_ready() final { return is_ready_; }
+    bool set_enabled(bool enabled) final { return true; }
+    uint32_t get_error() { return 0; }
+    float get_midpoint() final { return 3.3f / 2.0f; }
+    float get_max_output_swing() final { return 1.35f; }
+
+    float gain_ = 0.0f; // [V/V]
+    bool is_configured_ = false;
+    bool is_ready_ = false;
+};
+
+using TGateDriver = SimGateDriver;
+using TOpAmp = SimGateDriver;
+
+#include <MotorControl/motor.hpp>
+#include <MotorControl/encoder.hpp>
+
+extern std::array<Axis, AXIS_COUNT> axes;
+extern Motor motors[AXIS_COUNT];
+extern OnboardThermistorCurrentLimiter fet_thermistors[AXIS_COUNT];
+extern Encoder encoders[AXIS_COUNT];
+extern Stm32Gpio gpios[GPIO_COUNT];
+
+struct GpioFunction { int mode = 0; uint8_t alternate_function = 0xff; };
+extern std::array<GpioFunction, 3> alternate_functions[GPIO_COUNT];
+
+extern Stm32SpiArbiter& ext_spi_arbiter;
+#endif
+
+// PWM frequency of TIM1 and TIM8 in [Hz]. The current is measured and the
+// control loop runs once every (TIM_1_8_RCR + 1) PWM periods.
+// The upper limit leaves the control loop enough time to finish within one
+// period. The lower limit keeps the period of TIM13 within 16 bits.
+#define DEFAULT_PWM_FREQUENCY 24000.0f
+#define MIN_PWM_FREQUENCY 8000.0f
+#define MAX_PWM_FREQUENCY 48000.0f
+
+// Control loop period in [s] and frequency in [Hz]. These are derived from
+// the configured PWM frequency at boot (see board_apply_config()).
+extern float current_meas_period;
+extern int current_meas_hz;
+
+#if HW_VERSION_VOLTAGE >= 48
+#define VBUS_S_DIVIDER_RATIO 19.0f
+#elif HW_VERSION_VOLTAGE == 24
+#define VBUS_S_DIVIDER_RATIO 11.0f
+#else
+#error "unknown board voltage"
+#endif
+
+#define CURRENT_SENSE_MIN_VOLT  0.3f
+#define CURRENT_SENSE_MAX_VOLT  3.0f
+
+// This board has no board-specific user configurations
+static inline bool board_read_config() { return true; }
+static inline bool board_write_config() { return true; }
+static inline void board_clear_config() { }
+bool board_apply_config();
+
+void system_init();
+bool board_init();
+void start_timers();
+
+#endif // __BOARD_CONFIG_H
@@ -0,0 +1,32 @@
+/*
+* @brief Redirects the CMSIS NVIC functions for the host simulator.
+*
+* Included by core_cm4.h when CMSIS_NVIC_VIRTUAL is defined. The simulator has
+* no interrupt controller, so the functions that the firmware calls from code
+* that is compiled into the simulator are implemented in sim_hal.cpp.
+*/
+
+#ifndef __CMSIS_NVIC_VIRTUAL_H
+#define __CMSIS_NVIC_VIRTUAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void sim_nvic_enable_irq(IRQn_Type IRQn);
+void sim_nvic_disable_irq(IRQn_Type IRQn);
+void sim_nvic_set_priority(IRQn_Type IRQn, uint32_t priority);
+uint32_t sim_nvic_get_priority(IRQn_Type IRQn);
+void sim_nvic_system_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define NVIC_EnableIRQ              sim_nvic_enable_irq
+#define NVIC_DisableIRQ             sim_nvic_disable_irq
+#define NVIC_SetPriority            sim_nvic_set_priority
+#define NVIC_GetPriority            sim_nvic_get_priority
+#define NVIC_SystemReset            sim_nvic_system_reset
+
+#endif // __CMSIS_NVIC_VIRTUAL_H
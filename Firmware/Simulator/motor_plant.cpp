@@ -0,0 +1,115 @@
+
+#include "motor_plant.hpp"
+
+#include <cmath>
+
+static constexpr double one_by_sqrt3 = 0.57735026918962576451;
+static constexpr double sqrt3_by_2 = 0.86602540378443864676;
+
+double MotorPlant::dead_time_error(double current) const {
+    return config_.dead_time_voltage * std::tanh(current / config_.dead_time_current);
+}
+
+MotorPlant::State MotorPlant::derivative(const State& x, double v_alpha, double v_beta, bool enabled) const {
+    const double p = config_.pole_pairs;
+    const double R = config_.phase_resistance;
+    const double Ld = config_.phase_inductance_d;
+    const double Lq = config_.phase_inductance_q;
+    const double psi = config_.torque_constant / (1.5 * p);
+
+    State dx;
+
+    double phase = p * x.pos + config_.encoder_offset;
+    double vel_e = p * x.vel;
+
+    if (enabled) {
+        double c = std::cos(phase);
+        double s = std::sin(phase);
+        if (config_.dead_time_voltage != 0.0f) {
+            double i_alpha = c * x.id - s * x.iq;
+            double i_beta = s * x.id + c * x.iq;
+            double eA = dead_time_error(i_alpha);
+            double eB = dead_time_error(-0.5 * i_alpha + sqrt3_by_2 * i_beta);
+            double eC = dead_time_error(-0.5 * i_alpha - sqrt3_by_2 * i_beta);
+            v_alpha -= (2.0 / 3.0) * (eA - 0.5 * eB - 0.5 * eC);
+            v_beta -= one_by_sqrt3 * (eB - eC);
+        }
+        double vd = c * v_alpha + s * v_beta;
+        double vq = c * v_beta - s * v_alpha;
+        dx.id = (vd - R * x.id + vel_e * Lq * x.iq) / Ld;
+        dx.iq = (vq - R * x.iq - vel_e * (Ld * x.id + psi)) / Lq;
+    } else {
+        // All phases are floating. This neglects conduction through the
+        // body diodes which only happens if the back EMF exceeds vbus.
+        dx.id = 0.0;
+        dx.iq = 0.0;
+    }
+
+    double torque = 1.5 * p * (psi * x.iq + (Ld - Lq) * x.id * x.iq);
+    double friction = config_.viscous_friction * x.vel
+                    + config_.coulomb_friction * std::tanh(x.vel / config_.coulomb_friction_vel);
+    double cogging = config_.cogging_torque * std::sin(config_.cogging_periods * x.pos);
+    dx.vel = (torque - friction - cogging - config_.load_torque) / config_.inertia;
+    dx.pos = x.vel;
+
+    return dx;
+}
+
+void MotorPlant::step(double dt, const float (&duty)[3], bool enabled, float vbus) {
+    if (!enabled) {
+        id_ = 0.0;
+        iq_ = 0.0;
+    }
+
+    // Phase voltages relative to the DC bus midpoint. The common mode
+    // component does not drive any current in a star connected motor.
+    double vA = (duty[0] - 0.5) * vbus;
+    double vB = (duty[1] - 0.5) * vbus;
+    double vC = (duty[2] - 0.5) * vbus;
+    double v_alpha = (2.0 / 3.0) * (vA - 0.5 * vB - 0.5 * vC);
+    double v_beta = one_by_sqrt3 * (vB - vC);
+
+    State x = {id_, iq_, vel_, pos_};
+    const double h = dt / config_.substeps;
+
+    auto add = [](const State& a, const State& b, double k) {
+        return State{a.id + k * b.id, a.iq + k * b.iq, a.vel + k * b.vel, a.pos + k * b.pos};
+    };
+
+    for (int32_t i = 0; i < config_.substeps; ++i) {
+        State k1 = derivative(x, v_alpha, v_beta, enabled);
+        State k2 = derivative(add(x, k1, h / 2), v_alpha, v_beta, enabled);
+        State k3 = derivative(add(x, k2, h / 2), v_alpha, v_beta, enabled);
+        State k4 = derivative(add(x, k3, h), v_alpha, v_beta, enabled);
+        x.id += h / 6 * (k1.id + 2 * k2.id + 2 * k3.id + k4.id);
+        x.iq += h / 6 * (k1.iq + 2 * k2.iq + 2 * k3.iq + k4.iq);
+        x.vel += h / 6 * (k1.vel + 2 * k2.vel + 2 * k3.vel + k4.vel);
+        x.pos += h / 6 * (k1.pos + 2 * k2.pos + 2 * k3.pos + k4.pos);
+    }
+
+    id_ = x.id;
+    iq_ = x.iq;
+    vel_ = x.vel;
+    pos_ = x.pos;
+}
+
+void MotorPlant::get_phase_currents(float (&currents)[3]) const {
+    double phase = config_.pole_pairs * pos_ + config_.encoder_offset;
+    double c = std::cos(phase);
+    double s = std::sin(phase);
+    double i_alpha = c * id_ - s * iq_;
+    double i_beta = s * id_ + c * iq_;
+    currents[0] = (float)i_alpha;
+    currents[1] = (float)(-0.5 * i_alpha + sqrt3_by_2 * i_beta);
+    currents[2] = (float)(-0.5 * i_alpha - sqrt3_by_2 * i_beta);
+}
+
+int64_t MotorPlant::get_encoder_count() const {
+    return (int64_t)std::floor(pos_ * config_.encoder_cpr / (2.0 * M_PI));
+}
+
+float MotorPlant::get_torque() const {
+    const double p = config_.pole_pairs;
+    const double psi = config_.torque_constant / (1.5 * p);
+    return (float)(1.5 * p * (psi * iq_ + (config_.phase_inductance_d - config_.phase_inductance_q) * id_ * iq_));
+}
@@ -0,0 +1,95 @@
+#ifndef __MOTOR_PLANT_HPP
+#define __MOTOR_PLANT_HPP
+
+#include <stdint.h>
+
+/**
+ * @brief Model of a three phase inverter driving a PMSM with a rigidly coupled
+ * load and an incremental encoder.
+ *
+ * The electrical model is written in the rotor (dq) frame:
+ *
+ *   v_d = R i_d + L_d di_d/dt - w_e L_q i_q
+ *   v_q = R i_q + L_q di_q/dt + w_e (L_d i_d + psi)
+ *
+ * with the magnitude invariant Clarke transform that the firmware uses, so that
+ * torque = torque_constant * i_q for a surface mounted motor (L_d = L_q).
+ *
+ * The inverter is modelled by its average phase voltages over a PWM period.
+ * Optionally each phase voltage is reduced by
+ * dead_time_voltage * tanh(i / dead_time_current), which approximates the
+ * dead time and FET drops.
+ * The mechanical model is
+ *
+ *   J dw/dt = torque - b w - T_c tanh(w / w_c) - T_cog sin(n_cog theta) - load_torque
+ *
+ * All states are integrated with a fixed step RK4 integrator in double
+ * precision. There is no randomness anywhere, so the plant is deterministic.
+ */
+class MotorPlant {
+public:
+    struct Config_t {
+        int32_t pole_pairs = 7;
+        float phase_resistance = 0.05f; // [Ohm]
+        float phase_inductance_d = 20e-6f; // [H]
+        float phase_inductance_q = 20e-6f; // [H]
+        float torque_constant = 0.04f; // [Nm/A]
+        float inertia = 1e-4f; // [kg m^2] motor plus load
+        float viscous_friction = 1e-5f; // [Nm/(rad/s)]
+        float coulomb_friction = 0.0f; // [Nm]
+        float coulomb_friction_vel = 0.1f; // [rad/s] velocity at which the coulomb friction is 76% developed
+        float load_torque = 0.0f; // [Nm]
+        float cogging_torque = 0.0f; // [Nm] amplitude of the sinusoidal cogging torque
+        int32_t cogging_periods = 84; // cogging periods per mechanical turn (LCM of slot and pole count)
+        float dead_time_voltage = 0.0f; // [V] inverter voltage error per phase at large currents
+        float dead_time_current = 0.3f; // [A] width of the transition of the voltage error around zero current
+        float encoder_offset = 0.0f; // [rad] electrical angle of the rotor when the encoder reads zero
+        int32_t encoder_cpr = 8192;
+        int32_t substeps = 4; // number of RK4 steps per integration interval
+    };
+
+    MotorPlant() = default;
+    explicit MotorPlant(const Config_t& config) : config_(config) {}
+
+    /**
+     * @brief Advances the plant by dt seconds while holding the given inverter
+     * state.
+     * @param duty: Fraction of time that each phase is connected to the
+     *        positive DC rail.
+     * @param enabled: false if all phases are floating (output stage off).
+     * @param vbus: DC bus voltage [V]
+     */
+    void step(double dt, const float (&duty)[3], bool enabled, float vbus);
+
+    /** @brief Returns the phase currents A, B, C [A] (positive into the motor) */
+    void get_phase_currents(float (&currents)[3]) const;
+
+    /** @brief Total encoder counts since the start of the simulation */
+    int64_t get_encoder_count() const;
+
+    float get_torque() const; // [Nm] electromagnetic torque
+    double get_pos() const { return pos_; } // [rad] mechanical
+    double get_vel() const { return vel_; } // [rad/s] mechanical
+    double get_id() const { return id_; } // [A]
+    double get_iq() const { return iq_; } // [A]
+
+    Config_t config_;
+
+private:
+    struct State {
+        double id;
+        double iq;
+        double vel;
+        double pos;
+    };
+
+    double dead_time_error(double current) const;
+    State derivative(const State& x, double v_alpha, double v_beta, bool enabled) const;
+
+    double id_ = 0.0;
+    double iq_ = 0.0;
+    double vel_ = 0.0;
+    double pos_ = 0.0;
+};
+
+#endif // __MOTOR_PLANT_HPP
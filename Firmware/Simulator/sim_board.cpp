@@ -0,0 +1,356 @@
+/*
+* @brief Contains board specific variables and the interrupt sequencing of the
+* host simulator.
+*
+* The object layout mirrors Board/v3/board.cpp so that the firmware sees the
+* same motors, encoders and GPIOs as on an ODrive v3.6. The interrupt handlers
+* at the bottom are condensed versions of the TIM8 update and control loop
+* handlers of the real board.
+*/
+
+#include <board.h>
+
+#include <odrive_main.h>
+#include <low_level.h>
+
+#include "sim_board.hpp"
+
+// this should technically be in task_timer.cpp but let's not make a one-line file
+bool TaskTimer::enabled = false;
+
+TIM_TypeDef sim_tim_regs[15];
+GPIO_TypeDef sim_gpio_regs[9];
+ADC_TypeDef sim_adc_regs[4];
+SPI_TypeDef sim_spi_regs[4];
+RCC_TypeDef sim_rcc_regs;
+EXTI_TypeDef sim_exti_regs;
+SYSCFG_TypeDef sim_syscfg_regs;
+
+TIM_HandleTypeDef htim1 = {TIM1};
+TIM_HandleTypeDef htim2 = {TIM2};
+TIM_HandleTypeDef htim3 = {TIM3};
+TIM_HandleTypeDef htim4 = {TIM4};
+TIM_HandleTypeDef htim5 = {TIM5};
+TIM_HandleTypeDef htim8 = {TIM8};
+TIM_HandleTypeDef htim13 = {TIM13};
+ADC_HandleTypeDef hadc1 = {ADC1};
+ADC_HandleTypeDef hadc2 = {ADC2};
+ADC_HandleTypeDef hadc3 = {ADC3};
+SPI_HandleTypeDef hspi3 = {SPI3};
+
+Stm32SpiArbiter spi3_arbiter{&hspi3};
+Stm32SpiArbiter& ext_spi_arbiter = spi3_arbiter;
+
+SimGateDriver m0_gate_driver;
+SimGateDriver m1_gate_driver;
+
+bool SimGateDriver::config(float requested_gain, float* actual_gain) {
+    // Same gain choices and selection logic as the DRV8301
+    size_t gain_setting = 3;
+    float gain_choices[] = {10.0f, 20.0f, 40.0f, 80.0f};
+    while (gain_setting && (gain_choices[gain_setting] > requested_gain)) {
+        gain_setting--;
+    }
+
+    if (actual_gain) {
+        *actual_gain = gain_choices[gain_setting];
+    }
+
+    if (gain_ != gain_choices[gain_setting]) {
+        gain_ = gain_choices[gain_setting];
+        is_ready_ = false;
+    }
+    is_configured_ = true;
+    return true;
+}
+
+const float fet_thermistor_poly_coeffs[] =
+    {363.93910201f, -462.15369634f, 307.55129571f, -27.72569531f};
+const size_t fet_thermistor_num_coeffs = sizeof(fet_thermistor_poly_coeffs)/sizeof(fet_thermistor_poly_coeffs[1]);
+
+OnboardThermistorCurrentLimiter fet_thermistors[AXIS_COUNT] = {
+    {
+        15, // adc_channel
+        &fet_thermistor_poly_coeffs[0], // coefficients
+        fet_thermistor_num_coeffs // num_coeffs
+    }, {
+        4, // adc_channel
+        &fet_thermistor_poly_coeffs[0], // coefficients
+        fet_thermistor_num_coeffs // num_coeffs
+    }
+};
+
+OffboardThermistorCurrentLimiter motor_thermistors[AXIS_COUNT];
+
+Motor motors[AXIS_COUNT] = {
+    {
+        &htim1, // timer
+        0b110, // current_sensor_mask
+        1.0f / SHUNT_RESISTANCE, // shunt_conductance [S]
+        m0_gate_driver, // gate_driver
+        m0_gate_driver, // opamp
+        fet_thermistors[0],
+        motor_thermistors[0]
+    },
+    {
+        &htim8, // timer
+        0b110, // current_sensor_mask
+        1.0f / SHUNT_RESISTANCE, // shunt_conductance [S]
+        m1_gate_driver, // gate_driver
+        m1_gate_driver, // opamp
+        fet_thermistors[1],
+        motor_thermistors[1]
+    }
+};
+
+Encoder encoders[AXIS_COUNT] = {
+    {
+        &htim3, // timer
+        {M0_ENC_Z_GPIO_Port, M0_ENC_Z_Pin}, // index_gpio
+        {M0_ENC_A_GPIO_Port, M0_ENC_A_Pin}, // hallA_gpio
+        {M0_ENC_B_GPIO_Port, M0_ENC_B_Pin}, // hallB_gpio
+        {M0_ENC_Z_GPIO_Port, M0_ENC_Z_Pin}, // hallC_gpio
+        &spi3_arbiter // spi_arbiter
+    },
+    {
+        &htim4, // timer
+        {M1_ENC_Z_GPIO_Port, M1_ENC_Z_Pin}, // index_gpio
+        {M1_ENC_A_GPIO_Port, M1_ENC_A_Pin}, // hallA_gpio
+        {M1_ENC_B_GPIO_Port, M1_ENC_B_Pin}, // hallB_gpio
+        {M1_ENC_Z_GPIO_Port, M1_ENC_Z_Pin}, // hallC_gpio
+        &spi3_arbiter // spi_arbiter
+    }
+};
+
+Endstop endstops[2 * AXIS_COUNT];
+MechanicalBrake mechanical_brakes[AXIS_COUNT];
+
+SensorlessEstimator sensorless_estimators[AXIS_COUNT];
+Controller controllers[AXIS_COUNT];
+TrapezoidalTrajectory trap[AXIS_COUNT];
+
+std::array<Axis, AXIS_COUNT> axes{{
+    {
+        0, // axis_num
+        1, // step_gpio_pin
+        2, // dir_gpio_pin
+        (osPriority)(osPriorityHigh + (osPriority)1), // thread_priority
+        encoders[0], // encoder
+        sensorless_estimators[0], // sensorless_estimator
+        controllers[0], // controller
+        motors[0], // motor
+        trap[0], // trap
+        endstops[0], endstops[1], // min_endstop, max_endstop
+        mechanical_brakes[0], // mechanical brake
+    },
+    {
+        1, // axis_num
+        7, // step_gpio_pin
+        8, // dir_gpio_pin
+        osPriorityHigh, // thread_priority
+        encoders[1], // encoder
+        sensorless_estimators[1], // sensorless_estimator
+        controllers[1], // controller
+        motors[1], // motor
+        trap[1], // trap
+        endstops[2], endstops[3], // min_endstop, max_endstop
+        mechanical_brakes[1], // mechanical brake
+    },
+}};
+
+Stm32Gpio gpios[GPIO_COUNT] = {
+    {nullptr, 0}, // dummy GPIO0 so that PCB labels and software numbers match
+
+    {GPIOA, GPIO_PIN_0}, // GPIO1
+    {GPIOA, GPIO_PIN_1}, // GPIO2
+    {GPIOA, GPIO_PIN_2}, // GPIO3
+    {GPIOA, GPIO_PIN_3}, // GPIO4
+    {GPIOC, GPIO_PIN_4}, // GPIO5
+    {GPIOB, GPIO_PIN_2}, // GPIO6
+    {GPIOA, GPIO_PIN_15}, // GPIO7
+    {GPIOB, GPIO_PIN_3}, // GPIO8
+
+    {GPIOB, GPIO_PIN_4}, // ENC0_A
+    {GPIOB, GPIO_PIN_5}, // ENC0_B
+    {GPIOC, GPIO_PIN_9}, // ENC0_Z
+    {GPIOB, GPIO_PIN_6}, // ENC1_A
+    {GPIOB, GPIO_PIN_7}, // ENC1_B
+    {GPIOC, GPIO_PIN_15}, // ENC1_Z
+    {GPIOB, GPIO_PIN_8}, // CAN_R
+    {GPIOB, GPIO_PIN_9}, // CAN_D
+};
+
+std::array<GpioFunction, 3> alternate_functions[GPIO_COUNT] = {{}};
+
+// Timing for DEFAULT_PWM_FREQUENCY until board_apply_config() runs
+static constexpr uint16_t default_period_clocks = (uint16_t)((float)TIM_1_8_CLOCK_HZ / (2.0f * DEFAULT_PWM_FREQUENCY));
+uint16_t tim_1_8_period_clocks = default_period_clocks;
+float current_meas_period = (float)(2 * default_period_clocks * (TIM_1_8_RCR + 1)) / (float)TIM_1_8_CLOCK_HZ;
+int current_meas_hz = TIM_1_8_CLOCK_HZ / (2 * default_period_clocks * (TIM_1_8_RCR + 1));
+
+// Same as on ODrive v3 (see Board/v3/board.cpp)
+bool board_apply_config() {
+    float pwm_frequency = odrv.config_.pwm_frequency;
+    if (!(pwm_frequency >= MIN_PWM_FREQUENCY) || !(pwm_frequency <= MAX_PWM_FREQUENCY)) {
+        pwm_frequency = DEFAULT_PWM_FREQUENCY;
+        odrv.misconfigured_ = true;
+    }
+
+    tim_1_8_period_clocks = (uint16_t)std::round((float)TIM_1_8_CLOCK_HZ / (2.0f * pwm_frequency));
+    current_meas_period = (float)CONTROL_TIMER_PERIOD_TICKS / (float)TIM_1_8_CLOCK_HZ;
+    current_meas_hz = TIM_1_8_CLOCK_HZ / CONTROL_TIMER_PERIOD_TICKS;
+    return true;
+}
+
+void system_init() {
+}
+
+bool board_init() {
+    return true;
+}
+
+void start_timers() {
+}
+
+// Converts a phase current to the value that the current sense ADC would read.
+static uint32_t adcval_from_phase_current(Motor& motor, SimGateDriver& gate_driver, float current) {
+    float shunt_volt = current / motor.shunt_conductance_;
+    float amp_out_volt = shunt_volt * gate_driver.gain_;
+    int adcval_bal = (int)std::round(amp_out_volt * (float)(1 << 12) / 3.3f);
+    return (uint32_t)std::clamp(adcval_bal + (1 << 11), 0, (1 << 12) - 1);
+}
+
+// ADC readings of the V7 sample, see sim_board_sample_adcs()
+static uint32_t v7_adcval_[AXIS_COUNT][2];
+
+void sim_board_sample_adcs(const Iph_ABC_t (&currents)[AXIS_COUNT], const uint32_t (&ccr)[AXIS_COUNT][3], float vbus) {
+    constexpr float vbus_scale = (float)(1 << 12) / (3.3f * VBUS_S_DIVIDER_RATIO);
+    ADC1->JDR1 = (uint32_t)std::clamp((int)std::round(vbus * vbus_scale), 0, (1 << 12) - 1);
+
+    float shunt_v0[AXIS_COUNT][2];
+    float shunt_v7[AXIS_COUNT][2];
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        float I[2] = {currents[i].phB, currents[i].phC};
+        for (size_t j = 0; j < 2; ++j) {
+            shunt_v0[i][j] = (ccr[i][j + 1] == 0) ? 0.0f : I[j];
+            shunt_v7[i][j] = (ccr[i][j + 1] >= TIM_1_8_PERIOD_CLOCKS) ? I[j] : 0.0f;
+        }
+    }
+
+    ADC2->JDR1 = adcval_from_phase_current(motors[0], m0_gate_driver, shunt_v0[0][0]);
+    ADC3->JDR1 = adcval_from_phase_current(motors[0], m0_gate_driver, shunt_v0[0][1]);
+    ADC2->DR = adcval_from_phase_current(motors[1], m1_gate_driver, shunt_v0[1][0]);
+    ADC3->DR = adcval_from_phase_current(motors[1], m1_gate_driver, shunt_v0[1][1]);
+    v7_adcval_[0][0] = adcval_from_phase_current(motors[0], m0_gate_driver, shunt_v7[0][0]);
+    v7_adcval_[0][1] = adcval_from_phase_current(motors[0], m0_gate_driver, shunt_v7[0][1]);
+    v7_adcval_[1][0] = adcval_from_phase_current(motors[1], m1_gate_driver, shunt_v7[1][0]);
+    v7_adcval_[1][1] = adcval_from_phase_current(motors[1], m1_gate_driver, shunt_v7[1][1]);
+}
+
+static void fetch_adcs(
+        std::optional<Iph_ABC_t>* current0,
+        std::optional<Iph_ABC_t>* current1) {
+    vbus_sense_adc_cb(ADC1->JDR1);
+
+    if (m0_gate_driver.is_ready()) {
+        std::optional<float> phB = motors[0].phase_current_from_adcval(ADC2->JDR1);
+        std::optional<float> phC = motors[0].phase_current_from_adcval(ADC3->JDR1);
+        if (phB.has_value() && phC.has_value()) {
+            *current0 = {-*phB - *phC, *phB, *phC};
+        }
+    }
+
+    if (m1_gate_driver.is_ready()) {
+        std::optional<float> phB = motors[1].phase_current_from_adcval(ADC2->DR);
+        std::optional<float> phC = motors[1].phase_current_from_adcval(ADC3->DR);
+        if (phB.has_value() && phC.has_value()) {
+            *current1 = {-*phB - *phC, *phB, *phC};
+        }
+    }
+}
+
+static uint32_t timestamp_ = 0;
+
+void sim_board_control_loop_irq() {
+    // TIM8 update event while counting up
+    timestamp_ += TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1);
+    TaskTimer::enabled = odrv.task_timers_armed_;
+    odrv.sampling_cb();
+
+    // Control loop interrupt
+    uint32_t timestamp = timestamp_;
+
+    std::optional<Iph_ABC_t> current0;
+    std::optional<Iph_ABC_t> current1;
+    fetch_adcs(&current0, &current1);
+
+    if (!(TIM1->BDTR & TIM_BDTR_MOE_Msk)) {
+        current0 = {0.0f, 0.0f};
+    }
+    if (!(TIM8->BDTR & TIM_BDTR_MOE_Msk)) {
+        current1 = {0.0f, 0.0f};
+    }
+
+    motors[0].current_meas_cb(timestamp - TIM1_INIT_COUNT, current0);
+    motors[1].current_meas_cb(timestamp, current1);
+
+    odrv.control_loop_cb(timestamp);
+
+    // TIM8 update event while counting down. On the real board this happens
+    // while the control loop is running.
+    timestamp_ += TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1);
+
+    // Tentatively reset all PWM outputs to 50% duty cycles. These values are
+    // overridden by pwm_update_cb() below unless the motor is disarmed.
+    TIM1->CCR1 =
+    TIM1->CCR2 =
+    TIM1->CCR3 =
+    TIM8->CCR1 =
+    TIM8->CCR2 =
+    TIM8->CCR3 =
+        TIM_1_8_PERIOD_CLOCKS / 2;
+
+    // The second ADC sample of the period is taken in V7. The shunts carry no
+    // current unless a phase is held low for the whole period.
+    ADC2->JDR1 = v7_adcval_[0][0];
+    ADC3->JDR1 = v7_adcval_[0][1];
+    ADC2->DR = v7_adcval_[1][0];
+    ADC3->DR = v7_adcval_[1][1];
+    current0.reset();
+    current1.reset();
+    fetch_adcs(&current0, &current1);
+
+    motors[0].dc_calib_cb(timestamp + TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1) - TIM1_INIT_COUNT, current0);
+    motors[1].dc_calib_cb(timestamp + TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1), current1);
+
+    motors[0].pwm_update_cb(timestamp + 3 * TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1) - TIM1_INIT_COUNT);
+    motors[1].pwm_update_cb(timestamp + 3 * TIM_1_8_PERIOD_CLOCKS * (TIM_1_8_RCR + 1));
+
+    odrv.task_timers_armed_ = odrv.task_timers_armed_ && !TaskTimer::enabled;
+    TaskTimer::enabled = false;
+}
+
+void sim_board_timer_update(TIM_TypeDef* tim) {
+    // Automatic output enable: MOE is set at the next update event.
+    if (tim->BDTR & TIM_BDTR_AOE) {
+        tim->BDTR |= TIM_BDTR_MOE;
+    }
+}
+
+void sim_board_set_fet_temperature(float temperature) {
+    // The thermistor polynomial is monotonic on [0, 1] so the normalized
+    // voltage can be found by bisection.
+    float lo = 0.0f;
+    float hi = 1.0f;
+    for (size_t i = 0; i < 24; ++i) {
+        float mid = 0.5f * (lo + hi);
+        if (horner_poly_eval(mid, fet_thermistor_poly_coeffs, fet_thermistor_num_coeffs) < temperature) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    uint16_t adcval = (uint16_t)std::round(0.5f * (lo + hi) * adc_full_scale);
+    adc_measurements_[15] = adcval; // M0 FET thermistor (see fet_thermistors)
+    adc_measurements_[4] = adcval; // M1 FET thermistor
+}
@@ -0,0 +1,35 @@
+#ifndef __SIM_BOARD_HPP
+#define __SIM_BOARD_HPP
+
+#include <board.h>
+
+/**
+ * @brief Loads the current sense and DC bus ADC registers with the values
+ * that correspond to the given phase currents [A] and bus voltage [V].
+ *
+ * The shunts are on the low side. A phase whose compare value (ccr) keeps the
+ * high side on for the whole period reads zero in the V0 sample, and a phase
+ * that is held low reads its current in the V7 sample.
+ */
+void sim_board_sample_adcs(const Iph_ABC_t (&currents)[AXIS_COUNT], const uint32_t (&ccr)[AXIS_COUNT][3], float vbus);
+
+/**
+ * @brief Runs one control period worth of interrupt handlers, in the same
+ * order as the TIM8 update and control loop interrupts on ODrive v3.
+ *
+ * The ADCs must be loaded with sim_board_sample_adcs() beforehand.
+ */
+void sim_board_control_loop_irq();
+
+/**
+ * @brief Emulates the register side effects of a timer update event.
+ */
+void sim_board_timer_update(TIM_TypeDef* tim);
+
+/**
+ * @brief Sets the general purpose ADC readings of the FET thermistors such that
+ * the firmware measures the specified temperature [°C].
+ */
+void sim_board_set_fet_temperature(float temperature);
+
+#endif // __SIM_BOARD_HPP
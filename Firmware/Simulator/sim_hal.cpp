@@ -0,0 +1,184 @@
+/*
+* @brief Host implementations of the HAL, CMSIS and system functions that the
+* MotorControl sources depend on.
+*
+* Most peripherals are only touched through their register blocks (see
+* board.h), so the HAL functions below merely need to exist. Functions that
+* would reset or reprogram the chip are no-ops in the simulator.
+*/
+
+#include <cmath>
+
+#include <odrive_main.h>
+#include <fibre-cpp/protocol.hpp>
+
+#include "sim_os.hpp"
+
+ODrive odrv{};
+
+uint64_t serial_number = 0x53494d303030; // "SIM000"
+char serial_number_str[13] = "53494D303030";
+uint32_t _reboot_cookie = 0;
+
+// Normally generated in autogen/version.c
+const unsigned char fw_version_major_ = 0;
+const unsigned char fw_version_minor_ = 0;
+const unsigned char fw_version_revision_ = 0;
+const unsigned char fw_version_unreleased_ = 1;
+
+USBStats_t usb_stats_;
+I2CStats_t i2c_stats_;
+
+// Lookup table of arm_sin_f32() and arm_cos_f32() (see arm_common_tables.h).
+// The firmware links the precomputed table from the CMSIS DSP library which is
+// not built for the host.
+#define FAST_MATH_TABLE_SIZE 512
+extern "C" float sinTable_f32[FAST_MATH_TABLE_SIZE + 1];
+float sinTable_f32[FAST_MATH_TABLE_SIZE + 1];
+
+static const bool sin_table_initialized = [] {
+    for (size_t i = 0; i <= FAST_MATH_TABLE_SIZE; ++i) {
+        sinTable_f32[i] = (float)std::sin(2.0 * M_PI * (double)i / (double)FAST_MATH_TABLE_SIZE);
+    }
+    return true;
+}();
+
+// ODrive system functions ---------------------------------------------------------
+
+bool ODrive::save_configuration(void) {
+    // There is no NVM in the simulator. The configuration lives as long as
+    // the simulator process.
+    return true;
+}
+
+void ODrive::erase_configuration(void) {
+}
+
+void ODrive::enter_dfu_mode() {
+}
+
+uint64_t ODrive::get_drv_fault() {
+    return 0;
+}
+
+uint32_t ODrive::get_interrupt_status(int32_t irqn) {
+    return 0;
+}
+
+uint32_t ODrive::get_dma_status(uint8_t stream_num) {
+    return 0;
+}
+
+uint32_t ODrive::get_gpio_states() {
+    return 0;
+}
+
+void uart_poll() {
+}
+
+// There is no CAN bus in the simulator.
+bool ODriveCAN::apply_config() {
+    return true;
+}
+
+bool ODriveCAN::send_message(const can_Message_t& message) {
+    return false;
+}
+
+bool ODriveCAN::subscribe(const MsgIdFilterSpecs& filter, on_can_message_cb_t callback, void* ctx, CanSubscription** handle) {
+    return false;
+}
+
+bool ODriveCAN::unsubscribe(CanSubscription* handle) {
+    return false;
+}
+
+bool fibre::is_endpoint_ref_valid(endpoint_ref_t endpoint_ref) {
+    return false;
+}
+
+bool fibre::set_endpoint_from_float(endpoint_ref_t endpoint_ref, float value) {
+    return false;
+}
+
+// NVIC ------------------------------------------------------------------------------
+
+static uint32_t nvic_priorities[128];
+
+void sim_nvic_enable_irq(IRQn_Type IRQn) {
+}
+
+void sim_nvic_disable_irq(IRQn_Type IRQn) {
+}
+
+void sim_nvic_set_priority(IRQn_Type IRQn, uint32_t priority) {
+    if (IRQn >= 0) {
+        nvic_priorities[IRQn] = priority;
+    }
+}
+
+uint32_t sim_nvic_get_priority(IRQn_Type IRQn) {
+    return IRQn >= 0 ? nvic_priorities[IRQn] : 0;
+}
+
+void sim_nvic_system_reset(void) {
+}
+
+// HAL -------------------------------------------------------------------------------
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t)(sim_os_get_time_us() / 1000ULL);
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    if (PinState != GPIO_PIN_RESET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin) {
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef* htim, uint32_t Channel) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef* htim, uint32_t Channel) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef* hadc) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef* hadc, ADC_ChannelConfTypeDef* sConfig) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef* hadc, uint32_t* pData, uint32_t Length) {
+    return HAL_OK;
+}
+
+// SPI transfers never complete because no SPI device is attached.
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef* hspi) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef* hspi) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size) {
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size) {
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size) {
+    return HAL_ERROR;
+}
@@ -0,0 +1,546 @@
+/*
+* @brief Command line front end of the host simulator.
+*
+* Usage:
+*   odrive_sim [--scenario NAME] [--duration SECONDS] [--setpoint VALUE]
+*              [--load-torque NM] [--pwm-frequency HZ]
+*              [--current-control-law pi|deadbeat] [--vbus-voltage V]
+*              [--phase-inductance H] [--phase-inductance-q H]
+*              [--field-weakening-current A] [--mtpa 0|1]
+*              [--modulation-mode continuous|dpwm0|dpwm1|dpwm2|dpwm_min|dpwm_max]
+*              [--dead-time-voltage V] [--dead-time-compensation 0|1]
+*              [--encoder-cpr N] [--encoder-estimator pll|kalman|edge_timing]
+*              [--kalman-process-noise NOISE] [--decimation N] [--csv FILE]
+*              [--reference FILE] [--max-rise-time SECONDS]
+*              [--max-overshoot PERCENT] [--max-final-error VALUE]
+*
+* Scenarios (all run on axis0):
+*   calibration    Runs the full calibration sequence and prints the results.
+*   velocity_step  Calibrates, enters closed loop velocity control and steps
+*                  input_vel to SETPOINT [turn/s] (default 10).
+*   position_step  Calibrates, enters closed loop position control and steps
+*                  input_pos to SETPOINT [turn] (default 1).
+*   torque_step    Calibrates, enters closed loop torque control and steps
+*                  input_torque to SETPOINT [Nm] (default 0.2). Use a short
+*                  duration to look at the current controller.
+*   mode_sweep     Calibrates, enters closed loop control and walks through
+*                  the control modes, input modes and circular setpoints, one
+*                  segment of DURATION per combination. Every specialization
+*                  of Controller::update() runs at least once.
+*
+* --pwm-frequency sets odrv.config_.pwm_frequency before boot, which also
+* changes the control loop rate. --current-control-law selects
+* motor.config_.current_control_law. --vbus-voltage and --phase-inductance
+* change the simulated supply and motor. --phase-inductance-q overrides the
+* q-axis inductance of the simulated motor to make it salient.
+* --field-weakening-current enables field weakening with the given maximum Id.
+* --mtpa sets motor.config_.mtpa_enable and --modulation-mode
+* motor.config_.modulation_mode. --dead-time-voltage adds an inverter voltage
+* error to the simulated motor and --dead-time-compensation sets
+* motor.config_.dead_time_compensation_enable. --encoder-cpr changes the
+* resolution of the simulated encoder, --encoder-estimator selects
+* encoder.config_.estimator and --kalman-process-noise sets
+* encoder.config_.kalman_process_noise. The velocity limit is raised for
+* velocity steps above 16 turn/s.
+*
+* For the step and sweep scenarios one CSV line is logged every N control
+* periods (default 1) after the step was applied. The simulation is
+* deterministic, so repeated runs produce identical output. With --reference
+* the CSV file is compared to an earlier run and the exit status is non-zero
+* if any value differs by more than a small tolerance.
+*
+* The step scenarios print the rise time (10% to 90%), the overshoot and the
+* mean absolute error over the last 10% of the duration of the plant velocity,
+* position or torque. The exit status is non-zero if one of them exceeds the
+* bound given by --max-rise-time, --max-overshoot or --max-final-error.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <odrive_main.h>
+
+#include "simulator.hpp"
+
+struct Options {
+    std::string scenario = "velocity_step";
+    float duration = 1.0f; // [s] duration after the step
+    float setpoint = NAN;
+    float load_torque = 0.0f; // [Nm]
+    float pwm_frequency = DEFAULT_PWM_FREQUENCY; // [Hz]
+    Motor::CurrentControlLaw current_control_law = Motor::CURRENT_CONTROL_LAW_PI;
+    float vbus_voltage = NAN; // [V]
+    float phase_inductance = NAN; // [H]
+    float phase_inductance_q = NAN; // [H]
+    float field_weakening_current = 0.0f; // [A]
+    bool mtpa = false;
+    Motor::ModulationMode modulation_mode = Motor::MODULATION_MODE_CONTINUOUS;
+    float dead_time_voltage = 0.0f; // [V]
+    bool dead_time_compensation = false;
+    int32_t encoder_cpr = 0; // 0: default of the plant
+    Encoder::Estimator encoder_estimator = Encoder::ESTIMATOR_PLL;
+    float kalman_process_noise = NAN; // [count/s^3/sqrt(Hz)]
+    uint32_t decimation = 1;
+    const char* csv_file = nullptr;
+    const char* reference_file = nullptr;
+    float max_rise_time = INFINITY; // [s]
+    float max_overshoot = INFINITY; // [%]
+    float max_final_error = INFINITY;
+};
+
+static void print_usage(const char* name) {
+    fprintf(stderr, "usage: %s [--scenario calibration|velocity_step|position_step|torque_step|mode_sweep] "
+                    "[--duration SECONDS] [--setpoint VALUE] [--load-torque NM] "
+                    "[--pwm-frequency HZ] [--current-control-law pi|deadbeat] "
+                    "[--vbus-voltage V] [--phase-inductance H] [--phase-inductance-q H] "
+                    "[--field-weakening-current A] [--mtpa 0|1] "
+                    "[--modulation-mode continuous|dpwm0|dpwm1|dpwm2|dpwm_min|dpwm_max] "
+                    "[--dead-time-voltage V] [--dead-time-compensation 0|1] "
+                    "[--encoder-cpr N] [--encoder-estimator pll|kalman|edge_timing] "
+                    "[--kalman-process-noise NOISE] [--decimation N] [--csv FILE] "
+                    "[--reference FILE] [--max-rise-time SECONDS] [--max-overshoot PERCENT] "
+                    "[--max-final-error VALUE]\n", name);
+}
+
+static bool parse_args(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!val) {
+            return false;
+        } else if (!strcmp(arg, "--scenario")) {
+            options->scenario = val;
+        } else if (!strcmp(arg, "--duration")) {
+            options->duration = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--setpoint")) {
+            options->setpoint = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--load-torque")) {
+            options->load_torque = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--pwm-frequency")) {
+            options->pwm_frequency = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--current-control-law")) {
+            if (!strcmp(val, "pi")) {
+                options->current_control_law = Motor::CURRENT_CONTROL_LAW_PI;
+            } else if (!strcmp(val, "deadbeat")) {
+                options->current_control_law = Motor::CURRENT_CONTROL_LAW_DEADBEAT;
+            } else {
+                return false;
+            }
+        } else if (!strcmp(arg, "--vbus-voltage")) {
+            options->vbus_voltage = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--phase-inductance")) {
+            options->phase_inductance = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--phase-inductance-q")) {
+            options->phase_inductance_q = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--field-weakening-current")) {
+            options->field_weakening_current = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--mtpa")) {
+            options->mtpa = strtol(val, nullptr, 10) != 0;
+        } else if (!strcmp(arg, "--modulation-mode")) {
+            const char* names[] = {"continuous", "dpwm0", "dpwm1", "dpwm2", "dpwm_min", "dpwm_max"};
+            auto it = std::find_if(std::begin(names), std::end(names), [&](const char* name) { return !strcmp(val, name); });
+            if (it == std::end(names)) {
+                return false;
+            }
+            options->modulation_mode = (Motor::ModulationMode)(it - std::begin(names));
+        } else if (!strcmp(arg, "--dead-time-voltage")) {
+            options->dead_time_voltage = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--dead-time-compensation")) {
+            options->dead_time_compensation = strtol(val, nullptr, 10) != 0;
+        } else if (!strcmp(arg, "--encoder-cpr")) {
+            options->encoder_cpr = strtol(val, nullptr, 10);
+        } else if (!strcmp(arg, "--encoder-estimator")) {
+            if (!strcmp(val, "pll")) {
+                options->encoder_estimator = Encoder::ESTIMATOR_PLL;
+            } else if (!strcmp(val, "kalman")) {
+                options->encoder_estimator = Encoder::ESTIMATOR_KALMAN;
+            } else if (!strcmp(val, "edge_timing")) {
+                options->encoder_estimator = Encoder::ESTIMATOR_EDGE_TIMING;
+            } else {
+                return false;
+            }
+        } else if (!strcmp(arg, "--kalman-process-noise")) {
+            options->kalman_process_noise = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--decimation")) {
+            options->decimation = std::max(1L, strtol(val, nullptr, 10));
+        } else if (!strcmp(arg, "--csv")) {
+            options->csv_file = val;
+        } else if (!strcmp(arg, "--reference")) {
+            options->reference_file = val;
+        } else if (!strcmp(arg, "--max-rise-time")) {
+            options->max_rise_time = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--max-overshoot")) {
+            options->max_overshoot = strtof(val, nullptr);
+        } else if (!strcmp(arg, "--max-final-error")) {
+            options->max_final_error = strtof(val, nullptr);
+        } else {
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
+// Requests the specified state and runs the simulation until the axis returns
+// to idle.
+static bool run_state(Simulator& sim, Axis& axis, Axis::AxisState state, float timeout) {
+    axis.requested_state_ = state;
+    sim.run_until([&] { return axis.requested_state_ == Axis::AXIS_STATE_UNDEFINED; }, 0.1f);
+    sim.run_until([&] { return axis.current_state_ == Axis::AXIS_STATE_IDLE; }, timeout);
+    return axis.error_ == Axis::ERROR_NONE;
+}
+
+static void print_errors(Axis& axis) {
+    fprintf(stderr, "system error: 0x%08x, axis error: 0x%08x, motor error: 0x%016llx, encoder error: 0x%08x, controller error: 0x%08x\n",
+            (unsigned)odrv.error_, (unsigned)axis.error_, (unsigned long long)axis.motor_.error_,
+            (unsigned)axis.encoder_.error_, (unsigned)axis.controller_.error_);
+}
+
+// Compares two CSV files value by value. Prints the first mismatch and returns
+// false if the files differ in shape or if a value differs by more than the
+// tolerance (absolute plus relative to the reference value).
+static bool compare_csv(const char* file, const char* reference, double tolerance = 1e-4) {
+    FILE* f[2] = {fopen(file, "r"), fopen(reference, "r")};
+    bool ok = f[0] && f[1];
+    if (!ok) {
+        perror("fopen");
+    }
+    char line[2][1024];
+    for (size_t n = 1; ok; ++n) {
+        bool more[2] = {fgets(line[0], sizeof(line[0]), f[0]) != nullptr, fgets(line[1], sizeof(line[1]), f[1]) != nullptr};
+        if (!more[0] && !more[1]) {
+            break;
+        }
+        line[0][strcspn(line[0], "\r\n")] = '\0';
+        line[1][strcspn(line[1], "\r\n")] = '\0';
+        if (!more[0] || !more[1] || (n == 1 && strcmp(line[0], line[1]))) {
+            fprintf(stderr, "%s:%zu does not match %s\n", file, n, reference);
+            ok = false;
+            break;
+        }
+        char* p[2] = {line[0], line[1]};
+        for (size_t col = 1; n > 1 && *p[0] && *p[1]; ++col) {
+            char* end[2];
+            double val = strtod(p[0], &end[0]);
+            double ref = strtod(p[1], &end[1]);
+            if (end[0] == p[0] || end[1] == p[1] || std::abs(val - ref) > tolerance * (1.0 + std::abs(ref))) {
+                fprintf(stderr, "%s:%zu column %zu is %.9g, reference %.9g\n", file, n, col, val, ref);
+                ok = false;
+                break;
+            }
+            p[0] = end[0] + (*end[0] == ',');
+            p[1] = end[1] + (*end[1] == ',');
+        }
+    }
+    for (FILE* fp : f) {
+        if (fp) {
+            fclose(fp);
+        }
+    }
+    return ok;
+}
+
+struct StepMetrics {
+    float rise_time = INFINITY; // [s] from 10% to 90% of the step
+    float overshoot = 0.0f; // [%] of the step
+    float final_error = 0.0f; // mean absolute error over the last 10% of the response
+};
+
+// Computes the metrics of a step from response[0] to target sampled with the
+// period dt [s].
+static StepMetrics compute_step_metrics(const std::vector<float>& response, float target, float dt) {
+    StepMetrics metrics;
+    if (response.empty()) {
+        return metrics;
+    }
+    float step = target - response[0];
+    float sign = (step < 0.0f) ? -1.0f : 1.0f;
+    size_t t10 = response.size();
+    for (size_t i = 0; i < response.size(); ++i) {
+        float progress = (response[i] - response[0]) / step;
+        if (t10 == response.size() && progress >= 0.1f) {
+            t10 = i;
+        }
+        if (progress >= 0.9f) {
+            metrics.rise_time = (float)(i - t10) * dt;
+            break;
+        }
+    }
+    for (float y : response) {
+        metrics.overshoot = std::max(metrics.overshoot, 100.0f * sign * (y - target) / std::abs(step));
+    }
+    size_t n_tail = std::max<size_t>(1, response.size() / 10);
+    for (size_t i = response.size() - n_tail; i < response.size(); ++i) {
+        metrics.final_error += std::abs(response[i] - target) / (float)n_tail;
+    }
+    return metrics;
+}
+
+// One segment of the mode_sweep scenario. input is the position relative to
+// the start of the segment [turn] (absolute with circular setpoints), the
+// velocity [turn/s] or the torque [Nm], depending on the control mode.
+struct ModeSweepSegment {
+    Controller::ControlMode control_mode;
+    Controller::InputMode input_mode;
+    bool circular_setpoints;
+    float input;
+};
+
+static const ModeSweepSegment mode_sweep_segments[] = {
+    {Controller::CONTROL_MODE_VELOCITY_CONTROL, Controller::INPUT_MODE_PASSTHROUGH, false, 2.0f},
+    {Controller::CONTROL_MODE_VELOCITY_CONTROL, Controller::INPUT_MODE_VEL_RAMP, false, -2.0f},
+    {Controller::CONTROL_MODE_VELOCITY_CONTROL, Controller::INPUT_MODE_INACTIVE, false, 0.0f},
+    {Controller::CONTROL_MODE_TORQUE_CONTROL, Controller::INPUT_MODE_PASSTHROUGH, false, 0.002f},
+    {Controller::CONTROL_MODE_TORQUE_CONTROL, Controller::INPUT_MODE_TORQUE_RAMP, false, -0.002f},
+    {Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_PASSTHROUGH, false, 0.5f},
+    {Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_POS_FILTER, false, -0.5f},
+    {Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_TRAP_TRAJ, false, 1.0f},
+    {Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_SCURVE_TRAJ, false, -1.0f},
+    // The trajectory switches to position control when it is done
+    {Controller::CONTROL_MODE_VELOCITY_CONTROL, Controller::INPUT_MODE_TRAP_TRAJ, false, 0.5f},
+    {Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_TUNING, false, 0.0f},
+    {Controller::CONTROL_MODE_VELOCITY_CONTROL, Controller::INPUT_MODE_PASSTHROUGH, true, 1.0f},
+    {Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_PASSTHROUGH, true, 0.25f},
+    {Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_POS_FILTER, true, 0.75f},
+    {Controller::CONTROL_MODE_POSITION_CONTROL, Controller::INPUT_MODE_TRAP_TRAJ, true, 0.5f},
+};
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_args(argc, argv, &options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (options.reference_file && !options.csv_file) {
+        fprintf(stderr, "--reference requires --csv\n");
+        return 1;
+    }
+
+    FILE* csv = stdout;
+    if (options.csv_file) {
+        csv = fopen(options.csv_file, "w");
+        if (!csv) {
+            perror("fopen");
+            return 1;
+        }
+    }
+
+    Simulator::Config_t config;
+    config.motors[0].load_torque = options.load_torque;
+    config.motors[0].dead_time_voltage = options.dead_time_voltage;
+    if (!is_nan(options.vbus_voltage)) {
+        config.vbus_voltage = options.vbus_voltage;
+    }
+    if (!is_nan(options.phase_inductance)) {
+        config.motors[0].phase_inductance_d = options.phase_inductance;
+        config.motors[0].phase_inductance_q = options.phase_inductance;
+    }
+    if (!is_nan(options.phase_inductance_q)) {
+        config.motors[0].phase_inductance_q = options.phase_inductance_q;
+    }
+    if (options.encoder_cpr > 0) {
+        config.motors[0].encoder_cpr = options.encoder_cpr;
+    }
+    Simulator sim{config};
+    Axis& axis = axes[0];
+
+    // Motor parameters that the firmware cannot measure
+    axis.motor_.config_.pole_pairs = sim.plants_[0].config_.pole_pairs;
+    axis.motor_.config_.torque_constant = sim.plants_[0].config_.torque_constant;
+    axis.encoder_.config_.cpr = sim.plants_[0].config_.encoder_cpr;
+    axis.motor_.config_.current_control_law = options.current_control_law;
+    if (options.field_weakening_current > 0.0f) {
+        axis.motor_.config_.field_weakening_enable = true;
+        axis.motor_.config_.field_weakening_max_current = options.field_weakening_current;
+    }
+    axis.motor_.config_.mtpa_enable = options.mtpa;
+    axis.motor_.config_.modulation_mode = options.modulation_mode;
+    axis.motor_.config_.dead_time_compensation_enable = options.dead_time_compensation;
+    axis.encoder_.config_.estimator = options.encoder_estimator;
+    if (!is_nan(options.kalman_process_noise)) {
+        axis.encoder_.config_.kalman_process_noise = options.kalman_process_noise;
+    }
+
+    // The simulated DC supply is ideal and can sink any regenerative current.
+    odrv.config_.dc_max_negative_current = -INFINITY;
+    odrv.config_.pwm_frequency = options.pwm_frequency;
+    axis.controller_.config_.vel_limit = 20.0f;
+
+    auto wall_start = std::chrono::steady_clock::now();
+
+    if (!sim.boot()) {
+        fprintf(stderr, "motors did not become ready\n");
+        return 1;
+    }
+
+    if (!run_state(sim, axis, Axis::AXIS_STATE_FULL_CALIBRATION_SEQUENCE, 30.0f)) {
+        fprintf(stderr, "calibration failed\n");
+        print_errors(axis);
+        return 1;
+    }
+
+    if (options.scenario == "calibration") {
+        fprintf(csv, "phase_resistance,phase_inductance,phase_inductance_d,phase_inductance_q,dead_time_voltage,dead_time_current,encoder_direction,encoder_phase_offset,encoder_phase_offset_float\n");
+        fprintf(csv, "%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d,%d,%.9g\n",
+                axis.motor_.config_.phase_resistance, axis.motor_.config_.phase_inductance,
+                axis.motor_.config_.phase_inductance_d, axis.motor_.config_.phase_inductance_q,
+                axis.motor_.config_.dead_time_voltage, axis.motor_.config_.dead_time_current,
+                (int)axis.encoder_.config_.direction, (int)axis.encoder_.config_.phase_offset,
+                axis.encoder_.config_.phase_offset_float);
+    } else if (options.scenario == "velocity_step" || options.scenario == "position_step"
+            || options.scenario == "torque_step") {
+        bool is_vel = options.scenario == "velocity_step";
+        bool is_torque = options.scenario == "torque_step";
+        axis.controller_.config_.control_mode = is_vel ? Controller::CONTROL_MODE_VELOCITY_CONTROL
+                                              : is_torque ? Controller::CONTROL_MODE_TORQUE_CONTROL
+                                              : Controller::CONTROL_MODE_POSITION_CONTROL;
+        axis.controller_.config_.input_mode = Controller::INPUT_MODE_PASSTHROUGH;
+        axis.requested_state_ = Axis::AXIS_STATE_CLOSED_LOOP_CONTROL;
+        sim.run_for(0.1f);
+        if (axis.current_state_ != Axis::AXIS_STATE_CLOSED_LOOP_CONTROL) {
+            fprintf(stderr, "failed to enter closed loop control\n");
+            print_errors(axis);
+            return 1;
+        }
+
+        Position pos_offset = *axis.encoder_.pos_estimate_.present();
+        float setpoint = !is_nan(options.setpoint) ? options.setpoint : is_vel ? 10.0f : is_torque ? 0.2f : 1.0f;
+        if (is_vel) {
+            axis.controller_.input_vel_ = setpoint;
+            axis.controller_.config_.vel_limit = std::max(20.0f, 1.25f * setpoint);
+        } else if (is_torque) {
+            axis.controller_.input_torque_ = setpoint;
+        } else {
+            axis.controller_.input_pos_ = pos_offset + setpoint;
+            axis.controller_.input_pos_updated();
+        }
+
+        // Step response of the plant in the unit of the setpoint
+        const MotorPlant& plant = sim.plants_[0];
+        double plant_pos_offset = plant.get_pos() / (2.0 * M_PI);
+        auto plant_output = [&]() -> float {
+            return is_vel ? plant.get_vel() / (2.0 * M_PI)
+                 : is_torque ? plant.get_iq() * plant.config_.torque_constant
+                 : plant.get_pos() / (2.0 * M_PI) - plant_pos_offset;
+        };
+        std::vector<float> response;
+
+        fprintf(csv, "time,plant_pos,plant_vel,pos_estimate,vel_estimate,Iq_setpoint,Iq_measured,plant_iq,plant_id\n");
+        float t0 = sim.get_time();
+        uint64_t n_steps = (uint64_t)std::round(options.duration / current_meas_period);
+        for (uint64_t i = 0; i < n_steps; ++i) {
+            response.push_back(plant_output());
+            if (i % options.decimation == 0) {
+                fprintf(csv, "%.6f,%.6f,%.6f,%.6f,%.6f,%.4f,%.4f,%.4f,%.4f\n",
+                        sim.get_time() - t0,
+                        plant.get_pos() / (2.0 * M_PI),
+                        plant.get_vel() / (2.0 * M_PI),
+                        *axis.encoder_.pos_estimate_.present() - pos_offset,
+                        *axis.encoder_.vel_estimate_.present(),
+                        axis.motor_.current_control_.Idq_setpoint_.has_value() ? axis.motor_.current_control_.Idq_setpoint_->second : 0.0f,
+                        axis.motor_.current_control_.Iq_measured_,
+                        plant.get_iq(),
+                        plant.get_id());
+            }
+            sim.step();
+        }
+
+        if (axis.error_ != Axis::ERROR_NONE) {
+            fprintf(stderr, "axis failed during the step response\n");
+            print_errors(axis);
+            return 1;
+        }
+
+        StepMetrics metrics = compute_step_metrics(response, setpoint, current_meas_period);
+        fprintf(stderr, "rise time %.2f ms, overshoot %.1f %%, final error %.3g\n",
+                metrics.rise_time * 1e3f, metrics.overshoot, metrics.final_error);
+        if (!(metrics.rise_time <= options.max_rise_time) || !(metrics.overshoot <= options.max_overshoot)
+                || !(metrics.final_error <= options.max_final_error)) {
+            fprintf(stderr, "step response out of bounds\n");
+            return 1;
+        }
+    } else if (options.scenario == "mode_sweep") {
+        Controller& controller = axis.controller_;
+        axis.trap_traj_.config_.vel_limit = 5.0f;
+        axis.trap_traj_.config_.accel_limit = 20.0f;
+        axis.trap_traj_.config_.decel_limit = 20.0f;
+        axis.trap_traj_.config_.jerk_limit = 200.0f;
+        controller.autotuning_.frequency = 5.0f;
+        controller.autotuning_.pos_amplitude = 0.05f;
+        controller.config_.control_mode = Controller::CONTROL_MODE_VELOCITY_CONTROL;
+        controller.config_.input_mode = Controller::INPUT_MODE_PASSTHROUGH;
+        axis.requested_state_ = Axis::AXIS_STATE_CLOSED_LOOP_CONTROL;
+        sim.run_for(0.1f);
+        if (axis.current_state_ != Axis::AXIS_STATE_CLOSED_LOOP_CONTROL) {
+            fprintf(stderr, "failed to enter closed loop control\n");
+            print_errors(axis);
+            return 1;
+        }
+
+        fprintf(csv, "time,segment,plant_pos,plant_vel,pos_setpoint,vel_setpoint,torque_setpoint,Iq_setpoint\n");
+        float t0 = sim.get_time();
+        uint64_t n_steps = (uint64_t)std::round(options.duration / current_meas_period);
+        uint64_t i = 0;
+        for (size_t n = 0; n < std::size(mode_sweep_segments); ++n) {
+            const ModeSweepSegment& segment = mode_sweep_segments[n];
+            controller.config_.circular_setpoints = segment.circular_setpoints;
+            controller.config_.set_input_mode(segment.input_mode);
+            controller.config_.set_control_mode(segment.control_mode);
+            if (segment.control_mode >= Controller::CONTROL_MODE_POSITION_CONTROL
+                    || segment.input_mode == Controller::INPUT_MODE_TRAP_TRAJ) {
+                Position start = segment.circular_setpoints ? Position{} : *axis.encoder_.pos_estimate_.present();
+                controller.set_input_pos_and_steps(start + segment.input);
+                controller.input_pos_updated();
+            } else if (segment.control_mode == Controller::CONTROL_MODE_VELOCITY_CONTROL) {
+                controller.input_vel_ = segment.input;
+            } else {
+                controller.input_torque_ = segment.input;
+            }
+
+            for (uint64_t j = 0; j < n_steps; ++j, ++i) {
+                if (i % options.decimation == 0) {
+                    const MotorPlant& plant = sim.plants_[0];
+                    fprintf(csv, "%.6f,%zu,%.6f,%.6f,%.6f,%.6f,%.6f,%.4f\n",
+                            sim.get_time() - t0, n,
+                            plant.get_pos() / (2.0 * M_PI),
+                            plant.get_vel() / (2.0 * M_PI),
+                            controller.pos_setpoint_.to_float(),
+                            controller.vel_setpoint_,
+                            controller.torque_setpoint_,
+                            axis.motor_.current_control_.Idq_setpoint_.has_value() ? axis.motor_.current_control_.Idq_setpoint_->second : 0.0f);
+                }
+                sim.step();
+            }
+        }
+
+        if (axis.error_ != Axis::ERROR_NONE) {
+            fprintf(stderr, "axis failed during the mode sweep\n");
+            print_errors(axis);
+            return 1;
+        }
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    float wall_time = std::chrono::duration<float>(std::chrono::steady_clock::now() - wall_start).count();
+    fprintf(stderr, "simulated %.3f s in %.3f s (%.1fx real time)\n",
+            sim.get_time(), wall_time, sim.get_time() / wall_time);
+
+    if (csv != stdout) {
+        fclose(csv);
+    }
+
+    if (options.reference_file && !compare_csv(options.csv_file, options.reference_file)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,190 @@
+/*
+* @brief Deterministic stand-in for the CMSIS-RTOS API used by the firmware.
+*
+* Every firmware thread runs on its own host thread, but only one context
+* (either the simulated interrupt context or exactly one firmware thread) is
+* allowed to run at any given time. Control is handed over explicitly: the
+* simulator runs the interrupt handlers and then calls sim_os_run_threads()
+* which resumes each thread that became ready, in priority order, until it
+* blocks again in osDelay() or osSignalWait(). Since the host scheduler is
+* never involved in deciding who runs next, a simulation is bit-exactly
+* reproducible.
+*/
+
+#include "sim_os.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cmsis_os.h>
+
+struct tskTaskControlBlock {
+    enum State {
+        kReady,
+        kDelayed,
+        kWaitingForSignal,
+    };
+
+    const char* name;
+    os_pthread function;
+    void* argument;
+    osPriority priority;
+
+    State state = kReady;
+    uint32_t wake_tick = 0;
+    bool has_timeout = false;
+    int32_t signals = 0;
+    int32_t wait_mask = 0;
+    std::condition_variable resume;
+};
+
+// These objects are never destroyed because the firmware threads never
+// terminate and may still be blocked on them when the process exits.
+static std::mutex& mutex = *new std::mutex();
+static std::condition_variable& yielded = *new std::condition_variable();
+static std::vector<osThreadId>& threads = *new std::vector<osThreadId>();
+static osThreadId current_thread = nullptr; // nullptr: interrupt context
+static uint64_t now_us = 0;
+
+static uint32_t now_ticks() {
+    return (uint32_t)(now_us * osKernelSysTickFrequency / 1000000ULL);
+}
+
+static bool is_ready(osThreadId thread) {
+    switch (thread->state) {
+        case tskTaskControlBlock::kReady:
+            return true;
+        case tskTaskControlBlock::kDelayed:
+            return (int32_t)(now_ticks() - thread->wake_tick) >= 0;
+        case tskTaskControlBlock::kWaitingForSignal:
+            return (thread->signals & thread->wait_mask)
+                || (thread->has_timeout && (int32_t)(now_ticks() - thread->wake_tick) >= 0);
+    }
+    return false;
+}
+
+// Hands control back to the interrupt context and blocks until the calling
+// thread is resumed. Must be called with the mutex held.
+static void yield_and_wait(std::unique_lock<std::mutex>& lock) {
+    osThreadId self = current_thread;
+    current_thread = nullptr;
+    yielded.notify_all();
+    self->resume.wait(lock, [self] { return current_thread == self; });
+}
+
+static void thread_entry(osThreadId self) {
+    std::unique_lock<std::mutex> lock(mutex);
+    self->resume.wait(lock, [self] { return current_thread == self; });
+    lock.unlock();
+
+    self->function(self->argument);
+
+    // A firmware thread returned. It will never be scheduled again.
+    lock.lock();
+    threads.erase(std::find(threads.begin(), threads.end(), self));
+    current_thread = nullptr;
+    yielded.notify_all();
+}
+
+void sim_os_set_time_us(uint64_t time_us) {
+    std::unique_lock<std::mutex> lock(mutex);
+    now_us = time_us;
+}
+
+uint64_t sim_os_get_time_us() {
+    return now_us;
+}
+
+void sim_os_run_threads() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+        // Pick the highest priority ready thread. Among threads of equal
+        // priority the one that was created first wins.
+        osThreadId next = nullptr;
+        for (osThreadId thread : threads) {
+            if (is_ready(thread) && (!next || thread->priority > next->priority)) {
+                next = thread;
+            }
+        }
+        if (!next) {
+            return;
+        }
+
+        next->state = tskTaskControlBlock::kReady;
+        current_thread = next;
+        next->resume.notify_all();
+        yielded.wait(lock, [] { return current_thread == nullptr; });
+    }
+}
+
+// CMSIS-RTOS API ----------------------------------------------------------------
+
+osThreadId osThreadCreate(const osThreadDef_t* thread_def, void* argument) {
+    osThreadId thread = new tskTaskControlBlock();
+    thread->name = thread_def->name;
+    thread->function = thread_def->pthread;
+    thread->argument = argument;
+    thread->priority = thread_def->tpriority;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    threads.push_back(thread);
+    std::thread(thread_entry, thread).detach();
+    return thread;
+}
+
+osPriority osThreadGetPriority(osThreadId thread_id) {
+    return thread_id ? thread_id->priority : osPriorityError;
+}
+
+osStatus osDelay(uint32_t millisec) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!current_thread) {
+        return osErrorISR;
+    }
+    current_thread->state = tskTaskControlBlock::kDelayed;
+    current_thread->wake_tick = now_ticks() + millisec;
+    yield_and_wait(lock);
+    return osOK;
+}
+
+int32_t osSignalSet(osThreadId thread_id, int32_t signals) {
+    std::unique_lock<std::mutex> lock(mutex);
+    int32_t previous = thread_id->signals;
+    thread_id->signals |= signals;
+    return previous;
+}
+
+osEvent osSignalWait(int32_t signals, uint32_t millisec) {
+    std::unique_lock<std::mutex> lock(mutex);
+    osEvent event = {};
+    osThreadId self = current_thread;
+    if (!self) {
+        event.status = osErrorISR;
+        return event;
+    }
+
+    if (!(self->signals & signals) && millisec != 0) {
+        self->state = tskTaskControlBlock::kWaitingForSignal;
+        self->wait_mask = signals;
+        self->has_timeout = (millisec != osWaitForever);
+        self->wake_tick = now_ticks() + millisec;
+        yield_and_wait(lock);
+    }
+
+    if (self->signals & signals) {
+        event.status = osEventSignal;
+        event.value.signals = self->signals & signals;
+        self->signals &= ~signals;
+    } else {
+        event.status = millisec ? osEventTimeout : osOK;
+    }
+    return event;
+}
+
+uint32_t osKernelSysTick(void) {
+    return now_ticks();
+}
@@ -0,0 +1,19 @@
+#ifndef __SIM_OS_HPP
+#define __SIM_OS_HPP
+
+#include <stdint.h>
+
+/**
+ * @brief Sets the simulated system time. osDelay() and osSignalWait()
+ * timeouts as well as osKernelSysTick() are based on this time.
+ */
+void sim_os_set_time_us(uint64_t time_us);
+uint64_t sim_os_get_time_us();
+
+/**
+ * @brief Runs all firmware threads that are ready until each of them blocks
+ * again. Must be called from the simulated interrupt context.
+ */
+void sim_os_run_threads();
+
+#endif // __SIM_OS_HPP
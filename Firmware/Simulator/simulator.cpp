@@ -0,0 +1,129 @@
+
+#include "simulator.hpp"
+
+#include <cmath>
+
+#include <odrive_main.h>
+#include <low_level.h>
+
+#include "sim_board.hpp"
+#include "sim_os.hpp"
+
+Simulator::Simulator(const Config_t& config) : config_(config) {
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        plants_[i].config_ = config_.motors[i];
+    }
+    config_clear_all();
+}
+
+bool Simulator::boot() {
+    if (!config_apply_all()) {
+        odrv.misconfigured_ = true;
+    }
+
+    sim_board_set_fet_temperature(config_.fet_temperature);
+    start_general_purpose_adc();
+
+    for (auto& axis: axes) {
+        axis.motor_.setup();
+    }
+
+    for (auto& axis: axes) {
+        axis.encoder_.setup();
+    }
+
+    start_adc_pwm();
+
+    // Give the current sensor calibration time to converge (same as rtos_main())
+    bool motors_ready = run_until([] {
+        return std::all_of(axes.begin(), axes.end(), [](auto& axis) {
+            return axis.motor_.current_meas_.has_value();
+        });
+    }, 2.0f);
+
+    for (auto& axis: axes) {
+        axis.sensorless_estimator_.error_ &= ~SensorlessEstimator::ERROR_UNKNOWN_CURRENT_MEASUREMENT;
+    }
+
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        axes[i].start_thread();
+    }
+
+    odrv.system_stats_.fully_booted = true;
+
+    // Let the axis threads run their startup sequence
+    sim_os_run_threads();
+
+    return motors_ready;
+}
+
+void Simulator::step() {
+    // Feed the measurements of the plant to the peripherals
+    Iph_ABC_t currents[AXIS_COUNT];
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        float I[3];
+        plants_[i].get_phase_currents(I);
+        currents[i] = {I[0], I[1], I[2]};
+
+        int64_t encoder_count = plants_[i].get_encoder_count();
+        TIM_TypeDef* enc_tim = encoders[i].timer_->Instance;
+        enc_tim->CNT = (uint16_t)(enc_tim->CNT + (uint32_t)(encoder_count - last_encoder_count_[i]));
+        last_encoder_count_[i] = encoder_count;
+    }
+    sim_board_sample_adcs(currents, active_ccr_, config_.vbus_voltage);
+
+    uint64_t time_us = get_time_us();
+    TIM_TIME_BASE->CNT = (uint32_t)(time_us % 1000);
+    sim_os_set_time_us(time_us);
+
+    sim_board_control_loop_irq();
+    sim_os_run_threads();
+
+    // On the real board the control loop finishes after the timer update event
+    // in the middle of the control period, so the new PWM timings only take
+    // effect at the start of the next control period.
+    integrate(current_meas_period);
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        TIM_TypeDef* tim = motors[i].timer_->Instance;
+        sim_board_timer_update(tim);
+        active_ccr_[i][0] = tim->CCR1;
+        active_ccr_[i][1] = tim->CCR2;
+        active_ccr_[i][2] = tim->CCR3;
+    }
+
+    n_steps_++;
+}
+
+void Simulator::integrate(float duration) {
+    for (size_t i = 0; i < AXIS_COUNT; ++i) {
+        // PWM mode 2: the high side FET is on while the counter is above CCR.
+        float duty[3];
+        for (size_t j = 0; j < 3; ++j) {
+            duty[j] = 1.0f - std::clamp((float)active_ccr_[i][j] / (float)TIM_1_8_PERIOD_CLOCKS, 0.0f, 1.0f);
+        }
+        bool enabled = motors[i].timer_->Instance->BDTR & TIM_BDTR_MOE;
+        plants_[i].step(duration, duty, enabled, config_.vbus_voltage);
+    }
+}
+
+void Simulator::run_for(float duration) {
+    uint64_t n_steps = (uint64_t)std::round(duration / current_meas_period);
+    for (uint64_t i = 0; i < n_steps; ++i) {
+        step();
+    }
+}
+
+bool Simulator::run_until(const std::function<bool()>& condition, float timeout) {
+    uint64_t n_steps = (uint64_t)std::round(timeout / current_meas_period);
+    for (uint64_t i = 0; i < n_steps; ++i) {
+        if (condition()) {
+            return true;
+        }
+        step();
+    }
+    return condition();
+}
+
+uint64_t Simulator::get_time_us() const {
+    return n_steps_ * (uint64_t)CONTROL_TIMER_PERIOD_TICKS * 1000000 / TIM_1_8_CLOCK_HZ;
+}
@@ -0,0 +1,80 @@
+#ifndef __SIMULATOR_HPP
+#define __SIMULATOR_HPP
+
+#include <board.h>
+
+#include <functional>
+
+#include "motor_plant.hpp"
+
+/**
+ * @brief Closed loop simulation of the ODrive firmware and the motors that are
+ * attached to it.
+ *
+ * The firmware objects are globals, so there must only be one Simulator
+ * instance per process.
+ *
+ * Each call to step() advances the simulation by one control period
+ * (current_meas_period) in the following order:
+ *
+ *  1. The phase currents, DC bus voltage and encoder counts of the plant are
+ *     loaded into the ADC and timer registers.
+ *  2. The control loop interrupt runs (sampling_cb, current_meas_cb,
+ *     control_loop_cb, dc_calib_cb, pwm_update_cb).
+ *  3. All firmware threads that became ready (e.g. the axis state machines)
+ *     run until they block again.
+ *  4. The plant is integrated over one control period with the PWM timings
+ *     of the previous iteration, then the new timings are latched (like at the
+ *     timer update event).
+ *
+ * Nothing in this sequence depends on the wall clock, so two simulations with
+ * the same inputs produce bit-identical results.
+ */
+class Simulator {
+public:
+    struct Config_t {
+        float vbus_voltage = 24.0f; // [V] ideal DC supply
+        float fet_temperature = 25.0f; // [°C]
+        MotorPlant::Config_t motors[AXIS_COUNT];
+    };
+
+    explicit Simulator(const Config_t& config);
+
+    /**
+     * @brief Replicates the startup sequence of the firmware (main() and
+     * rtos_main()) on top of the current firmware configuration.
+     *
+     * The firmware configuration (e.g. axes[0].motor_.config_) can be modified
+     * between the constructor and this call. Returns false if the motors did
+     * not become ready.
+     */
+    bool boot();
+
+    /** @brief Advances the simulation by one control period. */
+    void step();
+
+    /** @brief Advances the simulation by the specified duration [s]. */
+    void run_for(float duration);
+
+    /**
+     * @brief Steps the simulation until the condition is true or the timeout [s]
+     * expires. Returns the final value of the condition.
+     */
+    bool run_until(const std::function<bool()>& condition, float timeout);
+
+    uint64_t get_time_us() const;
+    float get_time() const { return (float)get_time_us() * 1e-6f; }
+    uint64_t get_n_steps() const { return n_steps_; }
+
+    Config_t config_;
+    MotorPlant plants_[AXIS_COUNT];
+
+private:
+    void integrate(float duration);
+
+    uint64_t n_steps_ = 0;
+    int64_t last_encoder_count_[AXIS_COUNT] = {};
+    uint32_t active_ccr_[AXIS_COUNT][3] = {};
+};
+
+#endif // __SIMULATOR_HPP
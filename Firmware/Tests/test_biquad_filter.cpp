@@ -0,0 +1,116 @@
+#include <doctest.h>
+#include <cmath>
+#include <complex>
+
+#include "MotorControl/biquad_filter.hpp"
+
+static const float fs = 8000.0f; // control loop frequency
+
+static std::complex<float> response(const Biquad& c, float f) {
+    std::complex<float> z1 = std::polar(1.0f, -2.0f * (float)M_PI * f / fs); // z^-1
+    return (c.b0 + c.b1 * z1 + c.b2 * z1 * z1) / (1.0f - c.a1 * z1 - c.a2 * z1 * z1);
+}
+
+// Amplitude of the filter output for a unit sine wave, after settling
+template<size_t N>
+static float sine_amplitude(BiquadCascade<N>& filter, float f) {
+    float amplitude = 0.0f;
+    for (size_t i = 0; i < 16000; ++i) {
+        float y = filter.step(std::sin(2.0f * (float)M_PI * f * (float)i / fs));
+        if (i >= 8000) {
+            amplitude = std::max(amplitude, std::abs(y));
+        }
+    }
+    return amplitude;
+}
+
+TEST_SUITE("Biquad filter") {
+    TEST_CASE("low pass") {
+        Biquad lp;
+        REQUIRE(Biquad::design(Biquad::TYPE_LOW_PASS, 300.0f, 2.0f, 0.0f, fs, &lp));
+        CHECK(std::abs(response(lp, 0.0f)) == doctest::Approx(1.0f));
+        CHECK(std::abs(response(lp, 300.0f)) == doctest::Approx(2.0f).epsilon(1e-3)); // gain = Q at the corner
+        CHECK(std::arg(response(lp, 300.0f)) == doctest::Approx(-M_PI / 2).epsilon(1e-3));
+        CHECK(std::abs(response(lp, 3000.0f)) < 0.02f);
+    }
+
+    TEST_CASE("notch") {
+        Biquad notch;
+        REQUIRE(Biquad::design(Biquad::TYPE_NOTCH, 250.0f, 1.0f, 0.9f, fs, &notch));
+        CHECK(std::abs(response(notch, 0.0f)) == doctest::Approx(1.0f));
+        CHECK(std::abs(response(notch, 250.0f)) == doctest::Approx(0.1f).epsilon(1e-3));
+        CHECK(std::abs(response(notch, 2500.0f)) == doctest::Approx(1.0f).epsilon(1e-2));
+
+        REQUIRE(Biquad::design(Biquad::TYPE_NOTCH, 250.0f, 1.0f, 1.0f, fs, &notch));
+        CHECK(std::abs(response(notch, 250.0f)) < 1e-4f);
+        // Full notch: Q is the center frequency over the -3dB width
+        CHECK(std::abs(response(notch, 250.0f * (std::sqrt(1.25f) + 0.5f))) == doctest::Approx(std::sqrt(0.5f)).epsilon(2e-2));
+        CHECK(std::abs(response(notch, 250.0f * (std::sqrt(1.25f) - 0.5f))) == doctest::Approx(std::sqrt(0.5f)).epsilon(2e-2));
+
+        REQUIRE(Biquad::design(Biquad::TYPE_NOTCH, 250.0f, 1.0f, 0.0f, fs, &notch));
+        CHECK(std::abs(response(notch, 250.0f)) == doctest::Approx(1.0f));
+    }
+
+    TEST_CASE("lead-lag") {
+        Biquad lead;
+        REQUIRE(Biquad::design(Biquad::TYPE_LEAD_LAG, 200.0f, 0.0f, 4.0f, fs, &lead));
+        CHECK(std::abs(response(lead, 0.0f)) == doctest::Approx(1.0f));
+        CHECK(std::abs(response(lead, fs / 2)) == doctest::Approx(4.0f).epsilon(1e-3));
+        float max_phase = std::asin(3.0f / 5.0f);
+        CHECK(std::arg(response(lead, 200.0f)) == doctest::Approx(max_phase).epsilon(1e-3));
+        CHECK(std::arg(response(lead, 150.0f)) < max_phase);
+        CHECK(std::arg(response(lead, 270.0f)) < max_phase);
+
+        Biquad lag;
+        REQUIRE(Biquad::design(Biquad::TYPE_LEAD_LAG, 200.0f, 0.0f, 0.25f, fs, &lag));
+        CHECK(std::arg(response(lag, 200.0f)) == doctest::Approx(-max_phase).epsilon(1e-3));
+    }
+
+    TEST_CASE("invalid parameters") {
+        Biquad c;
+        Biquad prev = c;
+        CHECK_FALSE(Biquad::design(Biquad::TYPE_NOTCH, 4000.0f, 1.0f, 1.0f, fs, &c)); // Nyquist
+        CHECK_FALSE(Biquad::design(Biquad::TYPE_NOTCH, 0.0f, 1.0f, 1.0f, fs, &c));
+        CHECK_FALSE(Biquad::design(Biquad::TYPE_NOTCH, 300.0f, 0.0f, 1.0f, fs, &c));
+        CHECK_FALSE(Biquad::design(Biquad::TYPE_NOTCH, 300.0f, 1.0f, 1.5f, fs, &c));
+        CHECK_FALSE(Biquad::design(Biquad::TYPE_LOW_PASS, NAN, 1.0f, 0.0f, fs, &c));
+        CHECK_FALSE(Biquad::design(Biquad::TYPE_LEAD_LAG, 300.0f, 1.0f, 0.0f, fs, &c));
+        CHECK(c.b0 == prev.b0);
+        CHECK(c.a1 == prev.a1);
+    }
+
+    TEST_CASE("cascade") {
+        Biquad sections[2];
+        REQUIRE(Biquad::design(Biquad::TYPE_NOTCH, 300.0f, 2.0f, 0.9f, fs, &sections[0]));
+        REQUIRE(Biquad::design(Biquad::TYPE_LOW_PASS, 1000.0f, 0.707f, 0.0f, fs, &sections[1]));
+        BiquadCascade<4> filter;
+        filter.set_sections(sections, 2);
+        CHECK(filter.size() == 2);
+
+        for (float f : {50.0f, 300.0f, 1000.0f}) {
+            float expected = std::abs(response(sections[0], f) * response(sections[1], f));
+            CHECK(sine_amplitude(filter, f) == doctest::Approx(expected).epsilon(1e-2));
+        }
+
+        // Empty cascade passes the input through
+        filter.set_sections(sections, 0);
+        CHECK(filter.step(1.234f) == 1.234f);
+    }
+
+    TEST_CASE("steady state reset") {
+        Biquad sections[3];
+        REQUIRE(Biquad::design(Biquad::TYPE_NOTCH, 300.0f, 2.0f, 0.9f, fs, &sections[0]));
+        REQUIRE(Biquad::design(Biquad::TYPE_LOW_PASS, 500.0f, 0.707f, 0.0f, fs, &sections[1]));
+        REQUIRE(Biquad::design(Biquad::TYPE_LEAD_LAG, 100.0f, 0.0f, 3.0f, fs, &sections[2]));
+        BiquadCascade<4> filter;
+        filter.set_sections(sections, 3);
+        filter.reset(2.5f);
+        for (size_t i = 0; i < 100; ++i) {
+            CHECK(filter.step(2.5f) == doctest::Approx(2.5f).epsilon(1e-5));
+        }
+
+        // Changing the sections at a constant input does not cause a step
+        filter.set_sections(sections, 1);
+        CHECK(filter.step(2.5f) == doctest::Approx(2.5f).epsilon(1e-5));
+    }
+}
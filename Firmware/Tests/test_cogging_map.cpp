@@ -0,0 +1,96 @@
+#include <doctest.h>
+#include <cmath>
+#include <type_traits>
+
+#include "MotorControl/cogging_map.hpp"
+
+static_assert(std::is_trivially_copyable_v<CoggingMap>, "the map is stored in NVM");
+
+TEST_SUITE("Cogging map") {
+    TEST_CASE("storage size") {
+        // Same resolution as the former 3600 float map in half the space
+        CHECK(CoggingMap::kMaxBins == 3600);
+        CHECK(sizeof(CoggingMap) <= 3600 * sizeof(int16_t) + 16);
+    }
+
+    TEST_CASE("quantization") {
+        CoggingMap map;
+        CHECK(map.size() == CoggingMap::kMaxBins);
+        for (uint32_t i = 0; i < map.size(); ++i) {
+            map.set(i, 0.01f * std::sin(2.0f * (float)M_PI * 12.0f * (float)i / (float)map.size()));
+        }
+        for (uint32_t i = 0; i < map.size(); ++i) {
+            float expected = 0.01f * std::sin(2.0f * (float)M_PI * 12.0f * (float)i / (float)map.size());
+            CHECK(std::abs(map.get(i) - expected) <= 0.5f * map.scale() * 1.001f);
+        }
+        CHECK(map.get(map.size()) == 0.0f);
+    }
+
+    TEST_CASE("scale grows to fit large values") {
+        CoggingMap map;
+        map.set(0, 0.1f);
+        map.set(1, -0.2f);
+        float scale = map.scale();
+        map.set(2, 5.0f); // does not fit into the initial scale
+        CHECK(map.scale() > scale);
+        CHECK(5.0f <= INT16_MAX * map.scale());
+        CHECK(map.get(0) == doctest::Approx(0.1f).epsilon(map.scale() / 0.1f));
+        CHECK(map.get(1) == doctest::Approx(-0.2f).epsilon(map.scale() / 0.2f));
+        CHECK(map.get(2) == doctest::Approx(5.0f).epsilon(map.scale() / 5.0f));
+
+        map.set(3, NAN);
+        CHECK(map.get(3) == 0.0f);
+    }
+
+    TEST_CASE("interpolation") {
+        CoggingMap map;
+        map.resize(4);
+        CHECK(map.size() == 4);
+        map.set(0, 0.0f);
+        map.set(1, 0.1f);
+        map.set(2, 0.3f);
+        map.set(3, -0.1f);
+
+        // At the bins
+        CHECK(map.interpolate(0.0f) == map.get(0));
+        CHECK(map.interpolate(0.25f) == map.get(1));
+        CHECK(map.interpolate(0.5f) == map.get(2));
+
+        // Between bins
+        CHECK(map.interpolate(0.125f) == doctest::Approx(0.5f * (map.get(0) + map.get(1))));
+        CHECK(map.interpolate(0.3125f) == doctest::Approx(0.75f * map.get(1) + 0.25f * map.get(2)));
+
+        // Wrap-around from the last bin to the first bin
+        CHECK(map.interpolate(0.875f) == doctest::Approx(0.5f * (map.get(3) + map.get(0))));
+
+        // Positions outside of [0, 1)
+        CHECK(map.interpolate(5.125f) == doctest::Approx(map.interpolate(0.125f)));
+        CHECK(map.interpolate(-0.875f) == doctest::Approx(map.interpolate(0.125f)));
+        CHECK(map.interpolate(-0.125f) == doctest::Approx(map.interpolate(0.875f)));
+    }
+
+    TEST_CASE("remove bias") {
+        CoggingMap map;
+        map.resize(100);
+        for (uint32_t i = 0; i < map.size(); ++i) {
+            map.set(i, 0.05f + ((i % 2) ? 0.01f : -0.01f));
+        }
+        CHECK(map.mean() == doctest::Approx(0.05f).epsilon(1e-3));
+        map.subtract(map.mean());
+        CHECK(std::abs(map.mean()) <= map.scale());
+        CHECK(map.get(1) == doctest::Approx(0.01f).epsilon(1e-2));
+    }
+
+    TEST_CASE("resize") {
+        CoggingMap map;
+        map.set(0, 1.0f);
+        map.resize(0);
+        CHECK(map.size() == CoggingMap::kMaxBins);
+        CHECK(map.get(0) == 0.0f);
+        CHECK(map.scale() == CoggingMap::kInitialScale);
+        map.resize(CoggingMap::kMaxBins + 1);
+        CHECK(map.size() == CoggingMap::kMaxBins);
+        map.resize(360);
+        CHECK(map.size() == 360);
+    }
+}
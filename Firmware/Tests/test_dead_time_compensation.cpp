@@ -0,0 +1,77 @@
+#include <doctest.h>
+#include <cmath>
+
+#include "MotorControl/dead_time_compensation.hpp"
+
+TEST_SUITE("dead time compensation") {
+    TEST_CASE("compensation cancels the phase errors") {
+        DeadTimeCompensation comp{0.3f, 0.5f};
+        for (int k = 0; k < 360; k += 5) {
+            for (float I : {0.1f, 0.4f, 2.0f, 20.0f}) {
+                float Ialpha = I * std::cos(k * (float)M_PI / 180.0f);
+                float Ibeta = I * std::sin(k * (float)M_PI / 180.0f);
+                auto [v_alpha, v_beta] = comp.get_voltage(Ialpha, Ibeta);
+
+                // Voltages that the inverter applies for the compensation alone
+                float iA = Ialpha;
+                float iB = -0.5f * Ialpha + sqrt3_by_2 * Ibeta;
+                float iC = -0.5f * Ialpha - sqrt3_by_2 * Ibeta;
+                float vA = v_alpha - comp.phase_error(iA);
+                float vB = -0.5f * v_alpha + sqrt3_by_2 * v_beta - comp.phase_error(iB);
+                float vC = -0.5f * v_alpha - sqrt3_by_2 * v_beta - comp.phase_error(iC);
+
+                // Only the common mode is left, which drives no current
+                CHECK(vA - vB == doctest::Approx(0.0f).scale(1.0).epsilon(1e-6));
+                CHECK(vB - vC == doctest::Approx(0.0f).scale(1.0).epsilon(1e-6));
+            }
+        }
+    }
+
+    TEST_CASE("alpha error") {
+        DeadTimeCompensation comp{0.3f, 0.5f};
+        CHECK(comp.alpha_error(0.0f) == 0.0f);
+        CHECK(comp.alpha_error(1.0f) == doctest::Approx(0.4f));
+        CHECK(comp.alpha_error(10.0f) == doctest::Approx(0.4f));
+        CHECK(comp.alpha_error(-10.0f) == doctest::Approx(-0.4f));
+        CHECK(comp.alpha_error(0.25f) == doctest::Approx(0.75f * 0.4f * 0.5f));
+        CHECK(comp.alpha_error(10.0f) == doctest::Approx(comp.get_voltage(10.0f, 0.0f).first));
+    }
+
+    TEST_CASE("fit recovers the model") {
+        const float R = 0.05f;
+        const float currents[] = {10.0f, 5.0f, 2.0f, 1.0f, 0.5f};
+        float voltages[5];
+
+        for (float band : {0.3f, 0.4f, 0.6f}) {
+            DeadTimeCompensation truth{0.3f, band};
+            for (size_t i = 0; i < 5; ++i) {
+                voltages[i] = R * currents[i] + truth.alpha_error(currents[i]);
+            }
+            float resistance = 0.0f;
+            auto result = DeadTimeCompensation::fit(currents, voltages, 5, &resistance);
+            REQUIRE(result.has_value());
+            CHECK(resistance == doctest::Approx(R));
+            CHECK(result->get_voltage_magnitude() == doctest::Approx(0.3f));
+            CHECK(result->get_transition_current() == doctest::Approx(band).epsilon(1e-3));
+        }
+
+        // Transition below the smallest current
+        DeadTimeCompensation truth{0.3f, 0.1f};
+        for (size_t i = 0; i < 5; ++i) {
+            voltages[i] = R * currents[i] + truth.alpha_error(currents[i]);
+        }
+        float resistance = 0.0f;
+        auto result = DeadTimeCompensation::fit(currents, voltages, 5, &resistance);
+        REQUIRE(result.has_value());
+        CHECK(result->get_voltage_magnitude() == doctest::Approx(0.3f));
+        CHECK(result->get_transition_current() == doctest::Approx(0.25f));
+    }
+
+    TEST_CASE("fit rejects bad data") {
+        const float currents[] = {10.0f, 5.0f, 2.0f};
+        const float voltages[] = {0.4f, 0.5f, 0.3f};
+        float resistance = 0.0f;
+        CHECK(!DeadTimeCompensation::fit(currents, voltages, 3, &resistance).has_value());
+        CHECK(!DeadTimeCompensation::fit(currents, voltages, 2, &resistance).has_value());
+    }
+}
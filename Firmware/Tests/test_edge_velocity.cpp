@@ -0,0 +1,129 @@
+#include <doctest.h>
+#include <cmath>
+
+#include "MotorControl/edge_velocity.hpp"
+
+TEST_SUITE("EdgeVelocityEstimator") {
+    const float dt = 1.0f / 8000.0f;
+
+    TEST_CASE("few counts per second") {
+        // 3 count/s gives one edge every 2667 periods. The count per period
+        // would be a train of single count spikes of 8000 count/s.
+        EdgeVelocityEstimator estimator;
+        estimator.set_window(0.002f, 1.0f);
+        int64_t last_count = 0;
+        float max_err = 0.0f;
+        for (int i = 1; i <= 16000; ++i) {
+            int64_t count = (int64_t)std::floor(3.0 * i * dt + 0.2);
+            estimator.update(dt, (int32_t)(count - last_count));
+            last_count = count;
+            if (i > 8000) {
+                max_err = std::max(max_err, std::abs(estimator.vel() - 3.0f));
+            }
+        }
+        // The edges are seen up to one period late, which is 0.04% of the
+        // time between them
+        CHECK(max_err < 3.0f * 2.0f * dt * 3.0f);
+    }
+
+    TEST_CASE("high speed") {
+        // 1234.5 count/s is 0.154 count per period. Windows of at least 2ms
+        // resolve 1 count in 2ms.
+        EdgeVelocityEstimator estimator;
+        estimator.set_window(0.002f, 1.0f);
+        int64_t last_count = 0;
+        float max_err = 0.0f;
+        for (int i = 1; i <= 8000; ++i) {
+            int64_t count = (int64_t)std::floor(1234.5 * i * dt);
+            estimator.update(dt, (int32_t)(count - last_count));
+            last_count = count;
+            if (i > 100) {
+                max_err = std::max(max_err, std::abs(estimator.vel() - 1234.5f));
+            }
+        }
+        CHECK(max_err < 1.0f / 0.002f);
+    }
+
+    TEST_CASE("exact edge times") {
+        // With the time from each edge to the sample, 50 count/s are exact
+        EdgeVelocityEstimator estimator;
+        estimator.set_window(0.0f, 1.0f);
+        const double vel = 50.0;
+        int64_t last_count = 0;
+        for (int i = 1; i <= 8000; ++i) {
+            double t = i * dt;
+            int64_t count = (int64_t)std::floor(vel * t);
+            double edge_age = t - (double)count / vel;
+            estimator.update(dt, (int32_t)(count - last_count), 0.0f, (float)edge_age);
+            last_count = count;
+        }
+        CHECK(estimator.vel() == doctest::Approx(50.0f).epsilon(1e-4));
+    }
+
+    TEST_CASE("calibrated edges") {
+        // Hall sensors with edges that are off by up to 0.2 counts. Counting
+        // them as equidistant would make the velocity alternate by 20%.
+        const float offsets[6] = {0.0f, 0.2f, -0.1f, 0.1f, -0.2f, 0.0f};
+        EdgeVelocityEstimator estimator;
+        estimator.set_window(0.0f, 1.0f, 1.4f);
+        const double vel = 20.0;
+        int64_t last_count = 0;
+        float max_err = 0.0f;
+        for (int i = 1; i <= 16000; ++i) {
+            double pos = vel * i * dt;
+            int64_t count = (int64_t)std::floor(pos);
+            // The lower edge of count k is at k + offsets[k % 6]
+            if (pos - count < offsets[count % 6]) {
+                count--;
+            } else if (pos - count >= 1.0 + offsets[(count + 1) % 6]) {
+                count++;
+            }
+            int32_t delta = (int32_t)(count - last_count);
+            last_count = count;
+            estimator.update(dt, delta, offsets[count % 6]);
+            if (i > 8000) {
+                max_err = std::max(max_err, std::abs(estimator.vel() - 20.0f));
+            }
+        }
+        CHECK(max_err < 20.0f * 0.01f);
+    }
+
+    TEST_CASE("reversal and stop") {
+        EdgeVelocityEstimator estimator;
+        estimator.set_window(0.0f, 1.0f);
+
+        // Dithering on an edge reads zero
+        for (int i = 0; i < 100; ++i) {
+            estimator.update(dt, (i % 2) ? 1 : -1);
+            CHECK(estimator.vel() == 0.0f);
+        }
+
+        // 100 count/s forward
+        for (int i = 1; i <= 800; ++i) {
+            estimator.update(dt, (i % 80 == 0) ? 1 : 0);
+        }
+        CHECK(estimator.vel() == doctest::Approx(100.0f));
+
+        // After a stop the speed decays as one count per time since the edge
+        for (int i = 1; i <= 800; ++i) {
+            estimator.update(dt, 0);
+        }
+        CHECK(estimator.vel() == doctest::Approx(1.0f / (800.0f * dt)));
+
+        // and is zero after the timeout
+        for (int i = 1; i <= 8000; ++i) {
+            estimator.update(dt, 0);
+        }
+        CHECK(estimator.vel() == 0.0f);
+
+        // The first edge backwards only gives the direction, the second one
+        // the speed
+        estimator.update(dt, -1);
+        CHECK(estimator.vel() == 0.0f);
+        for (int i = 1; i <= 400; ++i) {
+            estimator.update(dt, 0);
+        }
+        estimator.update(dt, -1);
+        CHECK(estimator.vel() == doctest::Approx(-1.0f / (401.0f * dt)));
+    }
+}
@@ -0,0 +1,75 @@
+#include <doctest.h>
+#include <cmath>
+
+#include "MotorControl/encoder_error_map.hpp"
+
+TEST_SUITE("EncoderErrorMap") {
+    // 14 bit encoder with a once per turn error of 40 counts and a twice per
+    // turn error of 15 counts
+    const double cpr = 16384.0;
+    double reading(double pos) {
+        double error = (40.0 * std::sin(2.0 * M_PI * pos + 0.3) + 15.0 * std::sin(4.0 * M_PI * pos - 1.1)) / cpr;
+        double count = std::floor((pos + error) * cpr);
+        return count / cpr;
+    }
+
+    TEST_CASE("interpolate") {
+        EncoderErrorMap map;
+        map.set(0, 1.0f);
+        map.set(1, 3.0f);
+        map.set(EncoderErrorMap::kBins - 1, -1.0f);
+        const float bin = 1.0f / (float)EncoderErrorMap::kBins;
+        CHECK(map.interpolate(0.5f * bin) == doctest::Approx(2.0f));
+        CHECK(map.interpolate(-0.5f * bin) == doctest::Approx(0.0f));
+        CHECK(map.interpolate(3.0f + 0.25f * bin) == doctest::Approx(1.5f));
+        map.set(2, NAN);
+        CHECK(map.get(2) == 0.0f);
+        CHECK(map.get(EncoderErrorMap::kBins) == 0.0f);
+    }
+
+    TEST_CASE("calibration removes eccentricity") {
+        // Lockin spin at 1 turn/s for 10 turns at 8kHz. The rotor lags the
+        // reference by a constant 0.01 turn.
+        const double dt = 1.0 / 8000.0;
+        const double vel = 1.0;
+        EncoderErrorCalibration calibration;
+        calibration.reset();
+        for (int i = 0; i < 80000; ++i) {
+            double pos = vel * i * dt - 0.01;
+            calibration.add((float)reading(pos), (float)(vel * dt));
+        }
+        EncoderErrorMap map;
+        REQUIRE(calibration.finish(&map));
+
+        // The corrected reading follows the rotor up to a constant offset
+        double max_err_before = 0.0;
+        double max_err_after = 0.0;
+        double offset = 0.0;
+        for (int i = 0; i < 10000; ++i) {
+            double pos = 0.123 + i / 10000.0;
+            double r = reading(pos);
+            double corrected = r - map.interpolate((float)r);
+            double err_before = std::remainder(r - pos, 1.0);
+            double err_after = std::remainder(corrected - pos, 1.0);
+            if (i == 0) {
+                offset = err_after;
+            }
+            max_err_before = std::max(max_err_before, std::abs(err_before));
+            max_err_after = std::max(max_err_after, std::abs(err_after - offset));
+        }
+        CHECK(max_err_before * cpr > 50.0);
+        CHECK(max_err_after * cpr < 2.5);
+    }
+
+    TEST_CASE("incomplete turn") {
+        EncoderErrorCalibration calibration;
+        calibration.reset();
+        for (int i = 0; i < 1000; ++i) {
+            calibration.add(i * 1e-4f, 1e-4f);
+        }
+        EncoderErrorMap map;
+        map.set(0, 1.0f);
+        CHECK(!calibration.finish(&map));
+        CHECK(map.get(0) == 1.0f);
+    }
+}
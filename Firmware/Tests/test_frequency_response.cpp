@@ -0,0 +1,128 @@
+#include <doctest.h>
+#include <cmath>
+#include <complex>
+
+#include "MotorControl/frequency_response_analyzer.hpp"
+#include "MotorControl/utils.hpp"
+
+static const float dt = 0.000125f; // control loop period
+
+// Discrete first order low pass with one period of delay, driven the same way
+// as the controller drives the analyzer in INPUT_MODE_TUNING.
+struct LowPassPlant {
+    float alpha;
+    float y = 0.0f;
+    float out = 0.0f;
+
+    float step(float u) {
+        out = y; // one period of delay
+        y += alpha * (u - y);
+        return out;
+    }
+
+    std::complex<float> response(float f) const {
+        std::complex<float> z = std::polar(1.0f, 2.0f * (float)M_PI * f * dt);
+        // y[k+1] = y[k] + alpha * (u[k] - y[k]), out[k] = y[k]
+        return alpha / (z - (1.0f - alpha));
+    }
+};
+
+static void run_sweep(FrequencyResponseAnalyzer& fra, float dc_offset, float noise_amplitude = 0.0f) {
+    LowPassPlant plant{1.0f - std::exp(-2.0f * (float)M_PI * 50.0f * dt)};
+    float phase = 0.0f;
+    uint32_t lcg = 1;
+    REQUIRE(fra.start(dt));
+    for (size_t i = 0; i < 20000000 && fra.is_active(); ++i) {
+        phase = std::remainder(phase + 2.0f * (float)M_PI * fra.frequency() * dt, 2.0f * (float)M_PI);
+        float s = std::sin(phase);
+        float c = std::cos(phase);
+        float ref = dc_offset + 0.1f * s;
+        float y = plant.step(ref);
+        lcg = lcg * 1664525u + 1013904223u;
+        float noise = noise_amplitude * ((float)(lcg >> 8) / (float)(1 << 24) - 0.5f);
+        float meas[FrequencyResponseAnalyzer::kNumChannels] = {y + noise, 2.0f * ref, -ref};
+        fra.update(dt, s, c, ref, meas);
+    }
+    REQUIRE_FALSE(fra.is_active());
+    REQUIRE(fra.n_results() == fra.config_.n_points);
+
+    for (uint32_t i = 0; i < fra.n_results(); ++i) {
+        const auto& p = fra.result(i);
+        std::complex<float> expected = plant.response(p.frequency);
+        float gain_tol = fra.config_.chirp ? 0.01f : 0.002f;
+        float phase_tol = fra.config_.chirp ? 0.01f : 0.002f;
+        CHECK(p.gain[0] == doctest::Approx(std::abs(expected)).epsilon(gain_tol + 10.0f * noise_amplitude));
+        CHECK(std::abs(p.phase[0] - std::arg(expected)) < phase_tol + 10.0f * noise_amplitude);
+        CHECK(p.gain[1] == doctest::Approx(2.0f).epsilon(1e-4));
+        CHECK(std::abs(p.phase[1]) < 1e-3f);
+        CHECK(p.gain[2] == doctest::Approx(1.0f).epsilon(1e-4));
+        CHECK(std::abs(std::abs(p.phase[2]) - (float)M_PI) < 1e-3f);
+    }
+}
+
+TEST_SUITE("Frequency response analyzer") {
+    TEST_CASE("invalid config") {
+        FrequencyResponseAnalyzer fra;
+        CHECK(fra.start(dt));
+        fra.config_.start_frequency = 0.0f;
+        CHECK_FALSE(fra.start(dt));
+        fra.config_.start_frequency = 1.0f;
+        fra.config_.end_frequency = 5000.0f; // above Nyquist
+        CHECK_FALSE(fra.start(dt));
+        fra.config_.end_frequency = 200.0f;
+        fra.config_.n_points = FrequencyResponseAnalyzer::kMaxPoints + 1;
+        CHECK_FALSE(fra.start(dt));
+        fra.config_.n_points = 10;
+        fra.config_.measure_cycles = 0.5f;
+        CHECK_FALSE(fra.start(dt));
+    }
+
+    TEST_CASE("stepped sine") {
+        FrequencyResponseAnalyzer fra;
+        fra.config_.start_frequency = 2.0f;
+        fra.config_.end_frequency = 1000.0f;
+        fra.config_.n_points = 12;
+        fra.config_.settle_cycles = 5.0f;
+        fra.config_.measure_cycles = 4.0f;
+        run_sweep(fra, 0.0f);
+
+        CHECK(fra.result(0).frequency == doctest::Approx(2.0f));
+        CHECK(fra.result(11).frequency == doctest::Approx(1000.0f).epsilon(1e-4));
+        CHECK(fra.result(12).frequency == 0.0f); // out of range
+    }
+
+    TEST_CASE("DC offset and noise are rejected") {
+        FrequencyResponseAnalyzer fra;
+        fra.config_.start_frequency = 5.0f;
+        fra.config_.end_frequency = 500.0f;
+        fra.config_.n_points = 6;
+        run_sweep(fra, 100.0f, 0.002f);
+    }
+
+    TEST_CASE("chirp") {
+        FrequencyResponseAnalyzer fra;
+        fra.config_.start_frequency = 2.0f;
+        fra.config_.end_frequency = 1000.0f;
+        fra.config_.n_points = 20;
+        fra.config_.settle_cycles = 5.0f;
+        fra.config_.measure_cycles = 10.0f;
+        fra.config_.chirp = true;
+        run_sweep(fra, 0.0f);
+
+        // Bands are contiguous and reported at their center
+        float band = std::pow(500.0f, 1.0f / 20.0f);
+        CHECK(fra.result(0).frequency == doctest::Approx(2.0f * std::sqrt(band)).epsilon(1e-4));
+        CHECK(fra.result(19).frequency == doctest::Approx(1000.0f / std::sqrt(band)).epsilon(1e-3));
+    }
+
+    TEST_CASE("no excitation") {
+        FrequencyResponseAnalyzer fra;
+        fra.config_.n_points = 1;
+        REQUIRE(fra.start(dt));
+        float meas[FrequencyResponseAnalyzer::kNumChannels] = {1.0f, 2.0f, 3.0f};
+        while (fra.is_active()) {
+            fra.update(dt, 0.0f, 1.0f, 0.0f, meas);
+        }
+        CHECK(is_nan(fra.result(0).gain[0]));
+    }
+}
@@ -0,0 +1,91 @@
+#include <doctest.h>
+#include <cmath>
+
+#include "MotorControl/kalman_tracker.hpp"
+#include "MotorControl/position.hpp"
+
+TEST_SUITE("KalmanTracker") {
+    const float dt = 1.0f / 8000.0f;
+
+    TEST_CASE("steady-state gains") {
+        // Reference values from the same iteration in double precision
+        KalmanTracker tracker;
+        REQUIRE(tracker.set_noise(1e5f, 0.29f, dt));
+        CHECK(tracker.gains().pos == doctest::Approx(0.07539916f).epsilon(1e-4));
+        CHECK(tracker.gains().vel == doctest::Approx(23.64009f).epsilon(1e-4));
+        CHECK(tracker.gains().acc == doctest::Approx(3706.350f).epsilon(1e-4));
+
+        REQUIRE(tracker.set_noise(1e8f, 0.29f, dt));
+        CHECK(tracker.gains().pos == doctest::Approx(0.5434281f).epsilon(1e-4));
+        CHECK(tracker.gains().vel == doctest::Approx(1682.636f).epsilon(1e-4));
+        CHECK(tracker.gains().acc == doctest::Approx(2605009.0f).epsilon(1e-4));
+
+        // Invalid noise leaves the gains unchanged
+        CHECK(!tracker.set_noise(0.0f, 0.29f, dt));
+        CHECK(!tracker.set_noise(1e5f, NAN, dt));
+        CHECK(tracker.gains().pos == doctest::Approx(0.5434281f).epsilon(1e-4));
+    }
+
+    TEST_CASE("tracks constant acceleration without lag") {
+        KalmanTracker tracker;
+        REQUIRE(tracker.set_noise(1e5f, 0.29f, dt));
+        const float acc = 50000.0f; // [count/s^2]
+        Position pos = Position::from_parts(INT64_C(1) << 40, 0.0f);
+        Position true_pos = pos;
+        float vel = 0.0f;
+        for (int i = 1; i <= 16000; ++i) {
+            float t = (float)i * dt;
+            tracker.predict(pos, vel);
+            Position measured = true_pos + 0.5f * acc * t * t;
+            tracker.correct(pos, vel, measured - pos);
+        }
+        float t = 16000.0f * dt;
+        CHECK((pos - (true_pos + 0.5f * acc * t * t)) == doctest::Approx(0.0f).scale(1.0).epsilon(1e-2));
+        CHECK(vel == doctest::Approx(acc * t).epsilon(1e-5));
+        CHECK(tracker.acc() == doctest::Approx(acc).epsilon(1e-2));
+    }
+
+    TEST_CASE("innovations") {
+        CHECK(KalmanTracker::interval_innovation(-0.25f, 0.75f) == 0.0f);
+        CHECK(KalmanTracker::interval_innovation(0.5f, 1.5f) == 0.5f);
+        CHECK(KalmanTracker::interval_innovation(-1.5f, -0.5f) == -0.5f);
+
+        // The edge was crossed 1ms ago at 1000 count/s, so the position should
+        // have moved on by one count since
+        KalmanTracker tracker;
+        CHECK(tracker.edge_innovation(0.0f, 1000.0f, 1e-3f) == doctest::Approx(1.0f));
+    }
+
+    TEST_CASE("quantized velocity noise") {
+        // Counts of a constant velocity of 0.37 count per period. The
+        // estimate only gets the count, like an incremental encoder.
+        KalmanTracker tracker;
+        REQUIRE(tracker.set_noise(8.2e5f, 0.29f, dt));
+        const double true_vel = 0.37 / dt;
+        Position pos;
+        float vel = (float)true_vel;
+        int64_t last_count = 0;
+        double sum_sq = 0.0;
+        int n = 0;
+        for (int i = 0; i < 40000; ++i) {
+            int64_t count = (int64_t)std::floor(0.37 * i + 0.3);
+            int64_t delta = count - last_count;
+            last_count = count;
+            tracker.predict(pos, vel);
+            float count_minus_pos = (float)(count - pos.whole()) - pos.frac();
+            float innovation = (delta == 1) ? tracker.edge_innovation(count_minus_pos, vel, 0.5f * dt)
+                             : KalmanTracker::interval_innovation(count_minus_pos, count_minus_pos + 1.0f);
+            tracker.correct(pos, vel, innovation);
+            if (delta == 0 && innovation == 0.0f) {
+                tracker.reset();
+            }
+            if (i >= 20000) {
+                sum_sq += (vel - true_vel) * (vel - true_vel);
+                n++;
+            }
+        }
+        // The default PLL (1000 rad/s) settles slower and has about 2%
+        // (60 count/s) here
+        CHECK(std::sqrt(sum_sq / n) < 0.005 * true_vel);
+    }
+}
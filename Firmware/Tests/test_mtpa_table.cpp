@@ -0,0 +1,72 @@
+#include <doctest.h>
+#include <cmath>
+
+#include "MotorControl/mtpa_table.hpp"
+
+// IPM motor with a strong reluctance torque within its current range
+static const float Kt = 0.04f; // [Nm/A]
+static const int32_t pp = 7;
+static const float Ld = 100e-6f; // [H]
+static const float Lq = 300e-6f; // [H]
+static const float I_max = 20.0f; // [A]
+
+static float torque(float id, float iq) {
+    float psi = Kt / (1.5f * pp);
+    return 1.5f * pp * (psi * iq + (Ld - Lq) * id * iq);
+}
+
+TEST_SUITE("MTPA table") {
+    TEST_CASE("rejects non-salient motors") {
+        MtpaTable table;
+        CHECK(!table.design(Kt, pp, 100e-6f, 100e-6f, I_max));
+        CHECK(!table.design(Kt, pp, 300e-6f, 100e-6f, I_max));
+        CHECK(!table.design(Kt, pp, Ld, Lq, 0.0f));
+        CHECK(!table.design(0.0f, pp, Ld, Lq, I_max));
+    }
+
+    TEST_CASE("lookup produces the requested torque") {
+        MtpaTable table;
+        REQUIRE(table.design(Kt, pp, Ld, Lq, I_max));
+        float max_torque = table.torque_at_current(I_max);
+        CHECK(max_torque > Kt * I_max); // reluctance torque adds to the magnet torque
+
+        auto p0 = table.lookup(0.0f);
+        CHECK(p0.id == doctest::Approx(0.0f));
+        CHECK(p0.iq == doctest::Approx(0.0f));
+
+        for (int i = -100; i <= 100; ++i) {
+            float T = max_torque * (float)i / 100.0f;
+            auto p = table.lookup(T);
+            CHECK(p.id <= 0.0f);
+            CHECK(torque(p.id, p.iq) == doctest::Approx(T).epsilon(0.01).scale(0.01 * max_torque));
+        }
+    }
+
+    TEST_CASE("lookup is close to the minimum current") {
+        MtpaTable table;
+        REQUIRE(table.design(Kt, pp, Ld, Lq, I_max));
+        float max_torque = table.torque_at_current(I_max);
+
+        for (float T : {0.1f * max_torque, 0.5f * max_torque, 0.9f * max_torque}) {
+            auto p = table.lookup(T);
+            float Is = std::hypot(p.id, p.iq);
+
+            // Brute force: smallest current magnitude on a dense grid of
+            // current angles that reaches the torque
+            float best = INFINITY;
+            for (int k = 0; k <= 9000; ++k) {
+                float angle = (float)M_PI / 2.0f * (1.0f + (float)k / 9000.0f); // from +q towards -d
+                float per_amp = torque(std::cos(angle), std::sin(angle));
+                if (per_amp > 0.0f) {
+                    // torque scales with Is^2 for the reluctance part, solve T = a Is + b Is^2
+                    float a = Kt * std::sin(angle);
+                    float b = 1.5f * pp * (Ld - Lq) * std::cos(angle) * std::sin(angle);
+                    float I = (b > 1e-9f) ? (-a + std::sqrt(a * a + 4.0f * b * T)) / (2.0f * b) : T / a;
+                    best = std::min(best, I);
+                }
+            }
+            CHECK(Is == doctest::Approx(best).epsilon(0.005));
+            CHECK(Is < T / Kt); // less current than without reluctance torque
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#include <doctest.h>
+#include <cmath>
+#include <initializer_list>
+
+#include "MotorControl/position.hpp"
+#include "MotorControl/utils.hpp"
+
+TEST_SUITE("Position") {
+    TEST_CASE("float conversion") {
+        for (float x : {0.0f, 0.25f, -0.25f, 1.0f, -1.0f, 12345.5f, -12345.5f, 1e9f, -3e10f}) {
+            Position pos{x};
+            CHECK(pos.frac() >= 0.0f);
+            CHECK(pos.frac() < 1.0f);
+            CHECK(pos.to_float() == x);
+        }
+        CHECK(Position{-0.25f}.whole() == -1);
+        CHECK(Position{-0.25f}.frac() == 0.75f);
+        CHECK(is_nan(Position{NAN}.to_float()));
+
+        // A tiny negative fraction rounds up to 1
+        Position pos{-1e-10f};
+        CHECK(pos.frac() < 1.0f);
+        CHECK(pos.to_float() == doctest::Approx(0.0f).scale(1.0));
+    }
+
+    TEST_CASE("difference keeps full resolution far from zero") {
+        for (int64_t whole : {INT64_C(0), INT64_C(1) << 40, -(INT64_C(1) << 62), INT64_MAX - 10}) {
+            Position a = Position::from_parts(whole, 0.5f);
+            Position b = a + 1e-6f;
+            CHECK(b - a == doctest::Approx(1e-6f).epsilon(1e-3));
+            CHECK(a - b == doctest::Approx(-1e-6f).epsilon(1e-3));
+
+            // Crossing a whole unit
+            Position c = a + 0.75f;
+            CHECK(c.whole() == whole + 1);
+            CHECK(c.frac() == 0.25f);
+            CHECK(c - a == 0.75f);
+            CHECK((c - 0.75f) == a);
+        }
+    }
+
+    TEST_CASE("accumulation does not drift") {
+        // 10^6 steps of 1/1024 at 2^40 turns, where a float has no fractional
+        // bits left
+        Position pos = Position::from_parts(INT64_C(1) << 40, 0.0f);
+        Position start = pos;
+        for (int i = 0; i < 1000000; ++i) {
+            pos += 1.0f / 1024.0f;
+        }
+        CHECK(pos - start == 1000000.0f / 1024.0f);
+
+        // Large steps don't round the fraction
+        pos = Position::from_parts(7, 0.123456f);
+        pos += 1000.0f;
+        CHECK(pos.whole() == 1007);
+        CHECK(pos.frac() == 0.123456f);
+        pos -= 2000.5f;
+        CHECK(pos.whole() == -994);
+        CHECK(pos.frac() == doctest::Approx(0.623456f).epsilon(1e-6));
+    }
+
+    TEST_CASE("counts to turns") {
+        const int32_t cpr = 8192;
+        for (int64_t count : {INT64_C(0), INT64_C(8191), INT64_C(8192), INT64_C(-1), INT64_C(-8192), INT64_C(-8193),
+                              INT64_C(3) << 40, -(INT64_C(3) << 40) - 5}) {
+            Position turns = Position::from_counts(Position::from_parts(count, 0.5f), cpr);
+            int64_t expected_whole = count / cpr - ((count % cpr < 0) ? 1 : 0);
+            int64_t rem = count - expected_whole * cpr;
+            CHECK(turns.whole() == expected_whole);
+            CHECK(turns.frac() == doctest::Approx(((float)rem + 0.5f) / (float)cpr).epsilon(1e-6));
+        }
+    }
+}
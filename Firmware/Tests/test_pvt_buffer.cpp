@@ -0,0 +1,189 @@
+#include <doctest.h>
+#include <cmath>
+#include <vector>
+
+#include "MotorControl/pvt_buffer.hpp"
+
+static const float dt = 0.000125f; // control loop period
+
+// Cubic test trajectory that the Hermite interpolation must reproduce exactly.
+// Starts at 0 so that float resolution does not dominate the acceleration.
+static float cubic_pos(float t) { return 2.0f*t - 3.0f*t*t + 0.5f*t*t*t; }
+static float cubic_vel(float t) { return 2.0f - 6.0f*t + 1.5f*t*t; }
+static float cubic_acc(float t) { return -6.0f + 3.0f*t; }
+
+TEST_SUITE("PVT buffer") {
+    TEST_CASE("push and overrun") {
+        PvtBuffer buffer;
+        CHECK(buffer.size() == 0);
+        for (size_t i = 0; i < PvtBuffer::kCapacity; ++i) {
+            CHECK(buffer.push({(float)i, 0.0f, 0.001f}));
+        }
+        CHECK(buffer.size() == PvtBuffer::kCapacity);
+        CHECK(buffer.overrun_count_ == 0);
+        CHECK_FALSE(buffer.push({0.0f, 0.0f, 0.001f}));
+        CHECK(buffer.overrun_count_ == 1);
+        CHECK(buffer.size() == PvtBuffer::kCapacity);
+    }
+
+    TEST_CASE("invalid points") {
+        PvtBuffer buffer;
+        CHECK_FALSE(buffer.push({NAN, 0.0f, 0.001f}));
+        CHECK_FALSE(buffer.push({0.0f, INFINITY, 0.001f}));
+        CHECK_FALSE(buffer.push({0.0f, 0.0f, 0.0f}));
+        CHECK_FALSE(buffer.push({0.0f, 0.0f, -0.001f}));
+        CHECK_FALSE(buffer.push({0.0f, 0.0f, NAN}));
+        CHECK(buffer.size() == 0);
+        CHECK(buffer.overrun_count_ == 0);
+    }
+
+    TEST_CASE("empty buffer holds the setpoint") {
+        PvtBuffer buffer;
+        PvtBuffer::Step_t step{};
+        CHECK_FALSE(buffer.update(dt, 1.0f, 0.0f, &step));
+        CHECK_FALSE(buffer.is_active());
+    }
+
+    TEST_CASE("cubic is reproduced exactly") {
+        // Points every 1 ms (8 control periods) with a segment that is not a
+        // multiple of the control period
+        PvtBuffer buffer;
+        std::vector<float> times = {0.001f, 0.002f, 0.003f, 0.0047f, 0.006f, 0.007f};
+        float t_prev = 0.0f;
+        for (float t : times) {
+            REQUIRE(buffer.push({cubic_pos(t), cubic_vel(t), t - t_prev}));
+            t_prev = t;
+        }
+
+        // The first point starts from the current setpoint, which here is
+        // on the cubic as well.
+        float pos = cubic_pos(0.0f);
+        float vel = cubic_vel(0.0f);
+        PvtBuffer::Step_t step{};
+        for (size_t i = 1; (float)i * dt < times.back() - 0.5f * dt; ++i) {
+            REQUIRE(buffer.update(dt, pos, vel, &step));
+            float t = (float)i * dt;
+            CHECK(step.Y == doctest::Approx(cubic_pos(t)).epsilon(1e-5));
+            CHECK(step.Yd == doctest::Approx(cubic_vel(t)).epsilon(1e-3));
+            CHECK(step.Ydd == doctest::Approx(cubic_acc(t)).epsilon(2e-2));
+            pos = step.Y;
+            vel = step.Yd;
+        }
+        CHECK(buffer.underrun_count_ == 0);
+    }
+
+    TEST_CASE("continuity at segment boundaries") {
+        // Sine wave sampled at 1 kHz
+        PvtBuffer buffer;
+        const float w = 2.0f * (float)M_PI * 5.0f;
+        for (size_t i = 1; i <= 50; ++i) {
+            float t = (float)i * 0.001f;
+            REQUIRE(buffer.push({std::sin(w * t), w * std::cos(w * t), 0.001f}));
+        }
+
+        float pos = 0.0f;
+        float vel = w;
+        PvtBuffer::Step_t step{};
+        for (size_t i = 0; i < 49 * 8; ++i) {
+            REQUIRE(buffer.update(dt, pos, vel, &step));
+            CHECK(std::abs(step.Y - pos) <= std::abs(w) * dt * 1.01f);
+            CHECK(std::abs(step.Yd - vel) <= w * w * dt * 1.5f);
+            pos = step.Y;
+            vel = step.Yd;
+        }
+    }
+
+    TEST_CASE("underrun") {
+        PvtBuffer buffer;
+        PvtBuffer::Step_t step{};
+
+        // Moving point followed by an empty buffer
+        REQUIRE(buffer.push({0.01f, 10.0f, 0.001f}));
+        for (size_t i = 0; i < 7; ++i) {
+            REQUIRE(buffer.update(dt, 0.0f, 10.0f, &step));
+        }
+        CHECK(buffer.underrun_count_ == 0);
+        REQUIRE(buffer.update(dt, step.Y, step.Yd, &step));
+        CHECK(buffer.underrun_count_ == 1);
+        CHECK(step.Y == 0.01f);
+        CHECK(step.Yd == 0.0f);
+        CHECK_FALSE(buffer.is_active());
+        CHECK_FALSE(buffer.update(dt, step.Y, step.Yd, &step));
+        CHECK(buffer.underrun_count_ == 1);
+
+        // A stream that ends at standstill is not an underrun
+        REQUIRE(buffer.push({0.02f, 0.0f, 0.001f}));
+        for (size_t i = 0; i < 8; ++i) {
+            REQUIRE(buffer.update(dt, step.Y, step.Yd, &step));
+        }
+        CHECK(step.Y == 0.02f);
+        CHECK(buffer.underrun_count_ == 1);
+    }
+
+    TEST_CASE("arrival jitter does not affect the output") {
+        // Same points, once pushed all at the start and once pushed just in
+        // time with irregular gaps
+        PvtBuffer buffer_a, buffer_b;
+        std::vector<PvtBuffer::Point_t> points;
+        for (size_t i = 1; i <= 20; ++i) {
+            float t = (float)i * 0.002f;
+            points.push_back({cubic_pos(t), cubic_vel(t), 0.002f});
+        }
+        for (auto& p : points) {
+            REQUIRE(buffer_a.push(p));
+        }
+
+        size_t next_b = 0;
+        REQUIRE(buffer_b.push(points[next_b++]));
+        REQUIRE(buffer_b.push(points[next_b++]));
+
+        float pos_a = cubic_pos(0.0f), vel_a = cubic_vel(0.0f);
+        float pos_b = pos_a, vel_b = vel_a;
+        for (size_t i = 0; i < 19 * 16; ++i) {
+            // Top up buffer b at irregular intervals, keeping at least one
+            // point queued
+            if ((i % 7 == 0 || buffer_b.size() == 0) && next_b < points.size()) {
+                REQUIRE(buffer_b.push(points[next_b++]));
+            }
+            PvtBuffer::Step_t step_a, step_b;
+            REQUIRE(buffer_a.update(dt, pos_a, vel_a, &step_a));
+            REQUIRE(buffer_b.update(dt, pos_b, vel_b, &step_b));
+            CHECK(step_a.Y == step_b.Y);
+            CHECK(step_a.Yd == step_b.Yd);
+            pos_a = step_a.Y; vel_a = step_a.Yd;
+            pos_b = step_b.Y; vel_b = step_b.Yd;
+        }
+        CHECK(buffer_a.underrun_count_ == 0);
+        CHECK(buffer_b.underrun_count_ == 0);
+    }
+
+    TEST_CASE("clear") {
+        PvtBuffer buffer;
+        PvtBuffer::Step_t step{};
+        for (size_t i = 1; i <= 10; ++i) {
+            REQUIRE(buffer.push({0.001f * (float)i, 1.0f, 0.001f}));
+        }
+        REQUIRE(buffer.update(dt, 0.0f, 1.0f, &step));
+        buffer.clear();
+        REQUIRE(buffer.push({5.0f, 0.0f, 0.01f})); // pushed after the clear, must be kept
+        REQUIRE(buffer.update(dt, step.Y, step.Yd, &step));
+        CHECK(buffer.size() == 0);
+        CHECK(step.Y > 0.0f);
+        CHECK(step.Y < 0.01f);
+        CHECK(buffer.underrun_count_ == 0);
+    }
+
+    TEST_CASE("index wrap-around") {
+        PvtBuffer buffer;
+        PvtBuffer::Step_t step{};
+        float pos = 0.0f;
+        for (size_t i = 0; i < 10 * PvtBuffer::kCapacity; ++i) {
+            REQUIRE(buffer.push({pos + 0.001f, 1.0f, 0.001f}));
+            for (size_t j = 0; j < 8; ++j) {
+                REQUIRE(buffer.update(dt, pos, 1.0f, &step));
+            }
+            pos = step.Y;
+        }
+        CHECK(pos == doctest::Approx(0.001f * 10 * PvtBuffer::kCapacity).epsilon(1e-4));
+    }
+}
@@ -0,0 +1,167 @@
+#include <doctest.h>
+#include <algorithm>
+#include <cmath>
+
+// The S-curve planner has no dependencies on the rest of the firmware, so the
+// real implementation is compiled into the test.
+#include "MotorControl/scurveTraj.hpp"
+#include "MotorControl/scurveTraj.cpp"
+#include "MotorControl/utils.hpp"
+
+struct Limits {
+    float Vmax;
+    float Amax;
+    float Dmax;
+    float Jmax;
+};
+
+// Runs a trajectory like the controller does, replanning every replan_interval
+// steps from the current setpoint. If new_goal is not NaN, the goal is changed
+// to new_goal at step goal_change_step.
+// Checks that position, velocity and acceleration are continuous and that the
+// velocity, acceleration and jerk limits are respected.
+void run_scurve_test(float goal, float position, float velocity, float accel, Limits lim,
+                     int replan_interval = 10, float new_goal = NAN, int goal_change_step = 0) {
+    const float dt = 0.000125f;
+    const float tol = 1.002f;
+    float t = 0.0f;
+
+    // With non-zero initial acceleration the velocity keeps growing until the
+    // acceleration is ramped down.
+    float Vmax_test = std::max(lim.Vmax, std::abs(velocity + accel * std::abs(accel) / (2.0f * lim.Jmax)));
+    float Amax_test = std::max({lim.Amax, lim.Dmax, std::abs(accel)});
+
+    SCurveTrajectory traj{};
+    int replan_counter = 0;
+    int step_count = 0;
+
+    do {
+        if (!is_nan(new_goal) && step_count == goal_change_step) {
+            goal = new_goal;
+            replan_counter = 0;
+        }
+        if (replan_counter <= 0) {
+            REQUIRE(traj.planSCurve(goal, position, velocity, accel, lim.Vmax, lim.Amax, lim.Dmax, lim.Jmax));
+            t = 0.0f;
+            replan_counter = replan_interval;
+        } else {
+            replan_counter--;
+        }
+
+        SCurveTrajectory::Step_t step = traj.eval(t);
+        t += dt;
+        step_count++;
+
+        // Limits
+        CHECK(std::abs(step.Yd) <= Vmax_test * tol);
+        CHECK(std::abs(step.Ydd) <= Amax_test * tol);
+
+        // Continuity (the setpoint at the start of a new plan must also be
+        // continuous with the previous plan)
+        CHECK(std::abs(step.Ydd - accel) <= lim.Jmax * dt * tol + 1e-4f);
+        CHECK(std::abs(step.Yd - velocity) <= Amax_test * dt * tol + 1e-5f);
+        CHECK(std::abs(step.Y - position) <= Vmax_test * dt * tol + 1e-5f);
+
+        position = step.Y;
+        velocity = step.Yd;
+        accel = step.Ydd;
+    } while (t <= traj.Tf_ && step_count < 1000000);
+    CHECK(step_count < 1000000);
+
+    // One more step after the end of the trajectory must land on the goal
+    SCurveTrajectory::Step_t final_step = traj.eval(t);
+    CHECK(std::abs(final_step.Y - position) <= lim.Vmax * dt);
+    CHECK(std::abs(velocity) <= lim.Dmax * dt * tol + 1e-4f);
+    CHECK(std::abs(accel) <= lim.Jmax * dt * tol + 1e-4f);
+    CHECK(final_step.Y == goal);
+    CHECK(final_step.Yd == 0.0f);
+    CHECK(final_step.Ydd == 0.0f);
+}
+
+// Checks that the analytical segments of a single plan join up.
+void check_segment_continuity(const SCurveTrajectory& traj, Limits lim) {
+    SCurveTrajectory t = traj;
+    for (size_t i = 1; i < 7; ++i) {
+        SCurveTrajectory::Step_t end = integrate(t.start_[i - 1], t.J_[i - 1], t.T_[i - 1]);
+        CHECK(end.Y == doctest::Approx(t.start_[i].Y).epsilon(1e-4));
+        CHECK(end.Yd == doctest::Approx(t.start_[i].Yd).epsilon(1e-3).scale(lim.Vmax));
+        CHECK(end.Ydd == doctest::Approx(t.start_[i].Ydd).epsilon(1e-3).scale(lim.Amax));
+    }
+    for (size_t i = 0; i < 7; ++i) {
+        CHECK(t.T_[i] >= 0.0f);
+        CHECK(std::abs(t.J_[i]) <= lim.Jmax);
+    }
+}
+
+TEST_SUITE("S-Curve Trajectory Planner") {
+    const Limits limits = {10.0f, 20.0f, 20.0f, 400.0f};
+    const Limits asym_limits = {10.0f, 30.0f, 15.0f, 400.0f};
+
+    TEST_CASE("segments are continuous") {
+        SCurveTrajectory traj{};
+
+        // long move with coast phase
+        REQUIRE(traj.planSCurve(20.0f, 0.0f, 0.0f, 0.0f, limits.Vmax, limits.Amax, limits.Dmax, limits.Jmax));
+        CHECK(traj.T_[3] > 0.0f);
+        CHECK(traj.Vr_ == doctest::Approx(limits.Vmax));
+        check_segment_continuity(traj, limits);
+
+        // short move without constant acceleration
+        REQUIRE(traj.planSCurve(-0.1f, 0.0f, 0.0f, 0.0f, limits.Vmax, limits.Amax, limits.Dmax, limits.Jmax));
+        CHECK(traj.T_[1] == 0.0f);
+        CHECK(traj.T_[3] == 0.0f);
+        check_segment_continuity(traj, limits);
+
+        // non-zero initial state
+        REQUIRE(traj.planSCurve(5.0f, 1.0f, -4.0f, 10.0f, limits.Vmax, limits.Amax, limits.Dmax, limits.Jmax));
+        check_segment_continuity(traj, limits);
+    }
+
+    TEST_CASE("invalid limits") {
+        SCurveTrajectory traj{};
+        CHECK_FALSE(traj.planSCurve(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f));
+        CHECK_FALSE(traj.planSCurve(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, -1.0f, 1.0f, 1.0f));
+        CHECK_FALSE(traj.planSCurve(1.0f, 0.0f, 0.0f, 0.0f, NAN, 1.0f, 1.0f, 1.0f));
+    }
+
+    TEST_CASE("pos-dir-long") {
+        run_scurve_test(20.0f, 0.0f, 0.0f, 0.0f, limits);
+    }
+    TEST_CASE("neg-dir-long") {
+        run_scurve_test(-20.0f, 0.0f, 0.0f, 0.0f, limits);
+    }
+    TEST_CASE("pos-dir-short") {
+        run_scurve_test(0.05f, 0.0f, 0.0f, 0.0f, limits);
+    }
+    TEST_CASE("neg-dir-short") {
+        run_scurve_test(-0.05f, 0.0f, 0.0f, 0.0f, limits);
+    }
+    TEST_CASE("asymmetric-limits") {
+        run_scurve_test(20.0f, 0.0f, 0.0f, 0.0f, asym_limits);
+        run_scurve_test(-1.0f, 0.0f, 0.0f, 0.0f, asym_limits);
+    }
+    TEST_CASE("initial-velocity-and-acceleration") {
+        run_scurve_test(10.0f, 0.0f, 5.0f, 10.0f, limits);
+        run_scurve_test(10.0f, 0.0f, -5.0f, -10.0f, limits);
+        run_scurve_test(-10.0f, 0.0f, 5.0f, -20.0f, limits);
+    }
+    TEST_CASE("not-enough-braking-distance") {
+        // v^2/(2*a) = 100 / 40 = 2.5 > 1
+        run_scurve_test(1.0f, 0.0f, 10.0f, 0.0f, limits);
+        run_scurve_test(-1.0f, 0.0f, -10.0f, 0.0f, limits);
+    }
+    TEST_CASE("over-speed") {
+        run_scurve_test(10.0f, 0.0f, 15.0f, 0.0f, limits);
+        run_scurve_test(-10.0f, 0.0f, -15.0f, 0.0f, limits);
+    }
+    TEST_CASE("replan-every-step") {
+        run_scurve_test(5.0f, 0.0f, 0.0f, 0.0f, limits, 1);
+    }
+    TEST_CASE("goal-change-mid-move") {
+        // reverse while accelerating, while cruising and while decelerating
+        run_scurve_test(20.0f, 0.0f, 0.0f, 0.0f, limits, 1000000, -5.0f, 1000);
+        run_scurve_test(20.0f, 0.0f, 0.0f, 0.0f, limits, 1000000, -5.0f, 8000);
+        run_scurve_test(20.0f, 0.0f, 0.0f, 0.0f, limits, 1000000, 30.0f, 18000);
+        run_scurve_test(20.0f, 0.0f, 0.0f, 0.0f, limits, 1000000, 15.0f, 18000);
+    }
+}
@@ -0,0 +1,65 @@
+#include <doctest.h>
+#include <cmath>
+
+#include "MotorControl/sincos.hpp"
+
+// Same contents as the CMSIS table
+static float table[513];
+static const bool table_initialized = [] {
+    for (size_t i = 0; i <= 512; ++i) {
+        table[i] = (float)std::sin(2.0 * M_PI * (double)i / 512.0);
+    }
+    return true;
+}();
+
+TEST_SUITE("sincos") {
+    TEST_CASE("lookup accuracy") {
+        REQUIRE(table_initialized);
+        float max_err = 0.0f;
+        for (int i = -200000; i <= 200000; ++i) {
+            double x = (double)i * 1e-4; // about +-3 turns
+            auto [s, c] = fast_sincos((float)x, table);
+            max_err = std::max(max_err, (float)std::abs(s - std::sin((double)(float)x)));
+            max_err = std::max(max_err, (float)std::abs(c - std::cos((double)(float)x)));
+        }
+        CHECK(max_err < 1.9e-5f);
+        CHECK(max_err > 1.0e-5f); // the bound is tight
+
+        // Exact on the table entries and at the wrap-around
+        for (float x : {0.0f, -0.0f, (float)M_PI / 2.0f, -2.0f * (float)M_PI}) {
+            auto [s, c] = fast_sincos(x, table);
+            CHECK(s == doctest::Approx(std::sin(x)).scale(1.0).epsilon(1e-6));
+            CHECK(c == doctest::Approx(std::cos(x)).scale(1.0).epsilon(1e-6));
+        }
+        auto [s, c] = fast_sincos(std::nextafter(0.0f, -1.0f), table);
+        CHECK(s == doctest::Approx(0.0f).scale(1.0).epsilon(1e-6));
+        CHECK(c == doctest::Approx(1.0f).scale(1.0).epsilon(1e-6));
+    }
+
+    TEST_CASE("rotation accuracy") {
+        float max_err = 0.0f;
+        for (int i = 0; i < 1000; ++i) {
+            float x = (float)i * 0.0131f - 6.5f;
+            auto sincos_x = fast_sincos(x, table);
+            for (int j = -100; j <= 100; ++j) {
+                float delta = kMaxSincosRotation * (float)j / 100.0f;
+                auto [s, c] = sincos_rotate(sincos_x, x, delta, table);
+                double y = (double)x + (double)delta;
+                max_err = std::max(max_err, (float)std::abs(s - std::sin(y)));
+                max_err = std::max(max_err, (float)std::abs(c - std::cos(y)));
+            }
+        }
+        CHECK(max_err < 4.1e-5f);
+    }
+
+    TEST_CASE("large rotations fall back to a lookup") {
+        float x = 1.0f;
+        auto sincos_x = fast_sincos(x, table);
+        for (float delta : {0.6f, -1.0f, 3.0f, 100.0f}) {
+            auto [s, c] = sincos_rotate(sincos_x, x, delta, table);
+            auto [s_ref, c_ref] = fast_sincos(x + delta, table);
+            CHECK(s == s_ref);
+            CHECK(c == c_ref);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include <doctest.h>
+
+#include "MotorControl/ssi_biss_frame.hpp"
+
+TEST_SUITE("SsiBissFrame") {
+    // Builds the frame of a BiSS-C encoder that acknowledges for ack_bits
+    // clocks after idle_bits clocks of idle line
+    uint64_t biss_c_frame(uint64_t data, uint32_t data_bits, uint32_t idle_bits, uint32_t ack_bits, bool error = false) {
+        uint64_t checked = (data << 2) | (error ? 0 : 2) | 1;
+        uint64_t payload = (checked << 6) | (~biss_crc6(checked, data_bits + 2) & 0x3f);
+        uint32_t payload_bits = data_bits + 2 + 6;
+        uint64_t frame = 0;
+        uint32_t n = 0;
+        auto push = [&](uint64_t bits, uint32_t count) {
+            frame = (frame << count) | bits;
+            n += count;
+        };
+        push((UINT64_C(1) << idle_bits) - 1, idle_bits);
+        push(0, ack_bits);
+        push(2, 2); // start, CDS
+        push(payload, payload_bits);
+        return (n < 64) ? frame << (64 - n) : frame; // the line is low after the CRC
+    }
+
+    TEST_CASE("crc6") {
+        CHECK(biss_crc6(0, 8) == 0);
+        CHECK(biss_crc6(1, 1) == 0x03);
+        // The CRC of the data followed by its CRC is zero
+        uint64_t data = UINT64_C(0x2b3c4d5e6);
+        uint8_t crc = biss_crc6(data, 34);
+        CHECK(biss_crc6((data << 6) | crc, 40) == 0);
+    }
+
+    TEST_CASE("biss-c") {
+        // 16 bit multi-turn and 24 bit single-turn
+        const uint64_t data = (UINT64_C(0x8123) << 24) | 0xabcdef;
+        uint64_t decoded = 0;
+        for (uint32_t idle = 0; idle <= 2; ++idle) {
+            for (uint32_t ack = 1; ack <= 8; ++ack) {
+                CHECK(decode_biss_c_frame(biss_c_frame(data, 40, idle, ack), 40, &decoded));
+                CHECK(decoded == data);
+            }
+        }
+
+        // 18 bit single-turn
+        CHECK(decode_biss_c_frame(biss_c_frame(0x2f00f, 18, 1, 3), 18, &decoded));
+        CHECK(decoded == 0x2f00f);
+
+        // Any single bit error in the payload (after 1 idle, 2 ack, start
+        // and CDS bits) is detected
+        uint64_t frame = biss_c_frame(data, 40, 1, 2);
+        for (uint32_t i = 64 - 5 - 48; i < 64 - 5; ++i) {
+            CHECK(!decode_biss_c_frame(frame ^ (UINT64_C(1) << i), 40, &decoded));
+        }
+
+        // Error bit, frame longer than 64 bits, no encoder
+        CHECK(!decode_biss_c_frame(biss_c_frame(data, 40, 1, 2, true), 40, &decoded));
+        uint64_t full = biss_c_frame(data, 40, 0, 14);
+        CHECK(decode_biss_c_frame(full, 40, &decoded));
+        CHECK(!decode_biss_c_frame((full >> 1) | (UINT64_C(1) << 63), 40, &decoded));
+        CHECK(!decode_biss_c_frame(~UINT64_C(0), 40, &decoded));
+        CHECK(!decode_biss_c_frame(0, 40, &decoded));
+    }
+
+    TEST_CASE("ssi") {
+        // Leading 1, 20 bits of data, trailing 0
+        uint64_t data = 0xa5f3c;
+        uint64_t frame = (UINT64_C(1) << 63) | (data << (63 - 20));
+        uint64_t decoded = 0;
+        CHECK(decode_ssi_frame(frame, 20, &decoded));
+        CHECK(decoded == data);
+
+        // Line stuck high or low
+        CHECK(!decode_ssi_frame(~UINT64_C(0), 20, &decoded));
+        CHECK(!decode_ssi_frame(0, 20, &decoded));
+        CHECK(!decode_ssi_frame(frame, 41, &decoded));
+    }
+}
@@ -0,0 +1,142 @@
+#include <doctest.h>
+#include <cmath>
+
+#include "MotorControl/svm.hpp"
+
+static const SvmMode all_modes[] = {SVM_MODE_CONTINUOUS, SVM_MODE_DPWM0, SVM_MODE_DPWM1,
+                                    SVM_MODE_DPWM2, SVM_MODE_DPWM_MIN, SVM_MODE_DPWM_MAX};
+static const float max_mod = 0.80f * sqrt3_by_2; // FieldOrientedController::max_mod
+
+// Recovers the alpha-beta reference from the timings. A lower timing means a
+// higher phase voltage, the common mode drops out.
+static void clarke(const float (&t)[3], float* alpha, float* beta) {
+    float mean = (t[0] + t[1] + t[2]) / 3.0f;
+    *alpha = 1.5f * (mean - t[0]);
+    *beta = sqrt3_by_2 * (t[2] - t[1]);
+}
+
+static bool svm(float mod, float angle_deg, SvmMode mode, uint8_t sensed_phases, float (&t)[3]) {
+    float angle = angle_deg * (float)M_PI / 180.0f;
+    auto [tA, tB, tC, valid] = SVM(mod * std::cos(angle), mod * std::sin(angle), mode, sensed_phases);
+    t[0] = tA;
+    t[1] = tB;
+    t[2] = tC;
+    return valid;
+}
+
+static size_t n_clamped(const float (&t)[3]) {
+    size_t n = 0;
+    for (float x : t) {
+        n += (x == 0.0f || x == 1.0f) ? 1 : 0;
+    }
+    return n;
+}
+
+TEST_SUITE("SVM") {
+    TEST_CASE("all modes produce the reference voltage") {
+        for (SvmMode mode : all_modes) {
+            for (uint8_t sensed : {0b000, 0b110}) {
+                for (float mod : {0.05f, 0.3f, max_mod, 0.999f * sqrt3_by_2}) {
+                    for (int deg = 0; deg < 360; ++deg) {
+                        float t[3] = {};
+                        REQUIRE(svm(mod, (float)deg, mode, sensed, t));
+                        float alpha, beta;
+                        clarke(t, &alpha, &beta);
+                        CHECK(alpha == doctest::Approx(mod * std::cos(deg * (float)M_PI / 180.0f)).epsilon(1e-4).scale(1.0));
+                        CHECK(beta == doctest::Approx(mod * std::sin(deg * (float)M_PI / 180.0f)).epsilon(1e-4).scale(1.0));
+                        for (float x : t) {
+                            CHECK(x >= 0.0f);
+                            CHECK(x <= 1.0f);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    TEST_CASE("out of range input is rejected") {
+        for (SvmMode mode : all_modes) {
+            auto [tA, tB, tC, valid] = SVM(0.0f, 0.9f, mode, 0b110);
+            CHECK(!valid);
+        }
+    }
+
+    TEST_CASE("discontinuous modes clamp one phase per period") {
+        for (SvmMode mode : all_modes) {
+            size_t clamped = 0;
+            for (int deg = 0; deg < 360; ++deg) {
+                float t[3] = {};
+                REQUIRE(svm(0.5f, (float)deg + 0.5f, mode, 0, t));
+                clamped += n_clamped(t);
+            }
+            // A third of the phase periods have no switching events
+            CHECK(clamped == (mode == SVM_MODE_CONTINUOUS ? 0 : 360));
+        }
+    }
+
+    TEST_CASE("clamped intervals") {
+        float t[3] = {};
+        for (float deg : {-25.0f, 0.0f, 25.0f}) {
+            REQUIRE(svm(0.5f, deg, SVM_MODE_DPWM1, 0, t));
+            CHECK(t[0] == 0.0f);
+            REQUIRE(svm(0.5f, deg + 180.0f, SVM_MODE_DPWM1, 0, t));
+            CHECK(t[0] == 1.0f);
+        }
+        for (float deg : {5.0f, 30.0f, 55.0f}) {
+            REQUIRE(svm(0.5f, deg, SVM_MODE_DPWM2, 0, t));
+            CHECK(t[0] == 0.0f);
+            REQUIRE(svm(0.5f, -deg, SVM_MODE_DPWM0, 0, t));
+            CHECK(t[0] == 0.0f);
+        }
+        REQUIRE(svm(0.5f, -5.0f, SVM_MODE_DPWM2, 0, t));
+        CHECK(t[0] != 0.0f);
+        REQUIRE(svm(0.5f, 5.0f, SVM_MODE_DPWM0, 0, t));
+        CHECK(t[0] != 0.0f);
+
+        for (int deg = 0; deg < 360; deg += 7) {
+            REQUIRE(svm(0.5f, (float)deg, SVM_MODE_DPWM_MAX, 0, t));
+            CHECK(std::min({t[0], t[1], t[2]}) == 0.0f);
+            REQUIRE(svm(0.5f, (float)deg, SVM_MODE_DPWM_MIN, 0, t));
+            CHECK(std::max({t[0], t[1], t[2]}) == 1.0f);
+        }
+    }
+
+    TEST_CASE("sensed phases keep their current sampling window") {
+        for (SvmMode mode : all_modes) {
+            for (float mod : {0.05f, 0.3f, 0.6f, max_mod}) {
+                for (int deg = 0; deg < 360; ++deg) {
+                    float t[3] = {};
+                    float t_cont[3] = {};
+                    REQUIRE(svm(mod, (float)deg, mode, 0b110, t));
+                    REQUIRE(svm(mod, (float)deg, SVM_MODE_CONTINUOUS, 0, t_cont));
+                    for (size_t i : {1, 2}) {
+                        CHECK(t[i] > 0.0f);
+                        CHECK(t[i] >= std::min(kSvmMinSenseWindow, t_cont[i]));
+                    }
+                }
+            }
+        }
+    }
+
+    TEST_CASE("the DC current does not depend on the mode") {
+        for (SvmMode mode : all_modes) {
+            for (int deg = 0; deg < 360; deg += 3) {
+                float t[3] = {};
+                float t_cont[3] = {};
+                REQUIRE(svm(0.6f, (float)deg, mode, 0b110, t));
+                REQUIRE(svm(0.6f, (float)deg, SVM_MODE_CONTINUOUS, 0, t_cont));
+                // Any balanced set of phase currents
+                float phase = 0.1f * (float)deg;
+                float I[3] = {std::cos(phase), std::cos(phase - 2.0944f), 0.0f};
+                I[2] = -I[0] - I[1];
+                float ibus = 0.0f;
+                float ibus_cont = 0.0f;
+                for (size_t i = 0; i < 3; ++i) {
+                    ibus += (1.0f - t[i]) * I[i];
+                    ibus_cont += (1.0f - t_cont[i]) * I[i];
+                }
+                CHECK(ibus == doctest::Approx(ibus_cont).scale(1.0).epsilon(1e-5));
+            }
+        }
+    }
+}
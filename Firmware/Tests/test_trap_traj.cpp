@@ -5,6 +5,7 @@
 #include <iostream>
 #include <random>
 
+#include "MotorControl/position.hpp"
 #include "MotorControl/utils.hpp"
 
 // TODO: This is currently a copy-paste of the real code due to non-trivial
@@ -13,18 +14,20 @@
 class TrapezoidalTrajectory {
 public:
     struct Step_t {
-        float Y;
+        Position Y;
         float Yd;
         float Ydd;
     };
 
     explicit TrapezoidalTrajectory();
-    bool planTrapezoidal(float Xf, float Xi, float Vi,
+    bool planTrapezoidal(const Position& Xf, const Position& Xi, float Vi,
                          float Vmax, float Amax, float Dmax);
+    bool planTrapezoidal(const Position& Xf, const Position& Xi, float Vi,
+                         float Vmax, float Amax, float Dmax, float Tmin);
     Step_t eval(float t);
 
-    float Xi_;
-    float Xf_;
+    Position Xi_;
+    Position Xf_;
     float Vi_;
 
     float Ar_;
@@ -36,7 +39,7 @@ public:
     float Td_;
     float Tf_;
 
-    float yAccel_;
+    float yAccel_; // displacement from Xi_ at the end of the accel phase
 
     float t_;
 };
@@ -55,10 +58,13 @@ float sign_hard(float val) {
 // s                          Direction (sign) of the trajectory
 // Vmax, Amax, Dmax and jmax  Kinematic bounds
 // Ar, Dr and Vr              Reached values of acceleration and velocity
+//
+// The profile is planned and evaluated as a displacement from Xi, so that it
+// has the same resolution at any distance from zero.
 
 TrapezoidalTrajectory::TrapezoidalTrajectory() {}
 
-bool TrapezoidalTrajectory::planTrapezoidal(float Xf, float Xi, float Vi,
+bool TrapezoidalTrajectory::planTrapezoidal(const Position& Xf, const Position& Xi, float Vi,
                                             float Vmax, float Amax, float Dmax) {
     float dX = Xf - Xi;  // Distance to travel
     float stop_dist = (Vi * Vi) / (2.0f * Dmax); // Minimum stopping distance
@@ -100,7 +106,35 @@ bool TrapezoidalTrajectory::planTrapezoidal(float Xf, float Xi, float Vi,
     Xi_ = Xi;
     Xf_ = Xf;
     Vi_ = Vi;
-    yAccel_ = Xi + Vi*Ta_ + 0.5f*Ar_*SQ(Ta_); // pos at end of accel phase
+    yAccel_ = Vi*Ta_ + 0.5f*Ar_*SQ(Ta_); // displacement at end of accel phase
+
+    return true;
+}
+
+bool TrapezoidalTrajectory::planTrapezoidal(const Position& Xf, const Position& Xi, float Vi,
+                                            float Vmax, float Amax, float Dmax, float Tmin) {
+    planTrapezoidal(Xf, Xi, Vi, Vmax, Amax, Dmax);
+    if (!(Tf_ < Tmin) || Vi != 0.0f) {
+        return true;
+    }
+
+    // From rest, Tf is continuous and monotonically decreasing in the scale
+    // factor, so we can bisect. k_lo always gives Tf >= Tmin.
+    float k_lo = 0.0f;
+    float k_hi = 1.0f;
+    for (size_t i = 0; i < 24; ++i) {
+        float k = 0.5f * (k_lo + k_hi);
+        planTrapezoidal(Xf, Xi, Vi, k * Vmax, k * Amax, k * Dmax);
+        if (Tf_ < Tmin) {
+            k_hi = k;
+        } else {
+            k_lo = k;
+        }
+    }
+    // k_lo is still zero if even the slowest factor that was tried is too fast
+    // (e.g. zero distance)
+    float k = (k_lo > 0.0f) ? k_lo : k_hi;
+    planTrapezoidal(Xf, Xi, Vi, k * Vmax, k * Amax, k * Dmax);
 
     return true;
 }
@@ -112,11 +146,11 @@ TrapezoidalTrajectory::Step_t TrapezoidalTrajectory::eval(float t) {
         trajStep.Yd  = Vi_;
         trajStep.Ydd = 0.0f;
     } else if (t < Ta_) {  // Accelerating
-        trajStep.Y   = Xi_ + Vi_*t + 0.5f*Ar_*SQ(t);
+        trajStep.Y   = Xi_ + (Vi_*t + 0.5f*Ar_*SQ(t));
         trajStep.Yd  = Vi_ + Ar_*t;
         trajStep.Ydd = Ar_;
     } else if (t < Ta_ + Tv_) {  // Coasting
-        trajStep.Y   = yAccel_ + Vr_*(t - Ta_);
+        trajStep.Y   = Xi_ + (yAccel_ + Vr_*(t - Ta_));
         trajStep.Yd  = Vr_;
         trajStep.Ydd = 0.0f;
     } else if (t < Tf_) {  // Deceleration
@@ -178,8 +212,8 @@ void run_trajectory_test(float goal, float position, float velocity, float Vmax,
         // Check if velocity within bounds
         CHECK(step.Yd >= -Vmax_test);
         CHECK(step.Yd <= Vmax_test);
-        CHECK((step.Y - position) / dt >= -Vmax_test * 1.002f);
-        CHECK((step.Y - position) / dt <= Vmax_test * 1.002f);
+        CHECK((step.Y.to_float() - position) / dt >= -Vmax_test * 1.002f);
+        CHECK((step.Y.to_float() - position) / dt <= Vmax_test * 1.002f);
         velocity = step.Yd;
 
         // Check if position is making progress
@@ -190,7 +224,7 @@ void run_trajectory_test(float goal, float position, float velocity, float Vmax,
         //if ((replan_counter < replan_interval - 2) && (t <= traj.Tf_)) {
         //    CHECK(std::abs(step.Y - goal) < std::abs(position - goal));
         //}
-        position = step.Y;
+        position = step.Y.to_float();
 
     } while (t <= traj.Tf_);
 
@@ -232,4 +266,81 @@ TEST_SUITE("Trajectory Planner") {
     TEST_CASE("pos-dir-over-speed") {
         run_trajectory_test(8192.0f, -8192.0f, 40000.0f, 27712.0f, 22288.0f, 22288.0f);
     }
+
+    // Two axes with different distances must finish at the same time
+    TEST_CASE("synchronized-moves") {
+        float Vmax = 2.0f, Amax = 5.0f, Dmax = 4.0f;
+        struct { float goal; float pos; float vel; } moves[] = {
+            {10.0f, 0.0f, 0.0f},  // slowest move
+            {1.0f, 0.0f, 0.0f},   // short move, triangle if not stretched
+            {-3.0f, 0.0f, 0.0f},
+            {4.0f, 0.5f, 1.5f},   // moving start, not stretched
+            {-2.0f, 0.0f, 1.0f},  // must reverse, not stretched
+            {0.0f, 0.0f, 0.0f},   // zero distance cannot be stretched
+        };
+
+        TrapezoidalTrajectory slow{};
+        slow.planTrapezoidal(moves[0].goal, moves[0].pos, moves[0].vel, Vmax, Amax, Dmax);
+        float Tf = slow.Tf_;
+
+        // A shorter minimum time must not change the fastest plan
+        TrapezoidalTrajectory same{};
+        same.planTrapezoidal(moves[0].goal, moves[0].pos, moves[0].vel, Vmax, Amax, Dmax, 0.5f * Tf);
+        CHECK(same.Tf_ == Tf);
+
+        for (auto& move : moves) {
+            TrapezoidalTrajectory traj{};
+            CHECK(traj.planTrapezoidal(move.goal, move.pos, move.vel, Vmax, Amax, Dmax, Tf));
+            if (move.goal == move.pos && move.vel == 0.0f) {
+                CHECK(traj.Tf_ == 0.0f);
+                continue;
+            }
+            if (move.vel == 0.0f) {
+                CHECK(traj.Tf_ >= Tf);
+                CHECK(traj.Tf_ == doctest::Approx(Tf).epsilon(1e-4));
+            } else {
+                // Moves with an initial velocity are planned as fast as possible
+                TrapezoidalTrajectory fastest{};
+                fastest.planTrapezoidal(move.goal, move.pos, move.vel, Vmax, Amax, Dmax);
+                CHECK(traj.Tf_ == fastest.Tf_);
+                CHECK(traj.Tf_ < Tf);
+            }
+            CHECK(std::abs(traj.Vr_) <= Vmax);
+
+            // Integrate the velocity to check that the profile is consistent
+            float dt = 0.000125f;
+            float pos = move.pos;
+            for (float t = 0.0f; t < traj.Tf_; t += dt) {
+                TrapezoidalTrajectory::Step_t step = traj.eval(t + 0.5f * dt);
+                CHECK(std::abs(step.Yd) <= std::max(Vmax, std::abs(move.vel)));
+                pos += step.Yd * dt;
+            }
+            CHECK(pos == doctest::Approx(move.goal).epsilon(1e-3));
+            CHECK(traj.eval(traj.Tf_).Y == move.goal);
+
+            // Moves from standstill are scaled copies of the slowest move,
+            // so the axes move along a straight line
+            if (move.vel == 0.0f && move.pos == 0.0f) {
+                float ratio = move.goal / moves[0].goal;
+                for (float t = 0.0f; t < Tf; t += 0.01f) {
+                    CHECK(traj.eval(t).Y.to_float() == doctest::Approx(ratio * slow.eval(t).Y.to_float()).epsilon(1e-4));
+                }
+            }
+        }
+    }
+
+    // The profile must not depend on the distance from zero
+    TEST_CASE("far-from-zero") {
+        float Vmax = 2.0f, Amax = 5.0f, Dmax = 4.0f;
+        Position origin = Position::from_parts(INT64_C(1) << 40, 0.25f);
+        TrapezoidalTrajectory near{};
+        TrapezoidalTrajectory far{};
+        CHECK(near.planTrapezoidal(3.125f, 0.25f, 0.5f, Vmax, Amax, Dmax));
+        CHECK(far.planTrapezoidal(origin + 2.875f, origin, 0.5f, Vmax, Amax, Dmax));
+        CHECK(far.Tf_ == near.Tf_);
+        for (float t = 0.0f; t < near.Tf_ + 0.1f; t += 0.001f) {
+            CHECK(far.eval(t).Y - origin == near.eval(t).Y - Position{0.25f});
+        }
+        CHECK(far.eval(far.Tf_).Y == origin + 2.875f);
+    }
 }
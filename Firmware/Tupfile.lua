@@ -86,7 +86,9 @@ odrive_firmware_pkg = {
         'MotorControl/oscilloscope.cpp',
         'MotorControl/sensorless_estimator.cpp',
         'MotorControl/trapTraj.cpp',
+        'MotorControl/scurveTraj.cpp',
         'MotorControl/pwm_input.cpp',
+        'MotorControl/control_loop.cpp',
         'MotorControl/main.cpp',
         'Drivers/STM32/stm32_system.cpp',
         'Drivers/STM32/stm32_gpio.cpp',
@@ -407,7 +409,7 @@ end
 python_command = find_python3()
 print('Using python command "'..python_command..'"')
 
--- TODO: use CI to verify that on PRs the enums.py file is consistent with the YAML.
+-- CI verifies that enums.py is consistent with the YAML (see .github/workflows/firmware.yaml).
 -- Note: we currently check this file into source control for two reasons:
 --  - Don't require tup to run in order to use odrivetool from the repo
 --  - On Windows, tup is unhappy with writing outside of the tup directory
@@ -462,3 +464,96 @@ if tup.getconfig('DOCTEST') == 'true' then
     tup.frule{inputs='Tests/bin/*.o', command='g++ %f -o %o', outputs='Tests/test_runner.exe'}
     tup.frule{inputs='Tests/test_runner.exe', command='%f'}
 end
+
+if tup.getconfig('SIMULATOR') == 'true' or tup.getconfig('BENCHMARK') == 'true' then
+    -- Host build of the MotorControl sources against a simulated board (see Simulator/).
+    -- Simulator/ must come first so that its board.h shadows the one of the real board.
+    SIM_CFLAGS = '-O2 -g -ISimulator -I. -IMotorControl -Ifibre-cpp/include -IBoard/v3/Inc'..
+                 ' -IThirdParty/FreeRTOS/Source/portable/GCC/ARM_CM4F -IThirdParty/STM32F4xx_HAL_Driver/Inc'..
+                 ' -IThirdParty/FreeRTOS/Source/include -IThirdParty/FreeRTOS/Source/CMSIS_RTOS'..
+                 ' -IThirdParty/CMSIS/Include -IThirdParty/CMSIS/Device/ST/STM32F4xx/Include'..
+                 ' -DSTM32F405xx -DHW_VERSION_MAJOR=3 -DHW_VERSION_MINOR=6 -DHW_VERSION_VOLTAGE=56'..
+                 ' -DUSE_HAL_DRIVER -DFIBRE_ENABLE_SERVER -DCMSIS_NVIC_VIRTUAL'..
+                 ' -D__weak="__attribute__((weak))" -D__packed="__attribute__((__packed__))"'
+    sim_files = {
+        'MotorControl/utils.cpp',
+        'MotorControl/low_level.cpp',
+        'MotorControl/axis.cpp',
+        'MotorControl/motor.cpp',
+        'MotorControl/thermistor.cpp',
+        'MotorControl/encoder.cpp',
+        'MotorControl/endstop.cpp',
+        'MotorControl/acim_estimator.cpp',
+        'MotorControl/mechanical_brake.cpp',
+        'MotorControl/controller.cpp',
+        'MotorControl/foc.cpp',
+        'MotorControl/open_loop_controller.cpp',
+        'MotorControl/oscilloscope.cpp',
+        'MotorControl/sensorless_estimator.cpp',
+        'MotorControl/trapTraj.cpp',
+        'MotorControl/scurveTraj.cpp',
+        'MotorControl/control_loop.cpp',
+        'Drivers/STM32/stm32_gpio.cpp',
+        'Drivers/STM32/stm32_spi_arbiter.cpp',
+        'Simulator/sim_board.cpp',
+        'Simulator/sim_hal.cpp',
+        'Simulator/sim_os.cpp',
+        'Simulator/motor_plant.cpp',
+        'Simulator/simulator.cpp',
+    }
+    sim_objects = {}
+    for _, src_file in pairs(sim_files) do
+        obj_file = 'Simulator/bin/'..src_file:gsub("/","_"):gsub("%.","")..'.o'
+        sim_objects += obj_file
+        tup.frule{
+            inputs={src_file},
+            extra_inputs = {'autogen/interfaces.hpp', 'autogen/function_stubs.hpp', 'autogen/endpoints.hpp', 'autogen/type_info.hpp'},
+            command='g++ -std=c++17 -c %f '..SIM_CFLAGS..' -o %o',
+            outputs={obj_file}
+        }
+    end
+    for _, src_file in pairs({'MotorControl/arm_sin_f32.c', 'MotorControl/arm_cos_f32.c'}) do
+        obj_file = 'Simulator/bin/'..src_file:gsub("/","_"):gsub("%.","")..'.o'
+        sim_objects += obj_file
+        tup.frule{inputs={src_file}, command='gcc -c %f -w -DARM_MATH_CM4 '..SIM_CFLAGS..' -o %o', outputs={obj_file}}
+    end
+
+    if tup.getconfig('SIMULATOR') == 'true' then
+        tup.frule{inputs={'Simulator/sim_main.cpp'}, command='g++ -std=c++17 -c %f '..SIM_CFLAGS..' -o %o', outputs={'Simulator/bin/sim_main.o'}}
+        tup.frule{inputs={sim_objects, 'Simulator/bin/sim_main.o'}, command='g++ %f -lpthread -o %o', outputs='Simulator/odrive_sim'}
+
+        -- Regression runs. The build fails when the mode sweep deviates from
+        -- the reference trace. After an intended change of the control loop
+        -- copy Simulator/bin/mode_sweep.csv to Simulator/reference/.
+        tup.frule{
+            inputs={'Simulator/odrive_sim'},
+            extra_inputs={'Simulator/reference/mode_sweep.csv'},
+            command='%f --scenario mode_sweep --duration 0.5 --decimation 80 --csv %o --reference Simulator/reference/mode_sweep.csv',
+            outputs={'Simulator/bin/mode_sweep.csv'}
+        }
+        -- The step responses must stay within bounds across the PWM frequency range
+        for _, pwm_frequency in pairs({'8000', '24000', '48000'}) do
+            tup.frule{
+                inputs={'Simulator/odrive_sim'},
+                command='%f --scenario velocity_step --pwm-frequency '..pwm_frequency..' --max-rise-time 0.02 --max-overshoot 10 --max-final-error 0.01 --csv %o',
+                outputs={'Simulator/bin/velocity_step_'..pwm_frequency..'.csv'}
+            }
+            tup.frule{
+                inputs={'Simulator/odrive_sim'},
+                command='%f --scenario position_step --pwm-frequency '..pwm_frequency..' --max-rise-time 0.15 --max-overshoot 5 --max-final-error 0.005 --csv %o',
+                outputs={'Simulator/bin/position_step_'..pwm_frequency..'.csv'}
+            }
+        end
+    end
+
+    if tup.getconfig('BENCHMARK') == 'true' then
+        -- Microbenchmarks of the control loop. Timings are host nanoseconds.
+        -- If BENCHMARK_BASELINE points to the results.json of an earlier run,
+        -- the build fails when a benchmark regressed.
+        tup.frule{inputs={'Benchmarks/control_loop_bench.cpp'}, command='g++ -std=c++17 -c %f '..SIM_CFLAGS..' -o %o', outputs={'Benchmarks/bin/control_loop_bench.o'}}
+        tup.frule{inputs={sim_objects, 'Benchmarks/bin/control_loop_bench.o'}, command='g++ %f -lpthread -o %o', outputs='Benchmarks/control_loop_bench'}
+        baseline = tup.getconfig('BENCHMARK_BASELINE')
+        baseline_arg = (baseline ~= '') and (' --baseline '..baseline) or ''
+        tup.frule{inputs={'Benchmarks/control_loop_bench'}, command='%f --json %o'..baseline_arg, outputs={'Benchmarks/results.json'}}
+    end
+end
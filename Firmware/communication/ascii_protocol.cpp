@@ -142,7 +142,7 @@ void AsciiProtocol::cmd_set_position(char * pStr, bool use_checksum) {
     } else {
         Axis& axis = axes[motor_number];
         axis.controller_.config_.control_mode = Controller::CONTROL_MODE_POSITION_CONTROL;
-        axis.controller_.input_pos_ = pos_setpoint;
+        axis.controller_.write_input_pos(pos_setpoint);
         if (numscan >= 3)
             axis.controller_.input_vel_ = vel_feed_forward;
         if (numscan >= 4)
@@ -168,7 +168,7 @@ void AsciiProtocol::cmd_set_position_wl(char * pStr, bool use_checksum) {
     } else {
         Axis& axis = axes[motor_number];
         axis.controller_.config_.control_mode = Controller::CONTROL_MODE_POSITION_CONTROL;
-        axis.controller_.input_pos_ = pos_setpoint;
+        axis.controller_.write_input_pos(pos_setpoint);
         if (numscan >= 3)
             axis.controller_.config_.vel_limit = vel_limit;
         if (numscan >= 4)
@@ -262,7 +262,7 @@ void AsciiProtocol::cmd_set_trapezoid_trajectory(char* pStr, bool use_checksum)
         Axis& axis = axes[motor_number];
         axis.controller_.config_.input_mode = Controller::INPUT_MODE_TRAP_TRAJ;
         axis.controller_.config_.control_mode = Controller::CONTROL_MODE_POSITION_CONTROL;
-        axis.controller_.input_pos_ = goal_point;
+        axis.controller_.write_input_pos(goal_point);
         axis.controller_.input_pos_updated();
         axis.watchdog_feed();
     }
@@ -282,7 +282,7 @@ void AsciiProtocol::cmd_get_feedback(char * pStr, bool use_checksum) {
     } else {
         Axis& axis = axes[motor_number];
         respond(use_checksum, "%f %f",
-                (double)axis.encoder_.pos_estimate_.any().value_or(0.0f),
+                (double)axis.encoder_.pos_estimate_.any().value_or(0.0f).to_float(),
                 (double)axis.encoder_.vel_estimate_.any().value_or(0.0f));
     }
 }
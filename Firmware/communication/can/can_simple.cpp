@@ -158,6 +158,12 @@ void CANSimple::do_command(Axis& axis, const can_Message_t& msg) {
         case MSG_GET_CONTROLLER_ERROR:
             get_controller_error_callback(axis);
             break;
+        case MSG_PUSH_PVT_POINT:
+            push_pvt_point_callback(axis, msg);
+            break;
+        case MSG_SET_INPUT_POS_TIMED:
+            set_input_pos_timed_callback(axis, msg);
+            break;
         default:
             break;
     }
@@ -238,8 +244,8 @@ bool CANSimple::get_encoder_estimates_callback(const Axis& axis) {
     txmsg.isExt = axis.config_.can.is_extended;
     txmsg.len = 8;
 
-    can_setSignal<float>(txmsg, axis.controller_.pos_estimate_linear_src_.any().value_or(0.0f), 0, 32, true);
-    can_setSignal<float>(txmsg, axis.controller_.vel_estimate_src_.any().value_or(0.0f), 32, 32, true);
+    can_setSignal<float>(txmsg, axis.wiring_->pos_estimate_linear_src.any().value_or(0.0f).to_float(), 0, 32, true);
+    can_setSignal<float>(txmsg, axis.wiring_->vel_estimate_src.any().value_or(0.0f), 32, 32, true);
 
     return canbus_->send_message(txmsg);
 }
@@ -266,7 +272,7 @@ bool CANSimple::get_encoder_count_callback(const Axis& axis) {
     txmsg.isExt = axis.config_.can.is_extended;
     txmsg.len = 8;
 
-    can_setSignal<int32_t>(txmsg, axis.encoder_.shadow_count_, 0, 32, true);
+    can_setSignal<int32_t>(txmsg, (int32_t)axis.encoder_.shadow_count_, 0, 32, true);
     can_setSignal<int32_t>(txmsg, axis.encoder_.count_in_cpr_, 32, 32, true);
     return canbus_->send_message(txmsg);
 }
@@ -329,6 +335,17 @@ void CANSimple::set_vel_gains_callback(Axis& axis, const can_Message_t& msg) {
     axis.controller_.config_.vel_integrator_gain = can_getSignal<float>(msg, 32, 32, true);
 }
 
+void CANSimple::push_pvt_point_callback(Axis& axis, const can_Message_t& msg) {
+    axis.controller_.push_pvt_point(can_getSignal<float>(msg, 0, 32, true),
+                                    can_getSignal<int16_t>(msg, 32, 16, true, 0.001f, 0),
+                                    can_getSignal<uint16_t>(msg, 48, 16, true, 0.00001f, 0));
+}
+
+void CANSimple::set_input_pos_timed_callback(Axis& axis, const can_Message_t& msg) {
+    axis.controller_.move_to_pos_timed(can_getSignal<float>(msg, 0, 32, true),
+                                       can_getSignal<float>(msg, 32, 32, true));
+}
+
 bool CANSimple::get_iq_callback(const Axis& axis) {
     can_Message_t txmsg;
     txmsg.id = axis.config_.can.node_id << NUM_CMD_ID_BITS;
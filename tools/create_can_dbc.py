@@ -177,6 +177,21 @@ for axisID in range(0, 8):
         0x01D, "Get_Controller_Error", 8, [controllerError], senders=[newNode.name]
     )
 
+    # 0x01E - Push PVT Point
+    pvtPos = can.Signal("PVT_Pos", 0, 32, is_float=True, receivers=[newNode.name], unit='rev')
+    pvtVel = can.Signal("PVT_Vel", 32, 16, is_signed=True, scale=0.001, receivers=[newNode.name], unit='rev/s')
+    pvtDt = can.Signal("PVT_Dt", 48, 16, scale=0.00001, receivers=[newNode.name], unit='s')
+    pushPvtPointMsg = can.Message(
+        0x01E, "Push_PVT_Point", 8, [pvtPos, pvtVel, pvtDt], senders=['Master']
+    )
+
+    # 0x01F - Set Input Pos Timed
+    timedInputPos = can.Signal("Input_Pos", 0, 32, is_float=True, receivers=[newNode.name], unit='rev')
+    moveTime = can.Signal("Move_Time", 32, 32, is_float=True, receivers=[newNode.name], unit='s')
+    setInputPosTimedMsg = can.Message(
+        0x01F, "Set_Input_Pos_Timed", 8, [timedInputPos, moveTime], senders=['Master']
+    )
+
     axisMsgs = [
         heartbeatMsg,
         motorErrorMsg,
@@ -205,6 +220,8 @@ for axisID in range(0, 8):
         setVelGainsMsg,
         getADCVoltageMsg,
         controllerErrorMsg,
+        pushPvtPointMsg,
+        setInputPosTimedMsg,
     ]
 
     masterMsgs = [
@@ -46,6 +46,7 @@ AXIS_STATE_ENCODER_DIR_FIND              = 10
 AXIS_STATE_HOMING                        = 11
 AXIS_STATE_ENCODER_HALL_POLARITY_CALIBRATION = 12
 AXIS_STATE_ENCODER_HALL_PHASE_CALIBRATION = 13
+AXIS_STATE_ENCODER_ERROR_MAP_CALIBRATION = 14
 
 # ODrive.Encoder.Mode
 ENCODER_MODE_INCREMENTAL                 = 0
@@ -56,6 +57,13 @@ ENCODER_MODE_SPI_ABS_AMS                 = 257
 ENCODER_MODE_SPI_ABS_AEAT                = 258
 ENCODER_MODE_SPI_ABS_RLS                 = 259
 ENCODER_MODE_SPI_ABS_MA732               = 260
+ENCODER_MODE_SPI_ABS_SSI                 = 261
+ENCODER_MODE_SPI_ABS_BISS_C              = 262
+
+# ODrive.Encoder.Estimator
+ESTIMATOR_PLL                            = 0
+ESTIMATOR_KALMAN                         = 1
+ESTIMATOR_EDGE_TIMING                    = 2
 
 # ODrive.Controller.ControlMode
 CONTROL_MODE_VOLTAGE_CONTROL             = 0
@@ -63,6 +71,12 @@ CONTROL_MODE_TORQUE_CONTROL              = 1
 CONTROL_MODE_VELOCITY_CONTROL            = 2
 CONTROL_MODE_POSITION_CONTROL            = 3
 
+# ODrive.Controller.FilterType
+FILTER_TYPE_NONE                         = 0
+FILTER_TYPE_LOW_PASS                     = 1
+FILTER_TYPE_NOTCH                        = 2
+FILTER_TYPE_LEAD_LAG                     = 3
+
 # ODrive.Controller.InputMode
 INPUT_MODE_INACTIVE                      = 0
 INPUT_MODE_PASSTHROUGH                   = 1
@@ -73,6 +87,20 @@ INPUT_MODE_TRAP_TRAJ                     = 5
 INPUT_MODE_TORQUE_RAMP                   = 6
 INPUT_MODE_MIRROR                        = 7
 INPUT_MODE_TUNING                        = 8
+INPUT_MODE_SCURVE_TRAJ                   = 9
+INPUT_MODE_PVT                           = 10
+
+# ODrive.Motor.CurrentControlLaw
+CURRENT_CONTROL_LAW_PI                   = 0
+CURRENT_CONTROL_LAW_DEADBEAT             = 1
+
+# ODrive.Motor.ModulationMode
+MODULATION_MODE_CONTINUOUS               = 0
+MODULATION_MODE_DPWM0                    = 1
+MODULATION_MODE_DPWM1                    = 2
+MODULATION_MODE_DPWM2                    = 3
+MODULATION_MODE_DPWM_MIN                 = 4
+MODULATION_MODE_DPWM_MAX                 = 5
 
 # ODrive.Motor.MotorType
 MOTOR_TYPE_HIGH_CURRENT                  = 0
@@ -149,6 +177,7 @@ CONTROLLER_ERROR_INVALID_LOAD_ENCODER    = 0x00000010
 CONTROLLER_ERROR_INVALID_ESTIMATE        = 0x00000020
 CONTROLLER_ERROR_INVALID_CIRCULAR_RANGE  = 0x00000040
 CONTROLLER_ERROR_SPINOUT_DETECTED        = 0x00000080
+CONTROLLER_ERROR_INVALID_TRAJECTORY_LIMITS = 0x00000100
 
 # ODrive.Encoder.Error
 ENCODER_ERROR_NONE                       = 0x00000000
@@ -205,6 +234,7 @@ class AxisState(enum.Enum):
     HOMING                                   = 11
     ENCODER_HALL_POLARITY_CALIBRATION        = 12
     ENCODER_HALL_PHASE_CALIBRATION           = 13
+    ENCODER_ERROR_MAP_CALIBRATION            = 14
 class EncoderMode(enum.Enum):
     INCREMENTAL                              = 0
     HALL                                     = 1
@@ -214,11 +244,22 @@ class EncoderMode(enum.Enum):
     SPI_ABS_AEAT                             = 258
     SPI_ABS_RLS                              = 259
     SPI_ABS_MA732                            = 260
+    SPI_ABS_SSI                              = 261
+    SPI_ABS_BISS_C                           = 262
+class Estimator(enum.Enum):
+    PLL                                      = 0
+    KALMAN                                   = 1
+    EDGE_TIMING                              = 2
 class ControlMode(enum.Enum):
     VOLTAGE_CONTROL                          = 0
     TORQUE_CONTROL                           = 1
     VELOCITY_CONTROL                         = 2
     POSITION_CONTROL                         = 3
+class FilterType(enum.Enum):
+    NONE                                     = 0
+    LOW_PASS                                 = 1
+    NOTCH                                    = 2
+    LEAD_LAG                                 = 3
 class InputMode(enum.Enum):
     INACTIVE                                 = 0
     PASSTHROUGH                              = 1
@@ -229,6 +270,18 @@ class InputMode(enum.Enum):
     TORQUE_RAMP                              = 6
     MIRROR                                   = 7
     TUNING                                   = 8
+    SCURVE_TRAJ                              = 9
+    PVT                                      = 10
+class CurrentControlLaw(enum.Enum):
+    PI                                       = 0
+    DEADBEAT                                 = 1
+class ModulationMode(enum.Enum):
+    CONTINUOUS                               = 0
+    DPWM0                                    = 1
+    DPWM1                                    = 2
+    DPWM2                                    = 3
+    DPWM_MIN                                 = 4
+    DPWM_MAX                                 = 5
 class MotorType(enum.Enum):
     HIGH_CURRENT                             = 0
     GIMBAL                                   = 2
@@ -299,6 +352,7 @@ class ControllerError(enum.IntFlag):
     INVALID_ESTIMATE                         = 0x00000020
     INVALID_CIRCULAR_RANGE                   = 0x00000040
     SPINOUT_DETECTED                         = 0x00000080
+    INVALID_TRAJECTORY_LIMITS                = 0x00000100
 class EncoderError(enum.IntFlag):
     NONE                                     = 0x00000000
     UNSTABLE_GAIN                            = 0x00000001